@@ -3,6 +3,8 @@
 #include "gpio.h"
 #include "stm32f7_tests.h"
 #include "os_tests.h"
+#include "os/mem_alloc.h"
+#include "os/sched_trace.h"
 #include "os/task.h"
 #include "system.h"
 #include "interrupt.h"
@@ -18,8 +20,6 @@ void task1_func(uint32_t param)
 	while(1) {
 		dbprintf("Task 1 called! %#lx\n", param);
 		sleep(MSECS(500));
-		set_next_task(&task2_task);
-		sched_yield();
 	}
 }
 
@@ -28,8 +28,6 @@ void task2_func(uint32_t param)
 	while(1) {
 		dbprintf("Task 2 called! %#lx\n", param);
 		sleep(MSECS(500));
-		set_next_task(&task1_task);
-		sched_yield();
 	}
 }
 
@@ -39,6 +37,7 @@ int main(void)
 	dbprintf("System Initialized\n");
 
 	mem_alloc_test();
+	zone_alloc_test();
 
 	STATIC_TASK_CREATE(task1, STACK_SIZE, task1_func, (void*)(uintptr_t)0x111);
 	STATIC_TASK_CREATE(task2, STACK_SIZE, task2_func, (void*)(uintptr_t)0x222);
@@ -61,8 +60,15 @@ int main(void)
 			}
 		} else {
 			dbprintf("Button pressed!\n");
-			set_next_task(&task1_task);
-			sched_yield();
+#if ENABLE_TASK_STATS
+			task_dump_stats();
+#endif /* ENABLE_TASK_STATS */
+#if ENABLE_SCHED_TRACE
+			sched_trace_dump();
+#endif /* ENABLE_SCHED_TRACE */
+#if ENABLE_MEM_DEBUG
+			mem_stats_dump();
+#endif /* ENABLE_MEM_DEBUG */
 		}
 
 		gpio_set_output(GPIO_LED_USER, led_ctrl);
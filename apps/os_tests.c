@@ -1,12 +1,13 @@
 #include "config.h"
 #include "debug.h"
 #include "os/mem_alloc.h"
+#include "os/zone_alloc.h"
 
 #include <stdint.h>
+#include <string.h>
 
 /**
- * Perform some very simple tests on the "init only, no free" dynamic memory
- * allocator.
+ * Perform some very simple tests on the dynamic memory allocator.
  */
 void mem_alloc_test(void)
 {
@@ -41,11 +42,16 @@ void mem_alloc_test(void)
 	uint8_t *buffer2 = (uint8_t*)mem_alloc(buffer2_size);
 
 	for(size_t i = 0; i < buffer2_size; i++) {
-		buffer1[i] = i;
+		buffer2[i] = i;
 	}
 
 	mem_free(buffer2);
 
+	/* Freed memory should get reused by the next allocation that fits. */
+	__assert_only uint8_t *buffer3 = (uint8_t*)mem_alloc(buffer2_size);
+	ASSERT(buffer3 == buffer2);
+	mem_free(buffer3);
+
 	dbprintf("Test 2 printf() to make sure this still works.\n");
 
 	/* Asking for more RAM than exists should fail. */
@@ -58,5 +64,78 @@ void mem_alloc_test(void)
 
 	mem_free(buffer1);
 
+	/* Allocate from a specific region with a specific alignment. */
+#ifdef DEBUG_ON
+	extern uint8_t _dtcm_start;
+	extern uint8_t _dtcm_end;
+#endif /* DEBUG_ON */
+
+	uint8_t *dtcm_buffer = (uint8_t*)mem_alloc_in(MEM_REGION_DTCM, 100, 32);
+	if(dtcm_buffer != ALLOC_FAILURE) {
+		ASSERT(((uintptr_t)dtcm_buffer & 31U) == 0);
+		ASSERT((dtcm_buffer >= &_dtcm_start) && (dtcm_buffer + 100 <= &_dtcm_end));
+		mem_free(dtcm_buffer);
+	} else {
+		dbprintf("No DTCM left over for the DTCM heap.\n");
+	}
+
+	for(mem_region_t region = MEM_REGION_DTCM; region < MEM_REGION_COUNT; region++) {
+		tlsf_stats_t stats;
+
+		if(mem_get_stats(region, &stats)) {
+			ASSERT(stats.num_allocs == 0);
+			dbprintf("Region %d heap: %u bytes, largest allocation %u bytes\n",
+			         region,
+			         (unsigned)stats.total_bytes,
+			         (unsigned)stats.largest_free);
+		}
+	}
+
+	ASSERT(mem_check());
+
 	dbprintf("Memory Allocation Test complete\n");
 }
+
+/* Zone used by zone_alloc_test(). Odd object size to exercise rounding. */
+ZONE_DEFINE(test, 13, 4);
+
+/**
+ * Perform some simple tests on the fixed-size zone allocator.
+ */
+void zone_alloc_test(void)
+{
+	void *objs[4];
+
+	for(int i = 0; i < 4; i++) {
+		objs[i] = zone_alloc(&test_zone);
+		ASSERT(objs[i] != NULL);
+		ASSERT(((uintptr_t)objs[i] & (ZONE_ALIGNMENT - 1U)) == 0);
+		memset(objs[i], i, 13);
+	}
+
+	/* The zone is empty now. */
+	__assert_only void *const empty = zone_alloc(&test_zone);
+	ASSERT(empty == NULL);
+
+	/* Freed objects get handed back out (most recently freed first). */
+	zone_free(&test_zone, objs[1]);
+	zone_free(&test_zone, objs[3]);
+
+	__assert_only void *const first = zone_alloc(&test_zone);
+	__assert_only void *const second = zone_alloc(&test_zone);
+	ASSERT(first == objs[3]);
+	ASSERT(second == objs[1]);
+
+	for(int i = 0; i < 4; i++) {
+		zone_free(&test_zone, objs[i]);
+	}
+
+	__assert_only zone_stats_t stats;
+	zone_get_stats(&test_zone, &stats);
+	ASSERT(stats.num_used == 0);
+	ASSERT(stats.peak_used == 4);
+	ASSERT(stats.num_failures == 1);
+
+	zone_dump_stats(&test_zone);
+	dbprintf("Zone Allocation Test complete\n");
+}
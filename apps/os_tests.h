@@ -1,3 +1,4 @@
 #pragma once
 
 void mem_alloc_test(void);
+void zone_alloc_test(void);
@@ -1,10 +1,15 @@
 #include "config.h"
+#include "arq.h"
 #include "debug.h"
+#include "dma.h"
 #include "fat.h"
 #include "fmc_sdram.h"
+#include "frag.h"
+#include "frame.h"
 #include "gpio.h"
 #include "graphics.h"
 #include "interrupt.h"
+#include "os/mem_alloc.h"
 #include "sdmmc.h"
 #include "spi.h"
 #include "spi/nokia5110.h"
@@ -198,16 +203,27 @@ void fat_dump_file_test(char *path)
 }
 
 #if ENABLE_SDRAM && ENABLE_LCD_GRAPHICS
+/* Size of a single framebuffer in bytes. */
+#define FRAMEBUFFER_SIZE (LCD_CONFIG_WIDTH * LCD_CONFIG_HEIGHT * LCD_CONFIG_PIXEL_SIZE)
+
+/* The framebuffer that gets drawn into, and the one the LCD displays. */
+static uint8_t draw_buffer[FRAMEBUFFER_SIZE] __sdram;
+static uint8_t render_buffer[FRAMEBUFFER_SIZE] __sdram;
+
+/**
+ * Ring buffers used by the interrupt-driven USART. The RX ring gets filled by
+ * DMA, so it has to be aligned to a cache line.
+ */
+static uint8_t usart_tx_buf[256];
+static uint8_t usart_rx_buf[256] __attribute__((aligned(DCACHE_LINE_SIZE)));
+
 /**
  * Print characters received over USART onto the screen.
  */
 void usart_gfx_test(void)
 {
-	const uint32_t draw_buffer = SDRAM_BASE;
-	const uint32_t render_buffer = SDRAM_BASE + (LCD_CONFIG_WIDTH * LCD_CONFIG_HEIGHT * LCD_CONFIG_PIXEL_SIZE);
-
 	fmc_sdram_init();
-	gfx_init(render_buffer, draw_buffer);
+	gfx_init((uint32_t)render_buffer, (uint32_t)draw_buffer);
 
 	gfx_clear_screen(PIXEL(0,0,0));
 	gfx_text_set_cursor(20, 10);
@@ -220,21 +236,35 @@ void usart_gfx_test(void)
 	gpio_request_alt(GPIO_PC6, AF8, GPIO_OSPEED_4MHZ);
 	gpio_request_alt(GPIO_PC7, AF8, GPIO_OSPEED_4MHZ);
 	usart_init(USART6, 115200, USART_8_DATA, USART_1_STOP);
+	usart_enable_buffering(USART6, usart_tx_buf, sizeof(usart_tx_buf), usart_rx_buf, sizeof(usart_rx_buf));
+	usart_enable_dma_tx(USART6, DMA_USART6_TX);
+	usart_enable_dma_rx(USART6, DMA_USART6_RX);
 	usart_enable_rx(USART6, true);
 	usart_enable_tx(USART6, true);
 	usart_send(USART6, (uint8_t*)"Hello There!\r\n", 14);
-	uint8_t ascii = 0;
 
 	while(1) {
-		ascii = usart_receive(USART6);
-		//dbprintf("%d\n", ascii);
-		usart_send_byte(USART6, ascii);
-		if(ascii >= 32 && ascii < 127) {
-			gfx_draw_char(ascii);
-
-			/* Wait for the DMA transfer to complete. */
-			gfx_swap_buffers();
+		/* Wakes up once per burst of characters (when the line goes idle). */
+		usart_rx_wait(USART6);
+
+		const uint8_t *data = NULL;
+		uint32_t len = 0;
+
+		while((len = usart_rx_peek(USART6, &data)) > 0) {
+			/* Echo the characters back straight out of the RX ring. */
+			usart_send(USART6, (uint8_t*)data, len);
+
+			for(uint32_t i = 0; i < len; ++i) {
+				if(data[i] >= 32 && data[i] < 127) {
+					gfx_draw_char(data[i]);
+				}
+			}
+
+			usart_rx_consume(USART6, len);
 		}
+
+		/* Wait for the DMA transfer to complete. */
+		gfx_swap_buffers();
 	}
 }
 
@@ -243,11 +273,8 @@ void usart_gfx_test(void)
  */
 void gfx_drawing_test(void)
 {
-	const uint32_t draw_buffer = SDRAM_BASE;
-	const uint32_t render_buffer = SDRAM_BASE + (LCD_CONFIG_WIDTH * LCD_CONFIG_HEIGHT * LCD_CONFIG_PIXEL_SIZE);
-
 	fmc_sdram_init();
-	gfx_init(render_buffer, draw_buffer);
+	gfx_init((uint32_t)render_buffer, (uint32_t)draw_buffer);
 
 	gfx_clear_screen(PIXEL(0,0,0));
 	gfx_swap_buffers();
@@ -295,11 +322,8 @@ void gfx_drawing_test(void)
  */
 void gfx_text_test(void)
 {
-	const uint32_t draw_buffer = SDRAM_BASE;
-	const uint32_t render_buffer = SDRAM_BASE + (LCD_CONFIG_WIDTH * LCD_CONFIG_HEIGHT * LCD_CONFIG_PIXEL_SIZE);
-
 	fmc_sdram_init();
-	gfx_init(render_buffer, draw_buffer);
+	gfx_init((uint32_t)render_buffer, (uint32_t)draw_buffer);
 
 	gfx_clear_screen(PIXEL(0,0,0));
 	gfx_text_set_cursor(20, 10);
@@ -391,6 +415,7 @@ void nokia_jstk_test(void)
 
 	Nokia5110Inst nokia;
 	nokia_init(&nokia, SPI2, NOKIA_DC, NOKIA_RST);
+	spi_enable_dma(SPI2, DMA_SPI2_TX, DMA_SPI2_RX);
 	spi_use_software_ss(nokia_get_spi_inst(&nokia), GPIO_ARD_D5);
 	nokia_set_params(&nokia, 0xB1, 0, 0x14);
 	nokia_set_disp_mode(&nokia, NOKIA_DISP_INVERSE);
@@ -411,7 +436,6 @@ void nokia_jstk_test(void)
 
 		uint16_t x, y;
 		uint8_t btns;
-		spi_reinit(jstk_get_spi_inst(&jstk));
 		jstk_get_data(&jstk, &x, &y, &btns);
 
 		bool led1 = JSTK_BTN_BTN1(btns) | JSTK_BTN_JOYSTICK(btns);
@@ -431,12 +455,10 @@ void nokia_jstk_test(void)
 		}
 
 		if(JSTK_BTN_JOYSTICK(btns)) {
-			spi_reinit(nokia_get_spi_inst(&nokia));
 			nokia_clear_screen(&nokia);
 		}
 
 		if((new_column != column) || (new_bank != bank)) {
-			spi_reinit(nokia_get_spi_inst(&nokia));
 			// nokia_set_position(&nokia, column, bank);
 			// nokia_set_column(&nokia, 0);
 
@@ -452,6 +474,24 @@ void nokia_jstk_test(void)
 	}
 }
 
+/**
+ * Set up the RFM69 radio used by the radio tests. The radio is on SPI2 with its
+ * DIO0 line on PB10.
+ */
+static void rfm69_test_init(Rfm69Inst *radio)
+{
+	gpio_request_alt(GPIO_PB13, AF5, GPIO_OSPEED_25MHZ); /* SPI2 SCK */
+	gpio_request_alt(GPIO_PB14, AF5, GPIO_OSPEED_25MHZ); /* SPI2 MISO */
+	gpio_request_alt(GPIO_PB15, AF5, GPIO_OSPEED_25MHZ); /* SPI2 MOSI */
+	gpio_request_output(GPIO_PB12, GPIO_HIGH);           /* SPI2 NSS */
+	gpio_request_output(GPIO_PB11, GPIO_HIGH);           /* RFM69 RST */
+
+	rfm69_init_radio(radio, SPI2, GPIO_PB11, GPIO_PB12);
+	rfm69_set_payload_length(radio, RFM69_VARIABLE_LENGTH_PAYLOAD);
+	rfm69_set_power_mode(radio, RFM69_PA1, 31); /* 13dBm */
+	rfm69_enable_interrupts(radio, GPIO_PB10);
+}
+
 /**
  * Send a single byte of data from one device to another using RFM69 radio
  * modules. The receiver will send an acknowledgement after every packet it
@@ -460,19 +500,14 @@ void nokia_jstk_test(void)
  *
  * Compile the transmitter: make gdb_[jlink/openocd] CPPFLAGS=-DTRANSMITTER
  * Compile the receiver without the "TRANSMITTER" define.
+ *
+ * The radio's DIO0 line is expected on PB10, so packets are received (and
+ * transmissions finished) by interrupt instead of by polling the radio.
  */
 void rfm69_test(void)
 {
-	gpio_request_alt(GPIO_PB13, AF5, GPIO_OSPEED_25MHZ); /* SPI2 SCK */
-	gpio_request_alt(GPIO_PB14, AF5, GPIO_OSPEED_25MHZ); /* SPI2 MISO */
-	gpio_request_alt(GPIO_PB15, AF5, GPIO_OSPEED_25MHZ); /* SPI2 MOSI */
-	gpio_request_output(GPIO_PB12, GPIO_HIGH);           /* SPI2 NSS */
-	gpio_request_output(GPIO_PB11, GPIO_HIGH);           /* RFM69 RST */
-
 	Rfm69Inst radio;
-	rfm69_init_radio(&radio, SPI2, GPIO_PB11, GPIO_PB12);
-	rfm69_set_payload_length(&radio, RFM69_VARIABLE_LENGTH_PAYLOAD);
-	rfm69_set_power_mode(&radio, RFM69_PA1, 31); /* 13dBm */
+	rfm69_test_init(&radio);
 
 	#define DATA_SIZE 5
 
@@ -523,3 +558,198 @@ void rfm69_test(void)
 	}
 #endif
 }
+
+#if ENABLE_ARQ
+/* Payload size used by rfm69_arq_test() (the index plus filler). */
+#define RFM69_ARQ_PAYLOAD 48U
+
+/**
+ * Send an ARQ packet over the radio. The receiver reads packets out with the
+ * DIO0 interrupt, which drops anything that doesn't fit in the FIFO, so
+ * ARQ_MAX_PAYLOAD has to leave room for the ARQ header.
+ */
+static void rfm69_arq_send(void *arg, const uint8_t *data, uint8_t len)
+{
+	ASSERT(len <= RFM69_FIFO_PAYLOAD_LEN);
+	rfm69_send((Rfm69Inst*)arg, (uint8_t*)data, len);
+}
+
+/* Check that the payloads come out in order and print out progress. */
+static void rfm69_arq_deliver(__unused void *arg, const uint8_t *data, __unused uint8_t len)
+{
+	static uint32_t expected = 0;
+	uint32_t index;
+
+	memcpy(&index, data, sizeof(index));
+	ASSERT(index == expected);
+	expected++;
+
+	if((expected % 100U) == 0) {
+		dbprintf("Delivered %u packets | Duplicates: %u | ACKs: %u\n",
+			(unsigned)expected,
+			(unsigned)arq_get_stats((ArqInst*)arg).duplicates,
+			(unsigned)arq_get_stats((ArqInst*)arg).acks_sent);
+	}
+}
+
+/**
+ * Stream numbered packets from one device to another over RFM69 radios using
+ * the ARQ transport, so lost packets get resent and show up in order without
+ * waiting on an acknowledgement for every packet.
+ *
+ * Compile the transmitter: make gdb_[jlink/openocd] CPPFLAGS=-DTRANSMITTER
+ * Compile the receiver without the "TRANSMITTER" define.
+ */
+void rfm69_arq_test(void)
+{
+	static Rfm69Inst radio;
+	rfm69_test_init(&radio);
+
+	/**
+	 * The receiver holds off on acknowledging long enough for the next packet
+	 * in a burst to start arriving, so it doesn't transmit over the sender.
+	 */
+	static ArqInst arq;
+	const ArqConfig config = {
+		.window = 4,
+		.retransmit_timeout = MSECS(80),
+		.ack_delay = MSECS(15),
+		.max_retries = 10
+	};
+	arq_init(&arq, &config, rfm69_arq_send, &radio, rfm69_arq_deliver, &arq);
+
+#ifdef TRANSMITTER
+	dbprintf("ARQ Transmitter\n");
+	uint8_t payload[RFM69_ARQ_PAYLOAD] = { 0 };
+	uint32_t index = 0;
+#else
+	dbprintf("ARQ Receiver\n");
+#endif
+
+	uint8_t packet[RFM69_FIFO_PAYLOAD_LEN];
+	while(!arq_failed(&arq)) {
+#ifdef TRANSMITTER
+		/* Keep the window full. */
+		memcpy(payload, &index, sizeof(index));
+		while(arq_send(&arq, payload, sizeof(payload), get_cycles())) {
+			index++;
+			memcpy(payload, &index, sizeof(index));
+		}
+#endif
+
+		/* Listen for packets until something is due. */
+		const uint64_t now = get_cycles();
+		const uint64_t deadline = arq_next_deadline(&arq);
+		uint64_t timeout = (deadline > now) ? (deadline - now) : 0;
+		timeout = (timeout < MSECS(100)) ? timeout : MSECS(100);
+
+		const uint8_t len = rfm69_receive_timeout(&radio, packet, sizeof(packet), (uint32_t)timeout);
+
+		if(len > 0) {
+			arq_input(&arq, packet, len, get_cycles());
+		} else {
+			arq_poll(&arq, get_cycles());
+		}
+	}
+
+	dbprintf("ARQ connection failed after %u retransmits\n", (unsigned)arq_get_stats(&arq).retransmits);
+}
+#endif /* ENABLE_ARQ */
+
+#if ENABLE_FRAGMENTATION
+/* Send a fragment over the radio, waiting for it to be acknowledged. */
+static bool rfm69_frag_send(void *arg, const uint8_t *data, uint8_t len)
+{
+	return rfm69_send_with_ack((Rfm69Inst*)arg, (uint8_t*)data, len, 5, MSECS(30));
+}
+
+/**
+ * Send a 2KiB message from one device to another every second over RFM69
+ * radios. Each fragment gets acknowledged (see rfm69_send_with_ack()), and
+ * the receiver checks that every message comes back together intact.
+ *
+ * Compile the transmitter: make gdb_[jlink/openocd] CPPFLAGS=-DTRANSMITTER
+ * Compile the receiver without the "TRANSMITTER" define.
+ */
+void rfm69_frag_test(void)
+{
+	static Rfm69Inst radio;
+	rfm69_test_init(&radio);
+
+	static FragInst frag;
+	frag_init(&frag, rfm69_frag_send, &radio, RFM69_FIFO_PAYLOAD_LEN, MSECS(500));
+
+	static uint8_t message[2048];
+
+#ifdef TRANSMITTER
+	dbprintf("Fragmentation Transmitter\n");
+	for(uint32_t iter = 0; ; ++iter) {
+		for(uint32_t i = 0; i < sizeof(message); ++i) {
+			message[i] = (uint8_t)(iter + i);
+		}
+
+		if(!frag_send(&frag, message, sizeof(message))) {
+			dbprintf("Failed to send message %u\n", (unsigned)iter);
+		}
+
+		sleep(MSECS(1000));
+	}
+#else
+	dbprintf("Fragmentation Receiver\n");
+	uint8_t packet[RFM69_FIFO_PAYLOAD_LEN];
+	while(1) {
+		const uint8_t len = rfm69_receive_with_ack(&radio, packet, sizeof(packet));
+		FragMessage *const msg = frag_input(&frag, packet, len, get_cycles());
+
+		if(msg == NULL) {
+			continue;
+		}
+
+		/* Every byte is one more than the last. */
+		bool intact = (msg->len == sizeof(message));
+		for(uint32_t i = 1; intact && (i < msg->len); ++i) {
+			intact = (msg->data[i] == (uint8_t)(msg->data[i - 1U] + 1U));
+		}
+
+		dbprintf("%s message (%u bytes) | Duplicates: %u | Timeouts: %u | RSSI: %d dBm\n",
+			(intact) ? "Received" : "Corrupted", (unsigned)msg->len,
+			(unsigned)frag_get_stats(&frag).duplicates, (unsigned)frag_get_stats(&frag).timeouts,
+			rfm69_get_last_rssi(&radio));
+
+		frag_message_free(msg);
+	}
+#endif
+}
+#endif /* ENABLE_FRAGMENTATION */
+
+#if ENABLE_FRAMING
+/* Ring buffers for the USART carrying frames (the RX ring is filled by DMA). */
+static uint8_t frame_tx_buf[1024];
+static uint8_t frame_rx_buf[1024] __attribute__((aligned(DCACHE_LINE_SIZE)));
+
+/**
+ * Echo every frame received over USART6 back to the sender. Run
+ * "tools/frame_tool.py loopback <serial_port> 921600" on the host to send
+ * random frames through the target and check they all come back intact.
+ */
+void frame_echo_test(void)
+{
+	gpio_request_alt(GPIO_PC6, AF8, GPIO_OSPEED_25MHZ);
+	gpio_request_alt(GPIO_PC7, AF8, GPIO_OSPEED_25MHZ);
+	usart_init(USART6, 921600, USART_8_DATA, USART_1_STOP);
+	usart_enable_buffering(USART6, frame_tx_buf, sizeof(frame_tx_buf), frame_rx_buf, sizeof(frame_rx_buf));
+	usart_enable_dma_tx(USART6, DMA_USART6_TX);
+	usart_enable_dma_rx(USART6, DMA_USART6_RX);
+	usart_enable_rx(USART6, true);
+	usart_enable_tx(USART6, true);
+
+	FrameDecoder decoder;
+	frame_decoder_init(&decoder);
+
+	while(1) {
+		FramePacket *const packet = frame_receive(USART6, &decoder);
+		frame_send(USART6, packet->data, packet->len);
+		frame_packet_free(packet);
+	}
+}
+#endif /* ENABLE_FRAMING */
@@ -8,6 +8,7 @@ void sd_read_mbr_test(void);
 void fat_dump_file_test(char *path);
 
 void usart_gfx_test(void);
+void frame_echo_test(void);
 
 void gfx_drawing_test(void);
 void gfx_text_test(void);
@@ -16,3 +17,5 @@ void jstk_test(void);
 void nokia_jstk_test(void);
 
 void rfm69_test(void);
+void rfm69_arq_test(void);
+void rfm69_frag_test(void);
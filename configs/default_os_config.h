@@ -42,11 +42,41 @@
  */
 #define MIN_INTR_STACK_SIZE 512U
 
+/**
+ * Number of bytes of RAM left over for newlib's malloc() (used internally by
+ * functions like printf()). All other RAM between the BSS section and the
+ * interrupt stack is given to the mem_alloc() heap.
+ */
+#define MEM_ALLOC_NEWLIB_RESERVE (16U * 1024U)
+
+/**
+ * Set to 1 to instrument the memory allocators (mem_alloc() and zones). Every
+ * heap allocation gets tagged with its call site, and every heap allocation and
+ * zone object gets a red zone after it that is checked when the memory is freed
+ * (and by mem_check()). Usage statistics can be read with mem_stats_get() or
+ * printed with mem_stats_dump(). This adds 16 bytes plus the red zone to every
+ * heap allocation.
+ */
+#define ENABLE_MEM_DEBUG 0
+
+#if ENABLE_MEM_DEBUG
+/**
+ * Number of distinct call sites tracked. Allocations from any call sites past
+ * this limit get lumped together into the last entry.
+ */
+#define MEM_DEBUG_MAX_CALL_SITES 16U
+
+/* Minimum size (in bytes) of the red zone after each allocation. */
+#define MEM_DEBUG_REDZONE_SIZE 8U
+
+/* Byte value written into the red zones. */
+#define MEM_DEBUG_REDZONE_VALUE 0xFD
+#endif /* ENABLE_MEM_DEBUG */
+
 /**
  * Set to 1 to enable inserting and checking the stack guard byte value. One
- * byte at the bottom of every stack will be used as a guard value.
- *
- * TODO: Implement stack guard checking.
+ * byte at the bottom of every stack will be used as a guard value. The guard
+ * value of the task being switched out is checked on every context switch.
  */
 #define ENABLE_STACK_GUARD 1
 
@@ -59,6 +89,180 @@
 #define STACK_GUARD_MAGIC 0xD5
 #endif /* ENABLE_STACK_GUARD */
 
+/**
+ * Set to 1 to also make the bottom MPU_STACK_GUARD_SIZE bytes of the running
+ * task's stack read-only using the MPU. An overflow will then cause a MemManage
+ * fault on the offending instruction instead of being caught at the next
+ * context switch. This requires every task stack to be aligned to
+ * MPU_STACK_GUARD_SIZE, and those bytes can't be used by the task.
+ */
+#define ENABLE_MPU_STACK_GUARD 0
+
+#if ENABLE_MPU_STACK_GUARD
+/* Size of the MPU guard region (must be a power of two, 32 bytes minimum). */
+#define MPU_STACK_GUARD_SIZE 32U
+
+/* The MPU region reprogrammed on every context switch to cover the new task. */
+#define MPU_STACK_GUARD_REGION 0U
+
+/* Stacks need to be aligned to the guard region size. */
+#define STACK_ALIGNMENT MPU_STACK_GUARD_SIZE
+#else
+/* The ARM Procedure Call Standard requires 8-byte alignment for stacks. */
+#define STACK_ALIGNMENT 8U
+#endif /* ENABLE_MPU_STACK_GUARD */
+
+/**
+ * Set to 1 to fill every task's stack with STACK_PAINT_VALUE when the task is
+ * created. The amount of stack a task has ever used (its high-water mark) can
+ * then be queried with task_get_stack_high_water() to size stacks tightly.
+ */
+#define ENABLE_STACK_PAINTING 1
+
+#if ENABLE_STACK_PAINTING
+/* Byte value used to paint unused stack memory. */
+#define STACK_PAINT_VALUE 0xA5
+#endif /* ENABLE_STACK_PAINTING */
+
+/**
+ * Set to 1 to keep track of how much CPU time each task has used (measured with
+ * the DWT cycle counter) and how many times each task has been switched to.
+ * See task_dump_stats().
+ */
+#define ENABLE_TASK_STATS 1
+
+/**
+ * Set to 1 to record every context switch (timestamp, from, to, and reason)
+ * into a ring buffer that can be read out with sched_trace_read() or printed
+ * with sched_trace_dump(). Requires ENABLE_TASK_STATS.
+ */
+#define ENABLE_SCHED_TRACE 1
+
+#if ENABLE_SCHED_TRACE
+/* Number of switch events kept in the trace buffer (must be a power of two). */
+#define SCHED_TRACE_SIZE 64U
+#endif /* ENABLE_SCHED_TRACE */
+
+/**
+ * Set to 1 to enable software timers (see os/sw_timer.h). This also makes
+ * sleep() block the calling task (letting other tasks run) instead of spinning.
+ */
+#define ENABLE_SW_TIMERS 1
+
+#if ENABLE_SW_TIMERS
+/**
+ * Priority and stack size of the task that runs software timer callbacks. The
+ * priority should be higher than any task whose timers need to run on time.
+ */
+#define SW_TIMER_TASK_PRIORITY 6U
+#define SW_TIMER_TASK_STACK_SIZE 512U
+#endif /* ENABLE_SW_TIMERS */
+
+/**
+ * Set to 1 to enable the deferred work queue (see os/work_queue.h). Drivers use
+ * this to move their callbacks out of interrupt context and into a task.
+ */
+#define ENABLE_WORK_QUEUE 1
+
+#if ENABLE_WORK_QUEUE
+/**
+ * Priority and stack size of the task that runs submitted work items. The
+ * priority should be higher than any other task so deferred interrupt work
+ * runs right after the interrupt that submitted it.
+ */
+#define WORK_QUEUE_TASK_PRIORITY 7U
+#define WORK_QUEUE_TASK_STACK_SIZE 1024U
+#endif /* ENABLE_WORK_QUEUE */
+
+/**
+ * Maximum length of a single dbprintf() message (plus one for the terminator).
+ * Messages are formatted into a buffer of this size on the caller's stack, and
+ * longer messages get truncated.
+ */
+#define DEBUG_PRINTF_BUFFER_SIZE 128U
+
+/**
+ * Set to 1 to send dbprintf() output through a lock-free ring buffer that gets
+ * drained by a low-priority task (see os/log.h). Otherwise every dbprintf()
+ * call blocks until its output has been sent (which halts the CPU for a few
+ * milliseconds when using semihosting).
+ */
+#define ENABLE_LOG_RING 1
+
+#if ENABLE_LOG_RING
+/* Size of the log ring in bytes (must be a power of two). */
+#define LOG_RING_SIZE 4096U
+
+/**
+ * Priority and stack size of the task that drains the log ring. The priority
+ * is below TASK_DEFAULT_PRIORITY so logging doesn't get in the way of the
+ * tasks doing it.
+ */
+#define LOG_TASK_PRIORITY TASK_LOWEST_PRIORITY
+#define LOG_TASK_STACK_SIZE 512U
+
+/**
+ * Set to 1 to have dblog() write a format string ID and the raw arguments into
+ * the log ring instead of formatting the message on the target. This takes a
+ * few dozen cycles per message, but the output has to be decoded on the host
+ * with tools/log_decode.py.
+ */
+#define ENABLE_LOG_BINARY 0
+#endif /* ENABLE_LOG_RING */
+
+/**
+ * Set to 1 to enable the framed packet layer (see drivers/frame.h) used to send
+ * binary packets to a host over a USART. Each packet is protected by a CRC-16
+ * and COBS encoded so a zero byte marks the end of every frame.
+ */
+#define ENABLE_FRAMING 0
+
+#if ENABLE_FRAMING
+/* Largest payload (in bytes) that a single frame can carry. */
+#define FRAME_MAX_PAYLOAD 256U
+
+/* Number of packets in the packet pool shared by every frame decoder. */
+#define FRAME_POOL_SIZE 8U
+#endif /* ENABLE_FRAMING */
+
+/**
+ * Set to 1 to enable the reliable packet transport (see drivers/arq.h) used to
+ * send packets in order over a lossy link (like the RFM69 radio). Up to a
+ * window of packets can be in flight at once, and lost ones get resent.
+ */
+#define ENABLE_ARQ 0
+
+#if ENABLE_ARQ
+/* Largest window a connection can use (a power of two, no more than 32). */
+#define ARQ_MAX_WINDOW 8U
+
+/**
+ * Largest payload (in bytes) that a single packet can carry (no more than 253).
+ * The default keeps packets (payload plus the two byte header) small enough for
+ * the RFM69 to receive with its DIO0 interrupt (see RFM69_FIFO_PAYLOAD_LEN).
+ */
+#define ARQ_MAX_PAYLOAD 59U
+#endif /* ENABLE_ARQ */
+
+/**
+ * Set to 1 to enable the fragmentation layer (see drivers/frag.h) used to send
+ * messages that are too large for a single packet (e.g., files sent over the
+ * RFM69 radio). Each message is protected by a CRC-32 and reassembled into a
+ * buffer from a fixed-size pool.
+ */
+#define ENABLE_FRAGMENTATION 0
+
+#if ENABLE_FRAGMENTATION
+/* Largest message (in bytes) that can be sent. */
+#define FRAG_MAX_MESSAGE 4096U
+
+/* Most fragments a single message can be split into. */
+#define FRAG_MAX_FRAGMENTS 128U
+
+/* Number of messages in the reassembly pool shared by every link. */
+#define FRAG_POOL_SIZE 2U
+#endif /* ENABLE_FRAGMENTATION */
+
 /**
  * System timer tick granularity (in CPU_HZ cycles).
  *
@@ -66,3 +270,20 @@
  * a 216MHz CPU clock, this gives a maximum tick of 77.6ms.
  */
 #define SYSTIMER_TICK (CPU_HZ / 1000U) /* 1ms tick */
+
+/**
+ * Set to 1 to let the CPU sleep (WFI) during long sleep() calls instead of
+ * busy-spinning (e.g., in the idle task). While idling, the SysTick period gets
+ * stretched out to the wakeup deadline (up to 2^24 cycles) so the CPU isn't
+ * woken up every tick just to increment the cycle count.
+ */
+#define ENABLE_TICKLESS_IDLE 1
+
+#if ENABLE_TICKLESS_IDLE
+/**
+ * Waits shorter than this (in CPU_HZ cycles) will spin instead of idling. This
+ * should be large enough to cover the overhead of reprogramming the SysTick
+ * timer and waking back up.
+ */
+#define TICKLESS_MIN_IDLE_CYCLES (2U * SYSTIMER_TICK)
+#endif /* ENABLE_TICKLESS_IDLE */
@@ -59,6 +59,19 @@
 /* STM32F7 uses 4-bits for the interrupt priority level. */
 #define INTR_PRIORITY_BITS 4U
 
+/**
+ * Set to 1 to stream log output, context switch events, and user counters out
+ * of the SWO pin using the ITM (see itm.h). The log ring gets drained to the
+ * ITM instead of semihosting. Point an SWO viewer running at ITM_SWO_BAUD at
+ * the stimulus port(s) of interest.
+ */
+#define ENABLE_ITM 0
+
+#if ENABLE_ITM
+/* SWO baud rate. CPU_HZ should be a multiple of this. */
+#define ITM_SWO_BAUD 2000000U
+#endif /* ENABLE_ITM */
+
 #include "stm32f7/stm32f7_mem_map.h"
 
 /* Utilize the default OS configuration. */
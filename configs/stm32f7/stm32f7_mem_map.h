@@ -14,9 +14,11 @@
 #define DWT_BASE       (0xE0001000UL)         /* DWT Base Address */
 #define TPI_BASE       (0xE0040000UL)         /* TPI Base Address */
 #define CoreDebug_BASE (0xE000EDF0UL)         /* Core Debug Base Address */
+#define DBGMCU_BASE    (0xE0042000UL)         /* Debug MCU Base Address */
 #define SysTick_BASE   (SCS_BASE + 0x0010UL) /* SysTick Base Address */
 #define NVIC_BASE      (SCS_BASE + 0x0100UL) /* NVIC Base Address */
 #define SCB_BASE       (SCS_BASE + 0x0D00UL) /* System Control Block Base Address */
+#define MPU_BASE       (SCS_BASE + 0x0D90UL) /* Memory Protection Unit */
 #define FPU_BASE       (SCS_BASE + 0x0F30UL) /* Floating Point Unit */
 
 #define RAMITCM_BASE   0x00000000U /* Base address of : 16KB RAM reserved for CPU execution/instruction accessible over ITCM  */
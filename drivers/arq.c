@@ -0,0 +1,419 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Reliable, in-order packet transport (selective repeat ARQ) over a lossy
+ * packet link such as an RFM69 radio.
+ *
+ * Every data packet carries an 8-bit sequence number, and up to a window's
+ * worth of packets can be sent before the oldest one is acknowledged. The
+ * receiver buffers packets that arrive after a lost one and answers with an
+ * acknowledgement made up of:
+ *
+ * - A cumulative ACK: the next sequence number it expects (everything before
+ *   it has been delivered).
+ * - A selective ACK: a bitmap of the packets after that which it's holding on
+ *   to (bit 0 is the cumulative ACK + 1).
+ *
+ * Packets that the selective ACK shows were skipped over get resent right
+ * away, and every unacknowledged packet gets resent when its own retransmit
+ * timer expires. Duplicate packets (e.g., resent because an acknowledgement
+ * was lost) are detected by their sequence number and dropped.
+ *
+ * On the wire, the packets look like:
+ *
+ *     Data: ARQ_TYPE_DATA | sequence number | payload
+ *     ACK:  ARQ_TYPE_ACK  | cumulative ACK  | selective ACK (32-bit little endian)
+ *
+ * The receiver delays its acknowledgement a little (ArqConfig.ack_delay) so a
+ * burst of packets shares a single acknowledgement, which also keeps a
+ * half-duplex radio from talking over the sender. Once a full window has been
+ * received, it acknowledges right away.
+ *
+ * Nothing in here touches hardware or reads the time on its own: packets are
+ * sent through a callback, received packets are passed into arq_input(), and
+ * the current time is passed into every call. That lets a connection run over
+ * a radio, a UART, or a simulated lossy link just the same.
+ */
+#include "config.h"
+#include "arq.h"
+#include "debug.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if ENABLE_ARQ
+
+_Static_assert((ARQ_MAX_WINDOW & (ARQ_MAX_WINDOW - 1U)) == 0,
+               "ARQ_MAX_WINDOW must be a power of two");
+_Static_assert(ARQ_MAX_WINDOW <= 32U,
+               "The selective ACK bitmap can only cover a window of 32 packets");
+_Static_assert(ARQ_MAX_PACKET <= UINT8_MAX,
+               "ARQ_MAX_PAYLOAD is too large for the packet length");
+
+/* Packet types (the first byte of every packet). */
+#define ARQ_TYPE_DATA 0xD0U
+#define ARQ_TYPE_ACK 0xACU
+
+/**
+ * The slots are indexed by sequence number. Sequence numbers wrap at 256,
+ * which is a multiple of ARQ_MAX_WINDOW, so this never maps two packets in
+ * the same window to the same slot.
+ */
+static inline ArqTxSlot * _tx_slot(ArqInst *inst, uint8_t seq)
+{
+	return &inst->tx_slots[seq & (ARQ_MAX_WINDOW - 1U)];
+}
+
+static inline ArqRxSlot * _rx_slot(ArqInst *inst, uint8_t seq)
+{
+	return &inst->rx_slots[seq & (ARQ_MAX_WINDOW - 1U)];
+}
+
+/**
+ * Initialize one end of a connection.
+ *
+ * @param inst The connection to initialize.
+ * @param config Settings for the connection (both ends need to use the same
+ *               window). This gets copied.
+ * @param send Sends a packet (no more than ARQ_MAX_PACKET bytes) over the link.
+ * @param send_arg Passed into "send".
+ * @param deliver Called with every received payload, in order.
+ * @param deliver_arg Passed into "deliver".
+ */
+void arq_init(
+	ArqInst *inst,
+	const ArqConfig *config,
+	ArqSendFn send,
+	void *send_arg,
+	ArqDeliverFn deliver,
+	void *deliver_arg)
+{
+	ASSERT(inst != NULL);
+	ASSERT(config != NULL);
+	ASSERT((config->window > 0) && (config->window <= ARQ_MAX_WINDOW));
+	ASSERT(config->retransmit_timeout > 0);
+	ASSERT(send != NULL);
+	ASSERT(deliver != NULL);
+
+	inst->config = *config;
+	inst->send = send;
+	inst->send_arg = send_arg;
+	inst->deliver = deliver;
+	inst->deliver_arg = deliver_arg;
+
+	inst->tx_base = 0;
+	inst->tx_next = 0;
+	inst->rx_next = 0;
+	inst->rx_buffered = 0;
+	inst->rx_unacked = 0;
+	inst->ack_pending = false;
+	inst->ack_deadline = 0;
+	inst->failed = false;
+	inst->stats = (ArqStats) { 0 };
+}
+
+/**
+ * Queue up a payload and send it. This never waits: if the window is full, the
+ * payload has to be sent again later (after arq_input() has processed an
+ * acknowledgement).
+ *
+ * @param inst The connection to send over.
+ * @param data The payload to send (gets copied).
+ * @param len The length of the payload (no more than ARQ_MAX_PAYLOAD).
+ * @param now The current cycle count (see get_cycles()).
+ *
+ * @return True if the payload was sent, false if the window is full or the
+ *         connection has failed (see arq_failed()).
+ */
+bool arq_send(ArqInst *inst, const uint8_t *data, uint8_t len, uint64_t now)
+{
+	ASSERT(inst != NULL);
+	ASSERT((data != NULL) || (len == 0));
+	ASSERT(len <= ARQ_MAX_PAYLOAD);
+
+	if(inst->failed || (arq_in_flight(inst) >= inst->config.window)) {
+		return false;
+	}
+
+	const uint8_t seq = inst->tx_next++;
+	ArqTxSlot *const slot = _tx_slot(inst, seq);
+
+	slot->data[0] = ARQ_TYPE_DATA;
+	slot->data[1] = seq;
+	if(len > 0) {
+		memcpy(&slot->data[ARQ_HEADER_SIZE], data, len);
+	}
+
+	slot->len = ARQ_HEADER_SIZE + len;
+	slot->retries = 0;
+	slot->acked = false;
+	slot->deadline = now + inst->config.retransmit_timeout;
+
+	inst->stats.sent++;
+	inst->send(inst->send_arg, slot->data, slot->len);
+
+	return true;
+}
+
+/**
+ * Send a packet again (unless it's out of retries, which fails the connection).
+ */
+static void _retransmit(ArqInst *inst, ArqTxSlot *slot, uint64_t now)
+{
+	if((inst->config.max_retries != 0) && (slot->retries >= inst->config.max_retries)) {
+		dblog("[ARQ] Packet %u ran out of retries\n", slot->data[1]);
+		inst->failed = true;
+		return;
+	}
+
+	slot->retries++;
+	slot->deadline = now + inst->config.retransmit_timeout;
+
+	inst->stats.retransmits++;
+	inst->send(inst->send_arg, slot->data, slot->len);
+}
+
+/* Send an acknowledgement for everything received so far. */
+static void _send_ack(ArqInst *inst)
+{
+	const uint32_t sack = inst->rx_buffered;
+	const uint8_t ack[ARQ_ACK_SIZE] = {
+		ARQ_TYPE_ACK,
+		inst->rx_next,
+		(uint8_t)sack,
+		(uint8_t)(sack >> 8),
+		(uint8_t)(sack >> 16),
+		(uint8_t)(sack >> 24)
+	};
+
+	inst->ack_pending = false;
+	inst->rx_unacked = 0;
+
+	inst->stats.acks_sent++;
+	inst->send(inst->send_arg, ack, sizeof(ack));
+}
+
+/* Hand a payload to the deliver callback. */
+static void _deliver(ArqInst *inst, const uint8_t *data, uint8_t len)
+{
+	inst->rx_next++;
+	inst->stats.delivered++;
+	inst->deliver(inst->deliver_arg, data, len);
+}
+
+/* Process a received data packet. */
+static void _input_data(ArqInst *inst, uint8_t seq, const uint8_t *payload, uint8_t len, uint64_t now)
+{
+	const uint8_t offset = (uint8_t)(seq - inst->rx_next);
+
+	if(offset >= inst->config.window) {
+		/**
+		 * Already delivered (its acknowledgement must have been lost), so just
+		 * acknowledge it again.
+		 */
+		inst->stats.duplicates++;
+	} else if(offset == 0) {
+		_deliver(inst, payload, len);
+
+		/* Bit 0 now refers to rx_next, so deliver everything that was waiting on this packet. */
+		while(inst->rx_buffered & 1U) {
+			const ArqRxSlot *const slot = _rx_slot(inst, inst->rx_next);
+
+			inst->rx_buffered >>= 1;
+			_deliver(inst, slot->data, slot->len);
+		}
+
+		inst->rx_buffered >>= 1;
+	} else if(inst->rx_buffered & (1UL << (offset - 1U))) {
+		inst->stats.duplicates++;
+	} else {
+		/* An earlier packet got lost, so hold onto this one until it shows up. */
+		ArqRxSlot *const slot = _rx_slot(inst, seq);
+
+		if(len > 0) {
+			memcpy(slot->data, payload, len);
+		}
+
+		slot->len = len;
+		inst->rx_buffered |= (1UL << (offset - 1U));
+	}
+
+	/**
+	 * Hold off on the acknowledgement so it can cover more packets, unless a
+	 * full window has come in (in which case the sender is stuck waiting).
+	 */
+	if(inst->rx_unacked < UINT8_MAX) {
+		inst->rx_unacked++;
+	}
+
+	if(inst->rx_unacked >= inst->config.window) {
+		inst->ack_deadline = now;
+	} else if(!inst->ack_pending) {
+		inst->ack_deadline = now + inst->config.ack_delay;
+	}
+
+	inst->ack_pending = true;
+}
+
+/* Process a received acknowledgement. */
+static void _input_ack(ArqInst *inst, const uint8_t *data, uint64_t now)
+{
+	const uint8_t ack = data[1];
+	const uint32_t sack = (uint32_t)data[2] |
+	                      ((uint32_t)data[3] << 8) |
+	                      ((uint32_t)data[4] << 16) |
+	                      ((uint32_t)data[5] << 24);
+	const uint8_t in_flight = arq_in_flight(inst);
+
+	/* Ignore acknowledgements that are older than what's already been acknowledged. */
+	if((uint8_t)(ack - inst->tx_base) > in_flight) {
+		return;
+	}
+
+	inst->stats.acks_received++;
+	inst->tx_base = ack;
+
+	/**
+	 * Mark the packets the receiver is holding onto. Any packet that was last
+	 * sent before the newest of those (and isn't being held) has been lost.
+	 */
+	uint64_t latest = 0;
+	bool any_held = false;
+
+	for(uint8_t i = 0; i < (uint8_t)(inst->tx_next - ack); ++i) {
+		const uint8_t seq = (uint8_t)(ack + i);
+		ArqTxSlot *const slot = _tx_slot(inst, seq);
+
+		if((i > 0) && (sack & (1UL << (i - 1U)))) {
+			slot->acked = true;
+
+			if(!any_held || (slot->deadline > latest)) {
+				latest = slot->deadline;
+			}
+
+			any_held = true;
+		}
+	}
+
+	if(!any_held || inst->failed) {
+		return;
+	}
+
+	for(uint8_t seq = inst->tx_base; seq != inst->tx_next; ++seq) {
+		ArqTxSlot *const slot = _tx_slot(inst, seq);
+
+		if(!slot->acked && (slot->deadline < latest)) {
+			_retransmit(inst, slot, now);
+		}
+	}
+}
+
+/**
+ * Process a packet received over the link. This delivers any payloads that are
+ * now in order, frees up room in the window for acknowledged packets, and then
+ * does anything that's due (see arq_poll()).
+ *
+ * @param inst The connection the packet was received on.
+ * @param data The packet.
+ * @param len The length of the packet.
+ * @param now The current cycle count (see get_cycles()).
+ */
+void arq_input(ArqInst *inst, const uint8_t *data, uint8_t len, uint64_t now)
+{
+	ASSERT(inst != NULL);
+	ASSERT((data != NULL) || (len == 0));
+
+	if((len >= ARQ_HEADER_SIZE) && (len <= ARQ_MAX_PACKET) && (data[0] == ARQ_TYPE_DATA)) {
+		_input_data(inst, data[1], &data[ARQ_HEADER_SIZE], len - ARQ_HEADER_SIZE, now);
+	} else if((len == ARQ_ACK_SIZE) && (data[0] == ARQ_TYPE_ACK)) {
+		_input_ack(inst, data, now);
+	} else {
+		inst->stats.malformed++;
+	}
+
+	arq_poll(inst, now);
+}
+
+/**
+ * Resend any packets whose retransmit timer has expired, and send the pending
+ * acknowledgement if it's due. This has to be called by the time returned by
+ * arq_next_deadline().
+ *
+ * @param inst The connection to update.
+ * @param now The current cycle count (see get_cycles()).
+ */
+void arq_poll(ArqInst *inst, uint64_t now)
+{
+	ASSERT(inst != NULL);
+
+	for(uint8_t seq = inst->tx_base; (seq != inst->tx_next) && !inst->failed; ++seq) {
+		ArqTxSlot *const slot = _tx_slot(inst, seq);
+
+		if(!slot->acked && (slot->deadline <= now)) {
+			_retransmit(inst, slot, now);
+		}
+	}
+
+	if(inst->ack_pending && (inst->ack_deadline <= now)) {
+		_send_ack(inst);
+	}
+}
+
+/**
+ * @return The cycle count that arq_poll() needs to be called by, or
+ *         ARQ_NO_DEADLINE if there's nothing waiting on a timer.
+ */
+uint64_t arq_next_deadline(ArqInst *inst)
+{
+	ASSERT(inst != NULL);
+
+	uint64_t deadline = (inst->ack_pending) ? inst->ack_deadline : ARQ_NO_DEADLINE;
+
+	for(uint8_t seq = inst->tx_base; (seq != inst->tx_next) && !inst->failed; ++seq) {
+		const ArqTxSlot *const slot = _tx_slot(inst, seq);
+
+		if(!slot->acked && (slot->deadline < deadline)) {
+			deadline = slot->deadline;
+		}
+	}
+
+	return deadline;
+}
+
+/**
+ * @return The number of packets sent that haven't been acknowledged yet (zero
+ *         once everything sent has been delivered).
+ */
+uint8_t arq_in_flight(ArqInst *inst)
+{
+	ASSERT(inst != NULL);
+
+	return (uint8_t)(inst->tx_next - inst->tx_base);
+}
+
+/**
+ * @return True if a packet ran out of retries (see ArqConfig.max_retries). A
+ *         failed connection stops sending and has to be reinitialized with
+ *         arq_init() on both ends.
+ */
+bool arq_failed(ArqInst *inst)
+{
+	ASSERT(inst != NULL);
+
+	return inst->failed;
+}
+
+/**
+ * @return A copy of the connection's statistics.
+ */
+ArqStats arq_get_stats(ArqInst *inst)
+{
+	ASSERT(inst != NULL);
+
+	return inst->stats;
+}
+
+#endif /* ENABLE_ARQ */
@@ -0,0 +1,152 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Reliable, in-order packet transport (selective repeat ARQ) over a lossy
+ * packet link such as an RFM69 radio.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if ENABLE_ARQ
+
+/* Size of the header at the start of every data packet (type and sequence number). */
+#define ARQ_HEADER_SIZE 2U
+
+/* Size of an acknowledgement (type, cumulative ACK and the selective ACK bitmap). */
+#define ARQ_ACK_SIZE 6U
+
+/* Largest packet handed to the link (a data packet with a full payload). */
+#define ARQ_MAX_PACKET (ARQ_HEADER_SIZE + ARQ_MAX_PAYLOAD)
+
+/* Returned by arq_next_deadline() when there's nothing to wait for. */
+#define ARQ_NO_DEADLINE UINT64_MAX
+
+/* Sends a single packet out over the link (which is allowed to lose it). */
+typedef void (*ArqSendFn)(void *arg, const uint8_t *data, uint8_t len);
+
+/* Called with every payload received, in the order they were sent. */
+typedef void (*ArqDeliverFn)(void *arg, const uint8_t *data, uint8_t len);
+
+/* Settings that both ends of a connection need to agree on (see arq_init()). */
+typedef struct {
+	/* Number of packets that can be sent before the oldest one is acknowledged (1 to ARQ_MAX_WINDOW). */
+	uint8_t window;
+
+	/* Cycles to wait for an acknowledgement before resending a packet. */
+	uint32_t retransmit_timeout;
+
+	/**
+	 * Cycles the receiver waits before acknowledging in-order packets, so that
+	 * a burst of packets shares a single acknowledgement. This should be
+	 * longer than it takes to send a packet, but well under retransmit_timeout.
+	 */
+	uint32_t ack_delay;
+
+	/* Number of times a packet gets resent before giving up (0 to retry forever). */
+	uint8_t max_retries;
+} ArqConfig;
+
+/* Statistics kept by each end of a connection. */
+typedef struct {
+	/* Data packets sent for the first time. */
+	uint32_t sent;
+
+	/* Data packets sent again after a timeout or a gap in the selective ACK. */
+	uint32_t retransmits;
+
+	/* Payloads handed to the deliver callback. */
+	uint32_t delivered;
+
+	/* Data packets received more than once (or outside of the window). */
+	uint32_t duplicates;
+
+	/* Acknowledgements sent and received. */
+	uint32_t acks_sent;
+	uint32_t acks_received;
+
+	/* Packets that were too short or of an unknown type. */
+	uint32_t malformed;
+} ArqStats;
+
+/* A sent packet waiting to be acknowledged. */
+typedef struct {
+	/* The packet as it's sent over the link (header included). */
+	uint8_t data[ARQ_MAX_PACKET];
+	uint8_t len;
+
+	/* Number of times the packet has been resent. */
+	uint8_t retries;
+
+	/* True once a selective ACK has covered this packet. */
+	bool acked;
+
+	/* Cycle count (see get_cycles()) to resend the packet at. */
+	uint64_t deadline;
+} ArqTxSlot;
+
+/* A received packet waiting on an earlier (lost) one before it can be delivered. */
+typedef struct {
+	uint8_t data[ARQ_MAX_PAYLOAD];
+	uint8_t len;
+} ArqRxSlot;
+
+/**
+ * One end of a connection. Both ends can send and receive at the same time.
+ * This should be treated as opaque and only accessed through the API exposed
+ * in this header.
+ */
+typedef struct {
+	ArqConfig config;
+
+	ArqSendFn send;
+	void *send_arg;
+
+	ArqDeliverFn deliver;
+	void *deliver_arg;
+
+	/* Oldest unacknowledged sequence number, and the next one to send. */
+	uint8_t tx_base;
+	uint8_t tx_next;
+	ArqTxSlot tx_slots[ARQ_MAX_WINDOW];
+
+	/* Next sequence number to deliver, and which later ones are buffered (bit 0 is rx_next + 1). */
+	uint8_t rx_next;
+	uint32_t rx_buffered;
+	ArqRxSlot rx_slots[ARQ_MAX_WINDOW];
+
+	/* In-order packets received since the last acknowledgement was sent. */
+	uint8_t rx_unacked;
+
+	/* True if an acknowledgement needs to be sent by ack_deadline. */
+	bool ack_pending;
+	uint64_t ack_deadline;
+
+	/* True once a packet ran out of retries. */
+	bool failed;
+
+	ArqStats stats;
+} ArqInst;
+
+void arq_init(
+	ArqInst *inst,
+	const ArqConfig *config,
+	ArqSendFn send,
+	void *send_arg,
+	ArqDeliverFn deliver,
+	void *deliver_arg);
+
+bool arq_send(ArqInst *inst, const uint8_t *data, uint8_t len, uint64_t now);
+void arq_input(ArqInst *inst, const uint8_t *data, uint8_t len, uint64_t now);
+void arq_poll(ArqInst *inst, uint64_t now);
+
+uint64_t arq_next_deadline(ArqInst *inst);
+uint8_t arq_in_flight(ArqInst *inst);
+bool arq_failed(ArqInst *inst);
+ArqStats arq_get_stats(ArqInst *inst);
+
+#endif /* ENABLE_ARQ */
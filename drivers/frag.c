@@ -0,0 +1,386 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Splits messages that are too large for a single packet (like a file sent
+ * over an RFM69 radio) into fragments and puts them back together.
+ *
+ * A CRC-32 (see crc32()) is added to the end of every message, and the result
+ * is cut up into fragments that fill up the link's packets. On the wire, a
+ * fragment looks like:
+ *
+ *     message ID | offset (16-bit) | total length (16-bit) | data
+ *
+ * Both 16-bit fields are little endian, and the total length includes the CRC.
+ * Every fragment except the last one carries the same amount of data, so the
+ * receiver can tell which fragments it already has from their offsets. That
+ * lets fragments arrive out of order or more than once (e.g., resent because
+ * an acknowledgement was lost).
+ *
+ * Messages are reassembled into buffers from a fixed-size pool. A message that
+ * goes for too long without receiving a new fragment (its sender gave up, or
+ * a fragment was lost on a link without retries) gets thrown away so it
+ * doesn't hold onto its buffer forever.
+ *
+ * Like drivers/arq.c, nothing in here touches hardware or reads the time on
+ * its own. Fragments are sent through a callback, so they can go straight out
+ * of the radio (rfm69_send()), get acknowledged one at a time
+ * (rfm69_send_with_ack()), or go through an ARQ connection (arq_send()).
+ */
+#include "config.h"
+#include "crc.h"
+#include "debug.h"
+#include "frag.h"
+#include "os/zone_alloc.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if ENABLE_FRAGMENTATION
+
+_Static_assert((FRAG_MAX_MESSAGE + FRAG_CRC_SIZE) <= UINT16_MAX,
+               "FRAG_MAX_MESSAGE is too large for the 16-bit offsets");
+
+/* Pool of messages used for reassembly. */
+ZONE_DEFINE(frag_message, sizeof(FragMessage), FRAG_POOL_SIZE);
+
+/**
+ * Allocate a message from the reassembly pool.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @return The message, or NULL if the pool is empty.
+ */
+FragMessage * frag_message_alloc(void)
+{
+	return (FragMessage*)zone_alloc(&frag_message_zone);
+}
+
+/**
+ * Return a message (e.g., one returned by frag_input()) to the reassembly pool.
+ *
+ * @note Safe to call from ISRs.
+ */
+void frag_message_free(FragMessage *msg)
+{
+	zone_free(&frag_message_zone, msg);
+}
+
+/**
+ * Initialize one end of a fragmented link.
+ *
+ * @param inst The instance to initialize.
+ * @param send Sends a single fragment over the link.
+ * @param send_arg Passed into "send".
+ * @param max_packet Largest packet the link can carry (e.g.,
+ *                   RFM69_FIFO_PAYLOAD_LEN or ARQ_MAX_PAYLOAD).
+ * @param timeout Number of CPU cycles an incomplete message can go without
+ *                receiving a fragment before it's thrown away.
+ */
+void frag_init(FragInst *inst, FragSendFn send, void *send_arg, uint8_t max_packet, uint32_t timeout)
+{
+	ASSERT(inst != NULL);
+	ASSERT(send != NULL);
+	ASSERT(max_packet > FRAG_HEADER_SIZE);
+
+	inst->send = send;
+	inst->send_arg = send_arg;
+	inst->max_packet = max_packet;
+	inst->timeout = timeout;
+	inst->next_id = 0;
+	inst->pending = NULL;
+	inst->last_id = 0;
+	inst->last_id_deadline = 0;
+	inst->have_last_id = false;
+	inst->stats = (FragStats) { 0 };
+}
+
+/**
+ * Split up a message and send every fragment of it.
+ *
+ * @param inst The link to send over.
+ * @param data The message to send.
+ * @param len The length of the message (no more than FRAG_MAX_MESSAGE).
+ *
+ * @return True if every fragment was sent, false if the send function gave up
+ *         on one of them or the message needs more than FRAG_MAX_FRAGMENTS
+ *         fragments (nothing gets sent in that case).
+ */
+bool frag_send(FragInst *inst, const uint8_t *data, uint16_t len)
+{
+	ASSERT(inst != NULL);
+	ASSERT((data != NULL) || (len == 0));
+	ASSERT(len <= FRAG_MAX_MESSAGE);
+
+	const uint32_t crc = crc32(CRC32_INIT, data, len);
+	const uint8_t crc_bytes[FRAG_CRC_SIZE] = {
+		(uint8_t)crc,
+		(uint8_t)(crc >> 8),
+		(uint8_t)(crc >> 16),
+		(uint8_t)(crc >> 24)
+	};
+
+	const uint16_t total = len + FRAG_CRC_SIZE;
+	const uint8_t frag_size = inst->max_packet - FRAG_HEADER_SIZE;
+
+	/**
+	 * The receiver can only keep track of so many fragments per message, and
+	 * would throw away every fragment past that (so the message could never
+	 * complete). A small max_packet makes for lots of fragments.
+	 */
+	if(((total + frag_size - 1U) / frag_size) > FRAG_MAX_FRAGMENTS) {
+		dblog("[FRAG] A %u byte message needs too many fragments\n", len);
+		return false;
+	}
+
+	const uint8_t id = inst->next_id++;
+
+	uint8_t packet[UINT8_MAX];
+	for(uint16_t offset = 0; offset < total; offset += frag_size) {
+		const uint16_t size = ((total - offset) < frag_size) ? (total - offset) : frag_size;
+		uint8_t *const payload = &packet[FRAG_HEADER_SIZE];
+
+		packet[0] = id;
+		packet[1] = (uint8_t)offset;
+		packet[2] = (uint8_t)(offset >> 8);
+		packet[3] = (uint8_t)total;
+		packet[4] = (uint8_t)(total >> 8);
+
+		/* The CRC can end up split across the last two fragments. */
+		const uint16_t data_size = (offset >= len) ? 0 : ((len - offset) < size) ? (len - offset) : size;
+		if(data_size > 0) {
+			memcpy(payload, &data[offset], data_size);
+		}
+
+		if(size > data_size) {
+			memcpy(&payload[data_size], &crc_bytes[(offset + data_size) - len], size - data_size);
+		}
+
+		if(!inst->send(inst->send_arg, packet, (uint8_t)(FRAG_HEADER_SIZE + size))) {
+			dblog("[FRAG] Gave up on message %u at offset %u\n", id, offset);
+			return false;
+		}
+	}
+
+	inst->stats.sent++;
+	return true;
+}
+
+/* Take a message off of the list of messages being reassembled. */
+static void _remove_pending(FragInst *inst, FragMessage *msg)
+{
+	FragMessage **link = &inst->pending;
+
+	while(*link != msg) {
+		link = &(*link)->next;
+	}
+
+	*link = msg->next;
+}
+
+/**
+ * Find the message a fragment belongs to, or start reassembling a new one.
+ *
+ * @return The message, or NULL if the reassembly pool is empty.
+ */
+static FragMessage * _get_message(FragInst *inst, uint8_t id, uint16_t total, uint64_t now)
+{
+	for(FragMessage *msg = inst->pending; msg != NULL; msg = msg->next) {
+		if(msg->id == id) {
+			return msg;
+		}
+	}
+
+	FragMessage *const msg = frag_message_alloc();
+	if(msg == NULL) {
+		return NULL;
+	}
+
+	msg->id = id;
+	msg->frag_size = 0;
+	msg->have_last = false;
+	msg->len = total;
+	msg->received = 0;
+	msg->deadline = now + inst->timeout;
+	memset(msg->frags, 0, sizeof(msg->frags));
+
+	msg->next = inst->pending;
+	inst->pending = msg;
+
+	return msg;
+}
+
+/**
+ * Mark a fragment as received.
+ *
+ * @return True if the fragment is new, false if it's a duplicate or it doesn't
+ *         line up with the rest of the message's fragments.
+ */
+static bool _mark_fragment(FragInst *inst, FragMessage *msg, uint16_t offset, uint16_t size)
+{
+	if((offset + size) == msg->len) {
+		if(msg->have_last) {
+			inst->stats.duplicates++;
+			return false;
+		}
+
+		msg->have_last = true;
+		return true;
+	}
+
+	/* Every other fragment has to be the same size. */
+	if(msg->frag_size == 0) {
+		msg->frag_size = (uint8_t)size;
+	}
+
+	const uint16_t index = offset / size;
+
+	if((size != msg->frag_size) || ((offset % size) != 0) || (index >= FRAG_MAX_FRAGMENTS)) {
+		inst->stats.format_errors++;
+		return false;
+	}
+
+	if(msg->frags[index / 32U] & (1UL << (index % 32U))) {
+		inst->stats.duplicates++;
+		return false;
+	}
+
+	msg->frags[index / 32U] |= (1UL << (index % 32U));
+	return true;
+}
+
+/**
+ * Process a fragment received over the link.
+ *
+ * @param inst The link the fragment was received on.
+ * @param data The fragment.
+ * @param len The length of the fragment.
+ * @param now The current cycle count (see get_cycles()).
+ *
+ * @return The message if this fragment completed it (free it with
+ *         frag_message_free()), otherwise NULL.
+ */
+FragMessage * frag_input(FragInst *inst, const uint8_t *data, uint8_t len, uint64_t now)
+{
+	ASSERT(inst != NULL);
+	ASSERT((data != NULL) || (len == 0));
+
+	frag_poll(inst, now);
+
+	if(len <= FRAG_HEADER_SIZE) {
+		inst->stats.format_errors++;
+		return NULL;
+	}
+
+	const uint8_t id = data[0];
+	const uint16_t offset = (uint16_t)(data[1] | (data[2] << 8));
+	const uint16_t total = (uint16_t)(data[3] | (data[4] << 8));
+	const uint16_t size = len - FRAG_HEADER_SIZE;
+
+	if((total < FRAG_CRC_SIZE) ||
+	   (total > (FRAG_MAX_MESSAGE + FRAG_CRC_SIZE)) ||
+	   (((uint32_t)offset + size) > total)) {
+		inst->stats.format_errors++;
+		return NULL;
+	}
+
+	/* A fragment of a message that was just completed got resent. */
+	if(inst->have_last_id && (id == inst->last_id)) {
+		inst->stats.duplicates++;
+		return NULL;
+	}
+
+	FragMessage *const msg = _get_message(inst, id, total, now);
+	if(msg == NULL) {
+		inst->stats.no_message++;
+		return NULL;
+	}
+
+	if(msg->len != total) {
+		inst->stats.format_errors++;
+		return NULL;
+	}
+
+	if(!_mark_fragment(inst, msg, offset, size)) {
+		return NULL;
+	}
+
+	memcpy(&msg->data[offset], &data[FRAG_HEADER_SIZE], size);
+	msg->received += size;
+	msg->deadline = now + inst->timeout;
+
+	if(msg->received < msg->len) {
+		return NULL;
+	}
+
+	/* Every fragment is in, so the message now belongs to the caller (if it's intact). */
+	_remove_pending(inst, msg);
+
+	inst->last_id = id;
+	inst->last_id_deadline = now + inst->timeout;
+	inst->have_last_id = true;
+
+	msg->len -= FRAG_CRC_SIZE;
+	const uint32_t crc = (uint32_t)msg->data[msg->len] |
+	                     ((uint32_t)msg->data[msg->len + 1U] << 8) |
+	                     ((uint32_t)msg->data[msg->len + 2U] << 16) |
+	                     ((uint32_t)msg->data[msg->len + 3U] << 24);
+
+	if(crc != crc32(CRC32_INIT, msg->data, msg->len)) {
+		inst->stats.crc_errors++;
+		frag_message_free(msg);
+		return NULL;
+	}
+
+	inst->stats.received++;
+	return msg;
+}
+
+/**
+ * Throw away any incomplete messages that have timed out. This gets called by
+ * frag_input(), but should also be called periodically in case fragments
+ * stop arriving altogether.
+ *
+ * @param inst The link to update.
+ * @param now The current cycle count (see get_cycles()).
+ */
+void frag_poll(FragInst *inst, uint64_t now)
+{
+	ASSERT(inst != NULL);
+
+	/* By now the sender has moved on, so the ID can be reused. */
+	if(inst->have_last_id && (inst->last_id_deadline <= now)) {
+		inst->have_last_id = false;
+	}
+
+	FragMessage **link = &inst->pending;
+
+	while(*link != NULL) {
+		FragMessage *const msg = *link;
+
+		if(msg->deadline > now) {
+			link = &msg->next;
+			continue;
+		}
+
+		dblog("[FRAG] Message %u timed out with %u/%u bytes\n", msg->id, msg->received, msg->len);
+
+		*link = msg->next;
+		inst->stats.timeouts++;
+		frag_message_free(msg);
+	}
+}
+
+/**
+ * @return A copy of the link's statistics.
+ */
+FragStats frag_get_stats(FragInst *inst)
+{
+	ASSERT(inst != NULL);
+
+	return inst->stats;
+}
+
+#endif /* ENABLE_FRAGMENTATION */
@@ -0,0 +1,125 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Splits messages that are too large for a single packet (like a file sent
+ * over an RFM69 radio) into fragments and puts them back together.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if ENABLE_FRAGMENTATION
+
+/* Size of the header at the start of every fragment (message ID, offset and total length). */
+#define FRAG_HEADER_SIZE 5U
+
+/* Size of the CRC-32 sent after the end of every message (little endian). */
+#define FRAG_CRC_SIZE 4U
+
+/**
+ * Sends a single fragment over the link (e.g., rfm69_send_with_ack() or
+ * arq_send()).
+ *
+ * @return True if the fragment was sent, false to give up on the message.
+ */
+typedef bool (*FragSendFn)(void *arg, const uint8_t *data, uint8_t len);
+
+/* A message from the reassembly pool. */
+typedef struct FragMessage {
+	/* Next message being reassembled (only used while the message is incomplete). */
+	struct FragMessage *next;
+
+	/* ID of the message (the sender increments this for every message). */
+	uint8_t id;
+
+	/* Size of every fragment except the last (zero until one has been received). */
+	uint8_t frag_size;
+
+	/* True once the last fragment has been received. */
+	bool have_last;
+
+	/* Number of valid bytes in "data" (once the message is complete). */
+	uint16_t len;
+
+	/* Number of bytes received so far (including the CRC). */
+	uint16_t received;
+
+	/* Cycle count (see get_cycles()) to give up on an incomplete message at. */
+	uint64_t deadline;
+
+	/* Which fragments (other than the last) have been received. */
+	uint32_t frags[(FRAG_MAX_FRAGMENTS + 31U) / 32U];
+
+	/* The message (with room for the CRC while it's being reassembled). */
+	uint8_t data[FRAG_MAX_MESSAGE + FRAG_CRC_SIZE];
+} FragMessage;
+
+/* Statistics kept by each end of a link. */
+typedef struct {
+	/* Messages sent and received intact. */
+	uint32_t sent;
+	uint32_t received;
+
+	/* Fragments received more than once (or for a message that was already completed). */
+	uint32_t duplicates;
+
+	/* Messages thrown away because of a CRC mismatch. */
+	uint32_t crc_errors;
+
+	/* Fragments thrown away because they were malformed or didn't fit their message. */
+	uint32_t format_errors;
+
+	/* Messages thrown away because they weren't completed in time. */
+	uint32_t timeouts;
+
+	/* Fragments thrown away because the reassembly pool was empty. */
+	uint32_t no_message;
+} FragStats;
+
+/**
+ * One end of a fragmented link. This should be treated as opaque and only
+ * accessed through the API exposed in this header.
+ */
+typedef struct {
+	FragSendFn send;
+	void *send_arg;
+
+	/* Largest packet the link can carry (header included). */
+	uint8_t max_packet;
+
+	/* Cycles an incomplete message can go without a new fragment before it's thrown away. */
+	uint32_t timeout;
+
+	/* ID of the next message to send. */
+	uint8_t next_id;
+
+	/* Messages being reassembled. */
+	FragMessage *pending;
+
+	/**
+	 * ID of the last message completed, so late duplicates of its fragments
+	 * get ignored (until last_id_deadline).
+	 */
+	uint8_t last_id;
+	bool have_last_id;
+	uint64_t last_id_deadline;
+
+	FragStats stats;
+} FragInst;
+
+FragMessage * frag_message_alloc(void);
+void frag_message_free(FragMessage *msg);
+
+void frag_init(FragInst *inst, FragSendFn send, void *send_arg, uint8_t max_packet, uint32_t timeout);
+
+bool frag_send(FragInst *inst, const uint8_t *data, uint16_t len);
+FragMessage * frag_input(FragInst *inst, const uint8_t *data, uint8_t len, uint64_t now);
+void frag_poll(FragInst *inst, uint64_t now);
+
+FragStats frag_get_stats(FragInst *inst);
+
+#endif /* ENABLE_FRAGMENTATION */
@@ -0,0 +1,322 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Framed binary packets (COBS encoded with a CRC-16) sent over a USART.
+ *
+ * Each payload gets a CRC-16 (see crc16()) appended to it and the result is
+ * encoded with Consistent Overhead Byte Stuffing (COBS). COBS replaces every
+ * zero byte with the distance to the next one, which frees up zero to be used
+ * as a frame delimiter at the cost of one extra byte per 254 bytes of data.
+ * A receiver that loses sync (or starts listening mid-frame) only has to wait
+ * for the next zero byte to recover.
+ *
+ * On the wire, a frame looks like:
+ *
+ *     COBS(payload | CRC-16 low byte | CRC-16 high byte) | 0x00
+ *
+ * Frames are encoded straight into the USART's TX ring (see usart_tx_reserve())
+ * and decoded straight out of its RX ring (see usart_rx_peek()), so a payload
+ * is only ever copied once in each direction. Received frames are decoded into
+ * packets from a fixed-size pool.
+ *
+ * tools/frame_tool.py decodes frames on the host side.
+ */
+#include "config.h"
+#include "crc.h"
+#include "debug.h"
+#include "frame.h"
+#include "os/zone_alloc.h"
+#include "usart.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if ENABLE_FRAMING
+
+/* Largest COBS code byte (a block of 254 non-zero bytes with no zero after it). */
+#define COBS_MAX_CODE 0xFFU
+
+/* Pool of packets handed out to the frame decoders. */
+ZONE_DEFINE(frame_packet, sizeof(FramePacket), FRAME_POOL_SIZE);
+
+/**
+ * Allocate a packet from the packet pool.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @return The packet, or NULL if the pool is empty.
+ */
+FramePacket * frame_packet_alloc(void)
+{
+	return (FramePacket*)zone_alloc(&frame_packet_zone);
+}
+
+/**
+ * Return a packet (e.g., one returned by frame_receive()) to the packet pool.
+ *
+ * @note Safe to call from ISRs.
+ */
+void frame_packet_free(FramePacket *packet)
+{
+	zone_free(&frame_packet_zone, packet);
+}
+
+/**
+ * COBS encode a payload and its CRC into a buffer and terminate the frame.
+ *
+ * The output doesn't have to be contiguous: byte "i" of the frame is written to
+ * out[(start + i) & mask]. Pass in a mask of UINT32_MAX for a plain buffer.
+ *
+ * @return The number of bytes written.
+ */
+static uint32_t _encode(
+	const uint8_t *payload,
+	uint32_t len,
+	uint8_t *out,
+	uint32_t start,
+	uint32_t mask)
+{
+	const uint16_t crc = crc16(CRC16_INIT, payload, len);
+	const uint8_t crc_bytes[FRAME_CRC_SIZE] = { (uint8_t)crc, (uint8_t)(crc >> 8) };
+
+	/* Each block's code byte gets filled in once the block's length is known. */
+	uint32_t code_pos = start;
+	uint32_t pos = start + 1U;
+	uint8_t code = 1;
+
+	for(uint32_t i = 0; i < (len + FRAME_CRC_SIZE); ++i) {
+		const uint8_t byte = (i < len) ? payload[i] : crc_bytes[i - len];
+
+		if(byte != 0) {
+			out[pos++ & mask] = byte;
+			code++;
+		}
+
+		if((byte == 0) || (code == COBS_MAX_CODE)) {
+			out[code_pos & mask] = code;
+			code_pos = pos++;
+			code = 1;
+		}
+	}
+
+	out[code_pos & mask] = code;
+	out[pos++ & mask] = FRAME_DELIMITER;
+
+	return pos - start;
+}
+
+/**
+ * Encode a payload into a frame.
+ *
+ * @param payload The payload to encode.
+ * @param len The length of the payload (no more than FRAME_MAX_PAYLOAD).
+ * @param out Where to write the frame.
+ * @param out_size The size of "out" (at least FRAME_ENCODED_SIZE(len)).
+ *
+ * @return The length of the frame (including the delimiter).
+ */
+size_t frame_encode(const uint8_t *payload, size_t len, uint8_t *out, __assert_only size_t out_size)
+{
+	ASSERT(len <= FRAME_MAX_PAYLOAD);
+	ASSERT(out_size >= FRAME_ENCODED_SIZE(len));
+
+	return _encode(payload, (uint32_t)len, out, 0, UINT32_MAX);
+}
+
+/**
+ * Encode a payload straight into a buffered USART's TX ring and send it. The
+ * calling task blocks until there's room in the ring for the frame.
+ *
+ * @note Only one task should send frames over a given USART, and nothing else
+ *       can write to that USART while a frame is being encoded.
+ *
+ * @param usart The USART to send the frame over (see usart_enable_buffering()).
+ * @param payload The payload to send.
+ * @param len The length of the payload (no more than FRAME_MAX_PAYLOAD).
+ */
+void frame_send(UsartReg *usart, const uint8_t *payload, uint32_t len)
+{
+	ASSERT(len <= FRAME_MAX_PAYLOAD);
+
+	UsartTxSpace space;
+	usart_tx_reserve(usart, FRAME_ENCODED_SIZE(len), &space);
+	usart_tx_commit(usart, _encode(payload, len, space.buf, space.start, space.mask));
+}
+
+/**
+ * Initialize a frame decoder.
+ */
+void frame_decoder_init(FrameDecoder *decoder)
+{
+	ASSERT(decoder != NULL);
+
+	decoder->packet = NULL;
+	decoder->code = 0;
+	decoder->remaining = 0;
+	decoder->discard = false;
+	decoder->stats = (FrameStats) { 0 };
+}
+
+/**
+ * Add a decoded byte to the current packet. Frames that don't fit in a packet
+ * get thrown away.
+ */
+static void _append(FrameDecoder *decoder, uint8_t byte)
+{
+	FramePacket *const packet = decoder->packet;
+
+	if(packet->len >= sizeof(packet->data)) {
+		decoder->stats.format_errors++;
+		decoder->discard = true;
+		return;
+	}
+
+	packet->data[packet->len++] = byte;
+}
+
+/**
+ * Called at the end of every frame. Checks the frame's CRC and resets the
+ * decoder for the next frame.
+ *
+ * @return The decoded packet if the frame was valid, otherwise NULL.
+ */
+static FramePacket * _end_frame(FrameDecoder *decoder)
+{
+	FramePacket *packet = decoder->packet;
+	const bool empty = (decoder->code == 0);
+	const bool discard = decoder->discard;
+	const bool complete = (decoder->remaining == 0);
+
+	decoder->code = 0;
+	decoder->remaining = 0;
+	decoder->discard = false;
+
+	/* Empty frames (back-to-back delimiters) are used to resync, so just skip them. */
+	if((packet == NULL) || empty) {
+		return NULL;
+	}
+
+	/* Thrown away frames were already counted when the problem was found. */
+	if(discard || !complete || (packet->len < FRAME_CRC_SIZE)) {
+		decoder->stats.format_errors += (discard) ? 0U : 1U;
+		packet->len = 0;
+		return NULL;
+	}
+
+	packet->len -= FRAME_CRC_SIZE;
+	const uint16_t crc = (uint16_t)(packet->data[packet->len] |
+	                                (packet->data[packet->len + 1U] << 8));
+
+	if(crc != crc16(CRC16_INIT, packet->data, packet->len)) {
+		decoder->stats.crc_errors++;
+		packet->len = 0;
+		return NULL;
+	}
+
+	/* The packet now belongs to the caller. */
+	decoder->stats.frames++;
+	decoder->packet = NULL;
+
+	return packet;
+}
+
+/**
+ * Feed received bytes into a frame decoder. Decoding stops at the end of the
+ * first valid frame, so call this again with the rest of the bytes.
+ *
+ * @param decoder The decoder to use.
+ * @param data The received bytes.
+ * @param len The number of received bytes.
+ * @param consumed Set to the number of bytes that were used up.
+ *
+ * @return A packet holding the frame's payload (free it with
+ *         frame_packet_free()), or NULL if every byte got used up without
+ *         completing a valid frame.
+ */
+FramePacket * frame_decode(FrameDecoder *decoder, const uint8_t *data, uint32_t len, uint32_t *consumed)
+{
+	ASSERT(decoder != NULL);
+	ASSERT(consumed != NULL);
+
+	for(uint32_t i = 0; i < len; ++i) {
+		const uint8_t byte = data[i];
+
+		if(byte == FRAME_DELIMITER) {
+			FramePacket *const packet = _end_frame(decoder);
+
+			if(packet != NULL) {
+				*consumed = i + 1U;
+				return packet;
+			}
+
+			continue;
+		}
+
+		if(decoder->discard) {
+			continue;
+		}
+
+		if(decoder->packet == NULL) {
+			decoder->packet = frame_packet_alloc();
+
+			if(decoder->packet == NULL) {
+				decoder->stats.no_packet++;
+				decoder->discard = true;
+				continue;
+			}
+
+			decoder->packet->len = 0;
+		}
+
+		if(decoder->remaining == 0) {
+			/* Every block except the last and maximum length ones ended in a zero. */
+			if((decoder->code != 0) && (decoder->code != COBS_MAX_CODE)) {
+				_append(decoder, 0);
+			}
+
+			decoder->code = byte;
+			decoder->remaining = (uint8_t)(byte - 1U);
+		} else {
+			_append(decoder, byte);
+			decoder->remaining--;
+		}
+	}
+
+	*consumed = len;
+	return NULL;
+}
+
+/**
+ * Wait for a valid frame to arrive on a buffered USART. Frames are decoded
+ * directly out of the USART's RX ring.
+ *
+ * @param usart The USART to receive from (see usart_enable_buffering()).
+ * @param decoder The decoder used for this USART.
+ *
+ * @return A packet holding the frame's payload (free it with
+ *         frame_packet_free()).
+ */
+FramePacket * frame_receive(UsartReg *usart, FrameDecoder *decoder)
+{
+	while(1) {
+		const uint8_t *data = NULL;
+		const uint32_t len = usart_rx_peek(usart, &data);
+
+		if(len == 0) {
+			usart_rx_wait(usart);
+			continue;
+		}
+
+		uint32_t consumed = 0;
+		FramePacket *const packet = frame_decode(decoder, data, len, &consumed);
+		usart_rx_consume(usart, consumed);
+
+		if(packet != NULL) {
+			return packet;
+		}
+	}
+}
+
+#endif /* ENABLE_FRAMING */
@@ -0,0 +1,85 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Framed binary packets (COBS encoded with a CRC-16) sent over a USART.
+ */
+#pragma once
+
+#include "config.h"
+#include "usart.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if ENABLE_FRAMING
+
+/* Size of the CRC appended to every payload (sent little endian). */
+#define FRAME_CRC_SIZE 2U
+
+/* Byte that marks the end of every frame (never appears inside a frame). */
+#define FRAME_DELIMITER 0x00U
+
+/**
+ * The most bytes a payload of "len" bytes can take up on the wire: the CRC, one
+ * COBS code byte per 254 bytes (plus the first one), and the delimiter.
+ */
+#define FRAME_ENCODED_SIZE(len) \
+	((len) + FRAME_CRC_SIZE + (((len) + FRAME_CRC_SIZE) / 254U) + 2U)
+
+/* A packet from the packet pool. */
+typedef struct {
+	/* Number of valid bytes in "data". */
+	uint16_t len;
+
+	/* The payload (with room for the CRC while the frame is being decoded). */
+	uint8_t data[FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE];
+} FramePacket;
+
+/* Statistics kept by each frame decoder. */
+typedef struct {
+	/* Frames received intact. */
+	uint32_t frames;
+
+	/* Frames thrown away because of a CRC mismatch. */
+	uint32_t crc_errors;
+
+	/* Frames thrown away because they were malformed or too long. */
+	uint32_t format_errors;
+
+	/* Frames thrown away because the packet pool was empty. */
+	uint32_t no_packet;
+} FrameStats;
+
+/**
+ * Decodes a stream of received bytes into packets. This should be treated as
+ * opaque and only accessed through the API exposed in this header.
+ */
+typedef struct {
+	/* The packet the current frame is being decoded into (NULL if none yet). */
+	FramePacket *packet;
+
+	/* Code byte of the current COBS block (zero at the start of a frame). */
+	uint8_t code;
+
+	/* Bytes left in the current COBS block. */
+	uint8_t remaining;
+
+	/* True if the rest of the current frame should be ignored. */
+	bool discard;
+
+	FrameStats stats;
+} FrameDecoder;
+
+FramePacket * frame_packet_alloc(void);
+void frame_packet_free(FramePacket *packet);
+
+size_t frame_encode(const uint8_t *payload, size_t len, uint8_t *out, size_t out_size);
+void frame_send(UsartReg *usart, const uint8_t *payload, uint32_t len);
+
+void frame_decoder_init(FrameDecoder *decoder);
+FramePacket * frame_decode(FrameDecoder *decoder, const uint8_t *data, uint32_t len, uint32_t *consumed);
+FramePacket * frame_receive(UsartReg *usart, FrameDecoder *decoder);
+
+#endif /* ENABLE_FRAMING */
@@ -138,9 +138,7 @@ void nokia_init(
 
 /**
  * Return a pointer to the SPI instance used by this nokia instance. This is
- * useful for setting a software managed slave select pin or reconfiguring the
- * underlying SPI module between transactions when multiple devices are using
- * the same SPI interface.
+ * useful for setting a software managed slave select pin.
  *
  * @param inst The nokia5110 instance to extract the SPI instance from.
  *
@@ -161,20 +159,15 @@ SpiInst* nokia_get_spi_inst(Nokia5110Inst *inst)
  * @param cmds Array of commands to send to the display.
  * @param num_cmds Number of commands in the cmds array.
  */
-static void nokia_send_cmds(Nokia5110Inst *inst, bool dc, const uint8_t *cmds, uint8_t num_cmds)
+static void nokia_send_cmds(Nokia5110Inst *inst, bool dc, const uint8_t *cmds, uint16_t num_cmds)
 {
 	ASSERT(inst != NULL);
 
 	/* Set the Command/Data line. */
 	gpio_set_output(inst->dc_reg, inst->dc_pin, dc ? GPIO_HIGH : GPIO_LOW);
 
-	spi_enable(&inst->spi);
-
-	for(int i = 0; i < num_cmds; ++i) {
-		spi_write(&inst->spi, cmds[i]);
-	}
-
-	spi_disable(&inst->spi);
+	/* Longer updates get sent using DMA if it's been enabled on the SPI module. */
+	spi_transaction(&inst->spi, cmds, NULL, num_cmds);
 }
 
 /**
@@ -230,12 +223,10 @@ void nokia_clear_screen(Nokia5110Inst *inst)
 
 	nokia_send_cmds(inst, false, cmds, sizeof(cmds) / sizeof(cmds[0]));
 
-	/* Clear out every column of data on the screen. */
-	const uint8_t zero = 0;
-	for(unsigned int x = 0; x < NOKIA_WIDTH_PIXELS; x++) {
-		for(unsigned int y = 0; y < NOKIA_HEIGHT_BANKS; ++y) {
-			nokia_send_cmds(inst, true, &zero, 1);
-		}
+	/* Clear out every column of data on the screen (one bank at a time). */
+	static const uint8_t zeroes[NOKIA_WIDTH_PIXELS] = { 0 };
+	for(unsigned int y = 0; y < NOKIA_HEIGHT_BANKS; ++y) {
+		nokia_set_columns(inst, zeroes, NOKIA_WIDTH_PIXELS);
 	}
 }
 
@@ -270,3 +261,20 @@ void nokia_set_column(Nokia5110Inst *inst, uint8_t data)
 {
 	nokia_send_cmds(inst, true, &data, 1);
 }
+
+/**
+ * Send multiple columns of pixels to the screen starting at the current
+ * position. The position moves one column to the right after every column (and
+ * wraps around to the start of the next bank at the end of a bank).
+ *
+ * @param inst The nokia instance to display onto.
+ * @param data The columns of pixels to send to the screen.
+ * @param num_columns The number of columns to send.
+ */
+void nokia_set_columns(Nokia5110Inst *inst, const uint8_t *data, uint16_t num_columns)
+{
+	ASSERT(data != NULL);
+	ASSERT(num_columns <= (NOKIA_WIDTH_PIXELS * NOKIA_HEIGHT_BANKS));
+
+	nokia_send_cmds(inst, true, data, num_columns);
+}
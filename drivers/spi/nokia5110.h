@@ -69,3 +69,4 @@ void nokia_clear_screen(Nokia5110Inst *inst);
 
 void nokia_set_position(Nokia5110Inst *inst, uint8_t column, uint8_t bank);
 void nokia_set_column(Nokia5110Inst *inst, uint8_t data);
+void nokia_set_columns(Nokia5110Inst *inst, const uint8_t *data, uint16_t num_columns);
@@ -53,9 +53,7 @@ void jstk_init(PmodJstkInst *inst, SpiReg *spi_reg)
 
 /**
  * Return a pointer to the SPI instance used by this joystick instance. This is
- * useful for setting a software managed slave select pin or reconfiguring the
- * underlying SPI module between transactions when multiple devices are using
- * the same SPI interface.
+ * useful for setting a software managed slave select pin.
  *
  * @param inst The joystick instance to extract the SPI instance from.
  *
@@ -80,7 +78,8 @@ static void jstk_spi_transfer(PmodJstkInst *inst, uint8_t *data)
 {
 	ASSERT(inst != NULL);
 
-	spi_enable(&inst->spi);
+	/* Asserts the slave select line and keeps other devices off the bus. */
+	spi_bus_acquire(&inst->spi);
 
 	/* Must wait 15uS after slave select line gets asserted. */
 	sleep(USECS(15));
@@ -90,7 +89,7 @@ static void jstk_spi_transfer(PmodJstkInst *inst, uint8_t *data)
 		sleep(USECS(10)); /* Must wait 10uS between reading bytes. */
 	}
 
-	spi_disable(&inst->spi);
+	spi_bus_release(&inst->spi);
 
 	/* Must wait 25uS after de-asserting SS line before it can get asserted again. */
 	sleep(USECS(25));
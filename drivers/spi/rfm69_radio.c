@@ -9,13 +9,23 @@
 #include "config.h"
 #include "debug.h"
 #include "gpio.h"
+#include "os/sw_timer.h"
+#include "os/task.h"
 #include "spi.h"
 #include "spi/rfm69_radio.h"
 #include "spi/rfm69_radio_reg.h"
+#include "system.h"
 #include "system_timer.h"
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+
+_Static_assert((RFM69_RX_QUEUE_LEN & (RFM69_RX_QUEUE_LEN - 1U)) == 0,
+               "RFM69_RX_QUEUE_LEN must be a power of two");
+_Static_assert((RFM69_RX_BUF_SIZE >= (RFM69_FIFO_PAYLOAD_LEN + 1U)) &&
+               ((RFM69_RX_BUF_SIZE % DCACHE_LINE_SIZE) == 0),
+               "RFM69_RX_BUF_SIZE must hold a payload and be whole cache lines");
 
 /* Maximum amount of time to wait when switching radio modes. */
 #define RFM69_MODE_CHANGE_TIMEOUT MSECS(1)
@@ -23,11 +33,60 @@
 /* Magic value sent as a single-byte packet during an acknowledgement. */
 #define RFM69_ACK_MAGIC 0x42U
 
+/* Size of the radio's internal FIFO in bytes. */
+#define RFM69_FIFO_SIZE 66U
+
+/**
+ * FifoLevel is set while the FIFO holds more than this many bytes. Long packets
+ * are streamed through the FIFO in chunks of about this size, so it's kept near
+ * the middle to leave equal slack for refilling (TX) and draining (RX).
+ */
+#define RFM69_FIFO_THRESHOLD 32U
+
+/* Bytes sent along with every payload besides the preamble (a two byte sync word and CRC). */
+#define RFM69_PACKET_OVERHEAD 4U
+
+/* Frequency of the radio's crystal oscillator. */
+#define RFM69_FXOSC 32000000U
+
+/* The carrier frequency and deviation are set in steps of FXOSC / 2^19 (about 61Hz). */
+#define RFM69_FSTEP_SHIFT 19U
+
+/* Limits of the FSK modem (see rfm69_set_modem()). */
+#define RFM69_MIN_BITRATE 1200U
+#define RFM69_MAX_BITRATE 300000U
+#define RFM69_MAX_FDEV 300000U
+#define RFM69_MAX_RXBW 500000U
+
+/**
+ * DC offset canceller cutoff, kept at about 4% of the receiver bandwidth as
+ * recommended by the datasheet (Fc = 4 * RxBw / (2 * pi * 2^(DccFreq + 2))).
+ */
+#define RFM69_DCC_FREQ 2U
+
+/**
+ * Settings for each Rfm69ModemPreset. Slow presets use a deviation of twice
+ * the bitrate to leave room for crystal error in the narrow bandwidths. The
+ * fastest ones get an extra preamble byte, since the receiver takes about the
+ * same amount of time to settle no matter the bitrate.
+ */
+static const Rfm69ModemConfig _modem_presets[] = {
+	[RFM69_MODEM_4800]   = { .bitrate = 4800,   .fdev = 9600,   .preamble_len = 3 },
+	[RFM69_MODEM_9600]   = { .bitrate = 9600,   .fdev = 19200,  .preamble_len = 3 },
+	[RFM69_MODEM_19200]  = { .bitrate = 19200,  .fdev = 38400,  .preamble_len = 3 },
+	[RFM69_MODEM_38400]  = { .bitrate = 38400,  .fdev = 76800,  .preamble_len = 3 },
+	[RFM69_MODEM_57600]  = { .bitrate = 57600,  .fdev = 120000, .preamble_len = 3 },
+	[RFM69_MODEM_115200] = { .bitrate = 115200, .fdev = 115200, .preamble_len = 3 },
+	[RFM69_MODEM_250000] = { .bitrate = 250000, .fdev = 250000, .preamble_len = 4 },
+	[RFM69_MODEM_300000] = { .bitrate = 300000, .fdev = 200000, .preamble_len = 4 }
+};
+
+/* Timeout used to wait for an event with no time limit. */
+#define RFM69_WAIT_FOREVER UINT64_MAX
+
 /**
  * Return a pointer to the SPI instance used by this rfm69 instance. This is
- * useful for setting a software managed slave select pin or reconfiguring the
- * underlying SPI module between transactions when multiple devices are using
- * the same SPI interface.
+ * useful for setting a software managed slave select pin.
  *
  * @param inst The rfm69 instance to extract the SPI instance from.
  *
@@ -51,13 +110,10 @@ static void rfm69_write_reg(Rfm69Inst *inst, uint8_t addr, uint8_t data)
 {
 	ASSERT(inst != NULL);
 
-	spi_enable(&inst->spi);
-
 	/* Send address byte with MSB set to indicate write-mode. */
-	spi_send_receive(&inst->spi, addr | 0x80);
-	spi_send_receive(&inst->spi, data);
+	const uint8_t frames[] = { addr | 0x80, data };
 
-	spi_disable(&inst->spi);
+	spi_transaction(&inst->spi, frames, NULL, sizeof(frames));
 }
 
 /**
@@ -72,15 +128,216 @@ static uint8_t rfm69_read_reg(Rfm69Inst *inst, uint8_t addr)
 {
 	ASSERT(inst != NULL);
 
-	spi_enable(&inst->spi);
+	/* Send address byte with MSB cleared to indicate read-mode. */
+	uint8_t frames[] = { addr & 0x7F, 0 };
+
+	spi_transaction(&inst->spi, frames, frames, sizeof(frames));
+
+	return frames[1];
+}
+
+/**
+ * Write a run of consecutive registers in a single transaction. The radio
+ * increments the address after every byte (except for REG_FIFO, where every
+ * byte goes into the FIFO).
+ *
+ * @param inst The rfm69 instance to write to.
+ * @param addr The address of the first register.
+ * @param data The bytes to write, starting with the first register.
+ * @param len The number of bytes to write.
+ */
+static void _write_burst(Rfm69Inst *inst, uint8_t addr, const uint8_t *data, uint32_t len)
+{
+	ASSERT(inst != NULL);
+	ASSERT(data != NULL);
+
+	/* Send address byte with MSB set to indicate write-mode. */
+	const uint8_t cmd = addr | 0x80;
+
+	spi_bus_acquire(&inst->spi);
+	spi_write_buf(&inst->spi, &cmd, 1);
+	spi_write_buf(&inst->spi, data, len);
+	spi_bus_release(&inst->spi);
+}
+
+/**
+ * Read a run of consecutive registers (or a chunk of the FIFO when "addr" is
+ * REG_FIFO) in a single transaction.
+ *
+ * @param inst The rfm69 instance to read from.
+ * @param addr The address of the first register.
+ * @param data Where to store the bytes read, starting with the first register.
+ * @param len The number of bytes to read.
+ */
+static void _read_burst(Rfm69Inst *inst, uint8_t addr, uint8_t *data, uint32_t len)
+{
+	ASSERT(inst != NULL);
+	ASSERT(data != NULL);
 
 	/* Send address byte with MSB cleared to indicate read-mode. */
-	spi_send_receive(&inst->spi, addr & 0x7F);
-	uint8_t data = (uint8_t)spi_send_receive(&inst->spi, 0);
+	const uint8_t cmd = addr & 0x7F;
 
-	spi_disable(&inst->spi);
+	spi_bus_acquire(&inst->spi);
+	spi_write_buf(&inst->spi, &cmd, 1);
+	spi_transfer(&inst->spi, NULL, data, len);
+	spi_bus_release(&inst->spi);
+}
 
-	return data;
+/**
+ * Read "len" bytes out of the FIFO into the buffer (starting at "offset"),
+ * throwing away whatever doesn't fit.
+ *
+ * @param inst The rfm69 instance to read from.
+ * @param buffer The buffer the whole payload is being read into.
+ * @param buffer_len The size of the buffer.
+ * @param offset Where in the payload the bytes being read belong.
+ * @param len The number of bytes to read out of the FIFO.
+ */
+static void _read_fifo(Rfm69Inst *inst, uint8_t *buffer, uint32_t buffer_len, uint32_t offset, uint32_t len)
+{
+	const uint8_t cmd = REG_FIFO & 0x7F;
+	const uint32_t space = (offset < buffer_len) ? (buffer_len - offset) : 0;
+	const uint32_t kept = (len < space) ? len : space;
+
+	spi_bus_acquire(&inst->spi);
+	spi_write_buf(&inst->spi, &cmd, 1);
+	spi_transfer(&inst->spi, NULL, (kept > 0) ? &buffer[offset] : NULL, kept);
+	spi_transfer(&inst->spi, NULL, NULL, len - kept);
+	spi_bus_release(&inst->spi);
+}
+
+/**
+ * Poll IRQFlags2 until any of the given flags are set (or all of them are
+ * cleared).
+ *
+ * @param inst The rfm69 instance to poll.
+ * @param flags The RF_IRQ2_* flags to check.
+ * @param set True to wait for any of the flags to be set, false to wait for
+ *            all of them to be cleared.
+ * @param target_cycles The cycle count (see get_cycles()) to give up at, or
+ *                      RFM69_WAIT_FOREVER.
+ *
+ * @return True if the flags reached the wanted state, false on a timeout.
+ */
+static bool _wait_irq2(Rfm69Inst *inst, uint32_t flags, bool set, uint64_t target_cycles)
+{
+	while(((rfm69_read_reg(inst, REG_IRQ_FLAGS_2) & flags) != 0) != set) {
+		if(get_cycles() >= target_cycles) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @return The number of address bytes at the start of every packet (one with
+ *         address filtering enabled, zero otherwise).
+ */
+static inline uint32_t _address_len(Rfm69Inst *inst)
+{
+	return (inst->use_address) ? 1U : 0U;
+}
+
+/**
+ * Find the narrowest receiver bandwidth that's at least "min_bw" wide, where
+ * RxBw = FXOSC / (RxBwMant * 2^(RxBwExp + 2)).
+ *
+ * @param min_bw The smallest acceptable (single-sided) bandwidth in Hz.
+ *
+ * @return The value to write into REG_RX_BW.
+ */
+static uint8_t _get_rx_bw(uint32_t min_bw)
+{
+	/* Bandwidth goes up as the exponent and the mantissa go down. */
+	for(int exp = 7; exp >= 0; exp--) {
+		for(int mant = RF_RXBW_MANTISSA_24; mant >= RF_RXBW_MANTISSA_16; mant--) {
+			const uint32_t rx_bw = RFM69_FXOSC / ((16U + (4U * (uint32_t)mant)) << (exp + 2));
+
+			if(rx_bw >= min_bw) {
+				return (uint8_t)(SET_RF_RXBW_DCCFREQ(RFM69_DCC_FREQ) |
+				                 SET_RF_RXBW_RXBWMANT((uint32_t)mant) |
+				                 SET_RF_RXBW_RXBWEXP((uint32_t)exp));
+			}
+		}
+	}
+
+	ABORT("Receiver bandwidth is too wide");
+	return 0;
+}
+
+/**
+ * Write the modem settings to the radio (see rfm69_set_modem()). The radio
+ * should be in standby mode.
+ *
+ * @param inst The rfm69 instance to update.
+ * @param config The settings to use.
+ */
+static void _write_modem(Rfm69Inst *inst, const Rfm69ModemConfig *config)
+{
+	ASSERT(config != NULL);
+	ASSERT((config->bitrate >= RFM69_MIN_BITRATE) && (config->bitrate <= RFM69_MAX_BITRATE));
+	ASSERT(config->fdev <= RFM69_MAX_FDEV);
+	ASSERT(((4U * config->fdev) >= config->bitrate) && (config->fdev <= (5U * config->bitrate)));
+	ASSERT((config->fdev + (config->bitrate / 2U)) <= RFM69_MAX_RXBW);
+	ASSERT(config->preamble_len > 0);
+
+	const uint32_t bitrate = (RFM69_FXOSC + (config->bitrate / 2U)) / config->bitrate;
+	const uint32_t fdev = (uint32_t)
+		((((uint64_t)config->fdev << RFM69_FSTEP_SHIFT) + (RFM69_FXOSC / 2U)) / RFM69_FXOSC);
+
+	/* REG_BITRATE_* and REG_FDEV_* are next to each other. */
+	const uint8_t modem_regs[] = {
+		(uint8_t)(bitrate >> 8),
+		(uint8_t)bitrate,
+		(uint8_t)(fdev >> 8),
+		(uint8_t)fdev
+	};
+	_write_burst(inst, REG_BITRATE_MSB, modem_regs, sizeof(modem_regs));
+
+	/* The signal takes up the deviation plus half the bitrate on either side of the carrier. */
+	rfm69_write_reg(inst, REG_RX_BW, _get_rx_bw(config->fdev + (config->bitrate / 2U)));
+
+	const uint8_t preamble_regs[] = {
+		(uint8_t)(config->preamble_len >> 8),
+		(uint8_t)config->preamble_len
+	};
+	_write_burst(inst, REG_PREAMBLE_MSB, preamble_regs, sizeof(preamble_regs));
+
+	/**
+	 * Every wait on a packet that's being sent or received is bounded by twice
+	 * the time it takes a full FIFO (and the rest of the packet) to go out.
+	 */
+	const uint64_t bits = 8U * (RFM69_FIFO_SIZE + RFM69_PACKET_OVERHEAD + config->preamble_len);
+	const uint64_t timeout = (2U * bits * CPU_HZ) / config->bitrate;
+
+	ASSERT(timeout <= UINT32_MAX);
+	inst->fifo_timeout = (uint32_t)timeout;
+}
+
+/**
+ * Write the RF carrier frequency to the radio (see rfm69_set_frequency()).
+ *
+ * @param inst The rfm69 instance to update.
+ * @param frequency The carrier frequency in Hz.
+ */
+static void _write_frequency(Rfm69Inst *inst, uint32_t frequency)
+{
+	/* The radio covers the 315MHz, 433MHz and 868/915MHz bands. */
+	ASSERT(((frequency >= 290000000U) && (frequency <= 340000000U)) ||
+	       ((frequency >= 424000000U) && (frequency <= 510000000U)) ||
+	       ((frequency >= 862000000U) && (frequency <= 1020000000U)));
+
+	const uint32_t frf = (uint32_t)
+		((((uint64_t)frequency << RFM69_FSTEP_SHIFT) + (RFM69_FXOSC / 2U)) / RFM69_FXOSC);
+
+	/* The new frequency takes effect once the LSB is written. */
+	const uint8_t frf_regs[] = {
+		(uint8_t)(frf >> 16),
+		(uint8_t)(frf >> 8),
+		(uint8_t)frf
+	};
+	_write_burst(inst, REG_FRF_MSB, frf_regs, sizeof(frf_regs));
 }
 
 /**
@@ -113,9 +370,9 @@ static void _clear_fifo_flags(Rfm69Inst *inst)
  *       won't work.
  *
  * Default Transmitter Settings:
- * - Bitrate: 115107bps
+ * - Bitrate: 115107bps (RFM69_MODEM_115200, see rfm69_set_modem_preset())
  * - Fdev: 115173Hz
- * - RF Carrier Frequency: 915MHz
+ * - RF Carrier Frequency: 915MHz (see rfm69_set_frequency())
  * - Transmit Power: 13dBm, PA0 enabled (won't work on RFM69HW/RFM69HCW)
  * - Power Amp Ramp Time: 40us
  * - Over Current Protection: 95mA
@@ -132,10 +389,10 @@ static void _clear_fifo_flags(Rfm69Inst *inst)
  * - Fixed Length packet size
  * -- Default length of one byte.
  * - CRC enabled
- * - No address filtering
+ * - No address filtering (see rfm69_set_address_filter())
  * - InterPacketRxDelay: 35us
  * -- Restart RX 35us after the FIFO is cleared.
- * - No encryption
+ * - No encryption (see rfm69_set_aes_key())
  *
  * @param inst The rfm69 instance to initialize. There should be one instance
  *             per physical radio module.
@@ -178,43 +435,43 @@ void rfm69_init_radio(
 
 	inst->last_rssi = -999;
 	inst->mode = RF_MODE_STANDBY;
+	inst->use_dio0 = false;
+	inst->use_address = false;
+	inst->dest_address = 0;
+	inst->use_aes = false;
+	inst->waiter = NULL;
+	inst->packet_sent = false;
+	inst->rx_head = 0;
+	inst->rx_tail = 0;
+	inst->rx_dropped = 0;
+	inst->rx_busy = false;
 
 	/* Ensure we can communicate with the radio module correctly. */
 	ASSERT(rfm69_read_reg(inst, REG_VERSION) == RFM69_DEFAULT_VERSION);
 
-	/* Let the radio auto-sequence between modes and disable listening mode. */
-	rfm69_write_reg(inst, REG_OP_MODE,
+	/**
+	 * The configuration is written in bursts of consecutive registers to keep
+	 * the number of SPI transactions down.
+	 */
+	const uint8_t mode_regs[] = {
+		/* REG_OP_MODE: Let the radio auto-sequence between modes and disable listening mode. */
 		SET_RF_OPMODE_SEQUENCEROFF(RF_SEQUENCER_ON) |
 		SET_RF_OPMODE_LISTENON(RF_LISTEN_OFF) |
-		SET_RF_OPMODE_MODE(RF_MODE_STANDBY)
-	);
+		SET_RF_OPMODE_MODE(RF_MODE_STANDBY),
 
-	/* Packet mode, FSK modulation with no shaping. */
-	rfm69_write_reg(inst, REG_DATA_MODUL,
+		/* REG_DATA_MODUL: Packet mode, FSK modulation with no shaping. */
 		SET_RF_DATAMODUL_DATAMODE(RF_DATA_MODE_PACKET) |
 		SET_RF_DATAMODUL_MODULATIONTYPE(RF_MODUL_TYPE_FSK) |
 		SET_RF_DATAMODUL_MODULATIONSHAPING(RF_FSK_SHAPING_NONE)
-	);
-
-	/* Set default bitrate to 115107.9bps. */
-#define RFM69_DEFAULT_BITRATE_MSB 0x1
-#define RFM69_DEFAULT_BITRATE_LSB 0x16
-	rfm69_write_reg(inst, REG_BITRATE_MSB, RFM69_DEFAULT_BITRATE_MSB);
-	rfm69_write_reg(inst, REG_BITRATE_LSB, RFM69_DEFAULT_BITRATE_LSB);
-
-	/* Set default frequency deviation to 115173Hz. */
-#define RFM69_DEFAULT_FDEV_MSB 0x7
-#define RFM69_DEFAULT_FDEV_LSB 0x5F
-	rfm69_write_reg(inst, REG_FDEV_MSB, RFM69_DEFAULT_FDEV_MSB);
-	rfm69_write_reg(inst, REG_FDEV_LSB, RFM69_DEFAULT_FDEV_LSB);
+	};
+	_write_burst(inst, REG_OP_MODE, mode_regs, sizeof(mode_regs));
 
 	/* Set default RF Carrier frequency to 915MHz. */
-#define RFM69_DEFAULT_FRF_MSB 0xE4
-#define RFM69_DEFAULT_FRF_MID 0xC0
-#define RFM69_DEFAULT_FRF_LSB 0x00
-	rfm69_write_reg(inst, REG_FRF_MSB, RFM69_DEFAULT_FRF_MSB);
-	rfm69_write_reg(inst, REG_FRF_MID, RFM69_DEFAULT_FRF_MID);
-	rfm69_write_reg(inst, REG_FRF_LSB, RFM69_DEFAULT_FRF_LSB);
+#define RFM69_DEFAULT_FREQUENCY 915000000U
+	_write_frequency(inst, RFM69_DEFAULT_FREQUENCY);
+
+	/* Set the default bitrate, frequency deviation, receiver bandwidth and preamble. */
+	_write_modem(inst, &_modem_presets[RFM69_MODEM_115200]);
 
 	/**
 	 * Set power range to be from -18dBm to +13dBm, and default power to 13dBm
@@ -223,39 +480,28 @@ void rfm69_init_radio(
 	 * won't work.
 	 */
 #define RFM69_DEFAULT_OUTPUT_POWER 31
-	rfm69_write_reg(inst, REG_PA_LEVEL,
+#define RFM69_DEFAULT_PARAMP RF_PARAMP_40_US
+#define RFM69_DFEAULT_OCPTRIM 10 /* Imax = 45 + 5*OCPTRIM */
+	const uint8_t pa_regs[] = {
+		/* REG_PA_LEVEL */
 		SET_RF_PALEVEL_PA0ON(1) |
 		SET_RF_PALEVEL_PA1ON(0) |
 		SET_RF_PALEVEL_PA2ON(0) |
-		SET_RF_PALEVEL_OUTPUTPOWER(RFM69_DEFAULT_OUTPUT_POWER)
-	);
+		SET_RF_PALEVEL_OUTPUTPOWER(RFM69_DEFAULT_OUTPUT_POWER),
 
-	/* Set default power amplifier ramp time to 40us. The InterPacketRxDelay must be close to this. */
-#define RFM69_DEFAULT_PARAMP RF_PARAMP_40_US
-	rfm69_write_reg(inst, REG_PA_RAMP, SET_RF_PARAMP_PARAMP(RFM69_DEFAULT_PARAMP));
+		/* REG_PA_RAMP: Set default power amplifier ramp time to 40us. The InterPacketRxDelay must be close to this. */
+		SET_RF_PARAMP_PARAMP(RFM69_DEFAULT_PARAMP),
 
-	/* Set default over current protection to 95mA (radio uses 45mA while transmitting in +13dBm mode). */
-#define RFM69_DFEAULT_OCPTRIM 10 /* Imax = 45 + 5*OCPTRIM */
-	rfm69_write_reg(inst, REG_OCP,
+		/* REG_OCP: Set default over current protection to 95mA (radio uses 45mA while transmitting in +13dBm mode). */
 		SET_RF_OCP_OCPON(RF_OCP_ON) |
 		SET_RF_OCP_OCPTRIM(RFM69_DFEAULT_OCPTRIM)
-	);
+	};
+	_write_burst(inst, REG_PA_LEVEL, pa_regs, sizeof(pa_regs));
 
-	/* Set receiver to automatically adjust the gain. */
+	/* Set receiver to automatically adjust the gain (the bandwidth was set along with the bitrate). */
 	rfm69_write_reg(inst, REG_LNA,
 		SET_RF_LNA_LNAZIN(RF_LNA_ZIN_50_OHMS) |
-		SET_RF_LNA_LNAGAINSELECT(RF_LNA_GAIN_AGC)
-	);
-
-	/* Set receiver bandwidth to 200khz by default. */
-#define RFM69_DEFAULT_DCC_FREQ 2 /* 7957.75, supposed to be 4% of RXBW, aka, 8000 */
-#define RFM69_DEFAULT_RXBW_MANT RF_RXBW_MANTISSA_20
-#define RFM69_DEFAULT_RXBW_EXP 1
-	rfm69_write_reg(inst, REG_RX_BW,
-		SET_RF_RXBW_DCCFREQ(RFM69_DEFAULT_DCC_FREQ) |
-		SET_RF_RXBW_RXBWMANT(RFM69_DEFAULT_RXBW_MANT) |
-		SET_RF_RXBW_RXBWEXP(RFM69_DEFAULT_RXBW_EXP)
-	);
+		SET_RF_LNA_LNAGAINSELECT(RF_LNA_GAIN_AGC));
 
 	/* Disable CLKOUT feature for power savings. */
 	rfm69_write_reg(inst, REG_DIO_MAPPING_2, SET_RF_DIO2_CLKOUT(RF_CLKOUT_OFF));
@@ -264,51 +510,55 @@ void rfm69_init_radio(
 #define RFM69_DEFAULT_RSSI_THRESH 0xE4 /* -RssiThreshold / 2 dBm = 228dBm */
 	rfm69_write_reg(inst, REG_RSSI_THRESH, RFM69_DEFAULT_RSSI_THRESH);
 
-	/* Set default preamble bytes to three (the receiver uses these to synchronize the clock). */
-#define RFM69_DEFAULT_PREAMBLE_MSB 0x0
-#define RFM69_DEFAULT_PREAMBLE_LSB 0x3
-	rfm69_write_reg(inst, REG_PREAMBLE_MSB, RFM69_DEFAULT_PREAMBLE_MSB);
-	rfm69_write_reg(inst, REG_PREAMBLE_LSB, RFM69_DEFAULT_PREAMBLE_LSB);
-
-	/* Set size of sync word generation to 2 (a prefix byte, and a user-supplied network ID). */
 #define RFM69_DEFAULT_SYNC_SIZE 1 /* Real sync size is this value + 1, so 2. */
-	rfm69_write_reg(inst, REG_SYNC_CONFIG,
+#define RFM69_DEFAULT_SYNC_PREFIX 0x37
+#define RFM69_DEFAULT_SYNC_ID 0xAA
+	const uint8_t sync_regs[] = {
+		/* REG_SYNC_CONFIG: Set size of sync word generation to 2 (a prefix byte, and a user-supplied network ID). */
 		SET_RF_SYNCCONFIG_SYNC_ON(RF_SYNC_ON) |
 		SET_RF_SYNCCONFIG_FIFO_FILL_COND(RF_FIFO_COND_SYNC_ADDR) |
 		SET_RF_SYNCCONFIG_SYNC_SIZE(RFM69_DEFAULT_SYNC_SIZE) |
-		SET_RF_SYNCCONFIG_SYNC_TOL(0)
-	);
+		SET_RF_SYNCCONFIG_SYNC_TOL(0),
 
-	/* Set default Sync words. */
-#define RFM69_DEFAULT_SYNC_PREFIX 0x37
-#define RFM69_DEFAULT_SYNC_ID 0xAA
-	rfm69_write_reg(inst, REG_SYNC_VALUE_1, RFM69_DEFAULT_SYNC_PREFIX);
-	rfm69_write_reg(inst, REG_SYNC_VALUE_2, RFM69_DEFAULT_SYNC_ID);
+		/* REG_SYNC_VALUE_*: Set default Sync words. */
+		RFM69_DEFAULT_SYNC_PREFIX,
+		RFM69_DEFAULT_SYNC_ID
+	};
+	_write_burst(inst, REG_SYNC_CONFIG, sync_regs, sizeof(sync_regs));
 
-	/* Set default packet configuration (fixed length, no dc-free, CRC enabled, no address filtering). */
-	rfm69_write_reg(inst, REG_PACKET_CONFIG_1,
+#define RFM69_DEFAULT_PAYLOAD_LENGTH 1
+#define RFM69_DEFAULT_INTERPACKET_RX_DELAY 2 /* 35uS delay, should match PA ramp time */
+	inst->payload_length = RFM69_DEFAULT_PAYLOAD_LENGTH;
+
+	const uint8_t packet_regs[] = {
+		/* REG_PACKET_CONFIG_1: Fixed length, no dc-free, CRC enabled, no address filtering. */
 		SET_RF_PACKET1_PACKET_FORMAT(RF_FIXED_LENGTH) |
 		SET_RF_PACKET1_DC_FREE(RF_DCFREE_NONE) |
 		SET_RF_PACKET1_CRC_ON(RF_CRC_ON) |
 		SET_RF_PACKET1_CRC_AUTO_CLEAR_OFF(RF_CRC_AUTO_CLEAR_FIFO) |
-		SET_RF_PACKET1_ADDRESS_FILTERING(RF_ADDR_FILT_NONE));
+		SET_RF_PACKET1_ADDRESS_FILTERING(RF_ADDR_FILT_NONE),
 
-	/* Set default packet length to one byte. */
-#define RFM69_DEFAULT_PAYLOAD_LENGTH 1
-	inst->payload_length = RFM69_DEFAULT_PAYLOAD_LENGTH;
-	rfm69_write_reg(inst, REG_PAYLOAD_LENGTH, RFM69_DEFAULT_PAYLOAD_LENGTH);
+		/* REG_PAYLOAD_LENGTH: Set default packet length to one byte. */
+		RFM69_DEFAULT_PAYLOAD_LENGTH,
 
-	/* Start packet transmission after the first byte hits the FIFO. */
-	rfm69_write_reg(inst, REG_FIFO_THRESH,
+		/* REG_NODE_ADRS, REG_BROADCAST_ADRS, REG_AUTO_MODES: Left at their reset values. */
+		0,
+		0,
+		0,
+
+		/**
+		 * REG_FIFO_THRESH: Start packet transmission after the first byte hits
+		 * the FIFO. The threshold paces streaming of long packets.
+		 */
 		SET_RF_FIFOTHRESH_TX_START_CONDITION(RF_TXSTART_FIFONOTEMPTY) |
-		SET_RF_FIFOTHRESH_FIFO_THRESHOLD(0xF));
+		SET_RF_FIFOTHRESH_FIFO_THRESHOLD(RFM69_FIFO_THRESHOLD),
 
-	/* Restart RX 35us after FIFO empty, no encryption. */
-#define RFM69_DEFAULT_INTERPACKET_RX_DELAY 2 /* 35uS delay, should match PA ramp time */
-	rfm69_write_reg(inst, REG_PACKET_CONFIG_2,
+		/* REG_PACKET_CONFIG_2: Restart RX 35us after FIFO empty, no encryption. */
 		SET_RF_PACKET2_INTER_PACKET_RX_DELAY(RFM69_DEFAULT_INTERPACKET_RX_DELAY) |
 		SET_RF_PACKET2_AUTO_RX_RESTART_ON(RF_AUTO_RX_RESTART_ON) |
-		SET_RF_PACKET2_AES_ON(RF_AES_OFF));
+		SET_RF_PACKET2_AES_ON(RF_AES_OFF)
+	};
+	_write_burst(inst, REG_PACKET_CONFIG_1, packet_regs, sizeof(packet_regs));
 
 	/* Enable Continuous Digital Automatic Gain Control (DAGC). */
 	rfm69_write_reg(inst, REG_TEST_DAGC, RF_TEST_DAGC_LOW_BETA_0);
@@ -330,6 +580,9 @@ void rfm69_init_radio(
  * @note For fixed length payloads, both the transmitter and receiver need to be
  *       configured with the same payload length.
  *
+ * @note With address filtering enabled, the address byte counts towards the
+ *       radio's limits (so one less byte of payload fits into the FIFO).
+ *
  * @param inst The radio instance to update.
  * @param length RFM69_VARIABLE_LENGTH_PAYLOAD for variable length, >0 for fixed
  *               length payloads.
@@ -337,25 +590,40 @@ void rfm69_init_radio(
 void rfm69_set_payload_length(Rfm69Inst *inst, uint8_t length)
 {
 	ASSERT(inst != NULL);
-	ASSERT(length <= RFM69_MAX_PAYLOAD_LEN);
+
+	/* The DIO0 interrupt can only receive packets that fit into the FIFO. */
+	const uint32_t max_length = (inst->use_dio0) ? RFM69_FIFO_PAYLOAD_LEN : RFM69_MAX_PAYLOAD_LEN;
+	const uint32_t address_len = _address_len(inst);
+
+	ASSERT((length + address_len) <= max_length);
+	ASSERT(!inst->use_aes || (length <= RFM69_AES_MAX_PAYLOAD_LEN));
 
 	inst->payload_length = length;
 
 	uint8_t packet_config = rfm69_read_reg(inst, REG_PACKET_CONFIG_1) & ~RF_PACKET1_PACKET_FORMAT();
 
+	/* The radio's payload length includes the address byte. */
+	uint32_t reg_length = length + address_len;
+
 	if(length == RFM69_VARIABLE_LENGTH_PAYLOAD) {
 		/* Set packet config to variable length. */
 		packet_config |= RF_PACKET1_PACKET_FORMAT();
 
 		/**
 		 * The payload_length register has no effect on variable length TX, but
-		 * defines max RX length when receiving variable length packets.
+		 * defines max RX length when receiving variable length packets. Have
+		 * the radio filter out anything longer than can be received (or
+		 * decrypted).
 		 */
-		length = RFM69_MAX_PAYLOAD_LEN;
+		reg_length = max_length;
+
+		if(inst->use_aes && (reg_length > (RFM69_AES_MAX_PAYLOAD_LEN + address_len))) {
+			reg_length = RFM69_AES_MAX_PAYLOAD_LEN + address_len;
+		}
 	}
 
 	rfm69_write_reg(inst, REG_PACKET_CONFIG_1, packet_config);
-	rfm69_write_reg(inst, REG_PAYLOAD_LENGTH, length);
+	rfm69_write_reg(inst, REG_PAYLOAD_LENGTH, (uint8_t)reg_length);
 }
 
 /**
@@ -424,6 +692,222 @@ static void _set_power_boost(Rfm69Inst *inst, bool enabled)
 	rfm69_write_reg(inst, REG_TEST_PA_2, (enabled) ? RF_TEST_PA2_20DBM : RF_TEST_PA2_NORMAL);
 }
 
+/* Wake up whichever task is waiting on a DIO0 event. */
+static void _wake_waiter(Rfm69Inst *inst)
+{
+	task_t *const waiter = inst->waiter;
+
+	if(waiter != NULL) {
+		sched_wake(waiter);
+	}
+}
+
+/**
+ * Last step of reading out a packet from the DIO0 interrupt: queue up the
+ * payload (unless it was thrown away) and wake up the receiving task.
+ */
+static void _rx_payload_done(__unused SpiInst *spi, void *arg)
+{
+	Rfm69Inst *const inst = (Rfm69Inst*)arg;
+	const uint8_t head = inst->rx_head;
+
+	if((inst->rx_length == 0) ||
+	   ((uint8_t)(head - __atomic_load_n(&inst->rx_tail, __ATOMIC_ACQUIRE)) >= RFM69_RX_QUEUE_LEN)) {
+		inst->rx_dropped++;
+	} else {
+		Rfm69Packet *const packet = &inst->rx_queue[head & (RFM69_RX_QUEUE_LEN - 1U)];
+
+		/**
+		 * The first byte is what came back while the read command was sent,
+		 * followed by the address byte (if there is one).
+		 */
+		const uint32_t address_len = _address_len(inst);
+
+		packet->length = inst->rx_length - address_len;
+		packet->rssi = -((int16_t)inst->rx_rssi[1]) / 2;
+		memcpy(packet->data, &inst->rx_buf[1U + address_len], packet->length);
+
+		__atomic_store_n(&inst->rx_head, (uint8_t)(head + 1U), __ATOMIC_RELEASE);
+	}
+
+	inst->rx_busy = false;
+	_wake_waiter(inst);
+}
+
+/**
+ * Read a payload of "length" bytes out of the FIFO into rx_buf. A length of
+ * zero means the packet is bad, so the FIFO gets cleared instead.
+ */
+static void _rx_read_payload(Rfm69Inst *inst, uint8_t length)
+{
+	SpiTransaction *const txn = &inst->rx_txns[2];
+
+	inst->rx_length = length;
+
+	txn->inst = &inst->spi;
+	txn->callback = _rx_payload_done;
+	txn->arg = inst;
+
+	if(length == 0) {
+		/* Writing the FifoOverrun flag clears the FIFO. */
+		inst->rx_cmd[0] = REG_IRQ_FLAGS_2 | 0x80;
+		inst->rx_cmd[1] = (uint8_t)RF_IRQ2_FIFO_OVERRUN();
+
+		txn->tx = inst->rx_cmd;
+		txn->rx = NULL;
+		txn->len = sizeof(inst->rx_cmd);
+	} else {
+		/* What gets sent after the read command doesn't matter, so rx_buf doubles as the TX buffer. */
+		inst->rx_buf[0] = REG_FIFO & 0x7F;
+
+		txn->tx = inst->rx_buf;
+		txn->rx = inst->rx_buf;
+		txn->len = length + 1U;
+	}
+
+	spi_transaction_async(txn);
+}
+
+/* Called once the length byte of a variable length packet has been read. */
+static void _rx_header_done(__unused SpiInst *spi, void *arg)
+{
+	Rfm69Inst *const inst = (Rfm69Inst*)arg;
+	const uint8_t length = inst->rx_header[1];
+
+	/* The length includes the address byte, so there has to be more than that. */
+	_rx_read_payload(inst, ((length > _address_len(inst)) && (length <= RFM69_FIFO_PAYLOAD_LEN)) ? length : 0);
+}
+
+/**
+ * DIO0 interrupt. In TX mode this is PacketSent, and in RX mode it's
+ * PayloadReady. A received packet is read out of the FIFO with a chain of
+ * asynchronous SPI transactions (so this doesn't have to wait for the bus),
+ * which ends in _rx_payload_done().
+ */
+static void _dio0_isr(void *arg)
+{
+	Rfm69Inst *const inst = (Rfm69Inst*)arg;
+
+	static const uint8_t rssi_cmd[] = { REG_RSSI_VALUE & 0x7F, 0 };
+	static const uint8_t fifo_cmd[] = { REG_FIFO & 0x7F, 0 };
+
+	if(inst->mode == RF_MODE_TX) {
+		inst->packet_sent = true;
+		_wake_waiter(inst);
+		return;
+	}
+
+	if((inst->mode != RF_MODE_RX) || inst->rx_busy) {
+		return;
+	}
+
+	inst->rx_busy = true;
+
+	/* Grab the RSSI first, while it still reflects this packet. */
+	inst->rx_txns[0] = (SpiTransaction) {
+		.inst = &inst->spi,
+		.tx = rssi_cmd,
+		.rx = inst->rx_rssi,
+		.len = sizeof(rssi_cmd),
+		.callback = NULL,
+		.arg = NULL
+	};
+	spi_transaction_async(&inst->rx_txns[0]);
+
+	if(inst->payload_length == RFM69_VARIABLE_LENGTH_PAYLOAD) {
+		/* The length byte has to be read before the rest of the payload. */
+		inst->rx_txns[1] = (SpiTransaction) {
+			.inst = &inst->spi,
+			.tx = fifo_cmd,
+			.rx = inst->rx_header,
+			.len = sizeof(fifo_cmd),
+			.callback = _rx_header_done,
+			.arg = inst
+		};
+		spi_transaction_async(&inst->rx_txns[1]);
+	} else {
+		_rx_read_payload(inst, (uint8_t)(inst->payload_length + _address_len(inst)));
+	}
+}
+
+/* Conditions waited on with _wait_dio0(). */
+static bool _is_packet_sent(Rfm69Inst *inst)
+{
+	return inst->packet_sent;
+}
+
+static bool _is_packet_queued(Rfm69Inst *inst)
+{
+	return __atomic_load_n(&inst->rx_head, __ATOMIC_ACQUIRE) != inst->rx_tail;
+}
+
+static bool _is_rx_idle(Rfm69Inst *inst)
+{
+	return !inst->rx_busy;
+}
+
+#if ENABLE_SW_TIMERS
+/* Timer callback used to wake up a task whose wait has timed out. */
+static void _wait_timeout(void *arg)
+{
+	sched_wake((task_t*)arg);
+}
+#endif /* ENABLE_SW_TIMERS */
+
+/**
+ * Wait for a condition that gets updated by the DIO0 interrupt. When called
+ * from a task, the task sleeps until the interrupt (or the timeout) wakes it.
+ *
+ * @param inst The radio instance to wait on.
+ * @param done Returns true once the wait is over.
+ * @param target_cycles The cycle count (see get_cycles()) to give up at, or
+ *                      RFM69_WAIT_FOREVER.
+ *
+ * @return True if the condition became true, false on a timeout.
+ */
+static bool _wait_dio0(Rfm69Inst *inst, bool (*done)(Rfm69Inst *inst), uint64_t target_cycles)
+{
+	task_t *task = task_can_block() ? get_current_task() : NULL;
+
+#if ENABLE_SW_TIMERS
+	sw_timer_t timer;
+	const bool timed = (task != NULL) && (target_cycles != RFM69_WAIT_FOREVER);
+
+	if(timed) {
+		const uint64_t now = get_cycles();
+
+		sw_timer_init(&timer, _wait_timeout, task, SW_TIMER_FLAG_ISR);
+		sw_timer_start(&timer, (target_cycles > now) ? (target_cycles - now) : 0);
+	}
+#else
+	/* Nothing would wake the task back up on a timeout, so spin instead. */
+	if(target_cycles != RFM69_WAIT_FOREVER) {
+		task = NULL;
+	}
+#endif /* ENABLE_SW_TIMERS */
+
+	inst->waiter = task;
+
+	bool result = done(inst);
+	while(!result && (get_cycles() < target_cycles)) {
+		if(task != NULL) {
+			sched_block();
+		}
+
+		result = done(inst);
+	}
+
+	inst->waiter = NULL;
+
+#if ENABLE_SW_TIMERS
+	if(timed) {
+		sw_timer_stop(&timer);
+	}
+#endif /* ENABLE_SW_TIMERS */
+
+	return result;
+}
+
 /**
  * Switch the radio module to a different mode and wait for the sequencing
  * between modes to finish.
@@ -438,6 +922,15 @@ static void _switch_mode(Rfm69Inst *inst, Rfm69Mode mode)
 		return;
 	}
 
+	if(inst->use_dio0) {
+		/* Let any FIFO reads started by the DIO0 interrupt finish before leaving RX. */
+		gpio_disable_interrupt(inst->dio0_reg, inst->dio0_pin);
+		_wait_dio0(inst, _is_rx_idle, RFM69_WAIT_FOREVER);
+
+		rfm69_write_reg(inst, REG_DIO_MAPPING_1, SET_RF_DIO1_DIO0MAPPING(
+			(mode == RF_MODE_RX) ? RF_DIO0_PAYLOAD_READY : RF_DIO0_PACKET_SENT));
+	}
+
 	/* Power boost (>17dBm output) must be disabled during RX and enabled during TX. */
 	if((inst->power_mode == RFM69_PA1_PA2_BOOST) && (mode == RF_MODE_RX)) {
 		_set_power_boost(inst, false);
@@ -445,6 +938,13 @@ static void _switch_mode(Rfm69Inst *inst, Rfm69Mode mode)
 		_set_power_boost(inst, true);
 	}
 
+	/* The DIO0 interrupt uses the mode to tell which event it's seeing. */
+	inst->mode = mode;
+
+	if(inst->use_dio0 && ((mode == RF_MODE_RX) || (mode == RF_MODE_TX))) {
+		gpio_enable_interrupt(inst->dio0_reg, inst->dio0_pin);
+	}
+
 	const uint8_t opmode = rfm69_read_reg(inst, REG_OP_MODE) & ~RF_OPMODE_MODE();
 	rfm69_write_reg(inst, REG_OP_MODE, opmode | SET_RF_OPMODE_MODE(mode));
 
@@ -452,14 +952,207 @@ static void _switch_mode(Rfm69Inst *inst, Rfm69Mode mode)
 	ABORT_TIMEOUT(
 		GET_RF_IRQ1_MODE_READY(rfm69_read_reg(inst, REG_IRQ_FLAGS_1)) == 1,
 		RFM69_MODE_CHANGE_TIMEOUT);
+}
 
-	inst->mode = mode;
+/**
+ * Use the radio's DIO0 pin as an interrupt instead of polling the IRQ flags
+ * over SPI. DIO0 gets mapped to PayloadReady in RX mode and PacketSent in TX
+ * mode. Received packets are read out of the FIFO by the interrupt and queued
+ * up (see RFM69_RX_QUEUE_LEN), and the receiving/transmitting task sleeps until
+ * the interrupt wakes it up. The radio also stays in RX mode after a packet is
+ * received, so packets keep getting queued until the radio is used to transmit.
+ *
+ * @note Long packets can still be sent, but only packets that fit into the FIFO
+ *       (RFM69_FIFO_PAYLOAD_LEN) can be received. Receiving longer packets
+ *       requires polling so the FIFO can be drained while the packet arrives.
+ *
+ * @note The radio should only be used by one task at a time.
+ *
+ * @param inst The radio instance to update.
+ * @param dio0_reg GPIO register used for the DIO0 line.
+ * @param dio0_pin GPIO pin connected to the DIO0 line.
+ */
+void rfm69_enable_interrupts(Rfm69Inst *inst, GpioReg *dio0_reg, GpioPin dio0_pin)
+{
+	ASSERT(inst != NULL);
+	ASSERT(dio0_reg != NULL);
+	ASSERT(!inst->use_dio0);
+	ASSERT((inst->payload_length + _address_len(inst)) <= RFM69_FIFO_PAYLOAD_LEN);
+
+	_switch_mode(inst, RF_MODE_STANDBY);
+
+	inst->dio0_reg = dio0_reg;
+	inst->dio0_pin = dio0_pin;
+
+	/* _switch_mode() enables the interrupt whenever the radio enters RX or TX. */
+	gpio_request_interrupt(dio0_reg, dio0_pin, GPIO_NO_PULL, GPIO_TRIGGER_RISING, _dio0_isr, inst);
+	gpio_disable_interrupt(dio0_reg, dio0_pin);
+
+	inst->use_dio0 = true;
+
+	/* Lower the maximum variable length RX payload to what the interrupt can handle. */
+	rfm69_set_payload_length(inst, inst->payload_length);
+}
+
+/**
+ * Have the radio throw away packets that aren't addressed to this node, so
+ * that traffic for other nodes on a busy channel never wakes up the CPU. With
+ * filtering enabled, every packet starts with an address byte (right after the
+ * length byte). The driver adds it to sent packets (see
+ * rfm69_set_destination()) and strips it from received ones, so payloads are
+ * unchanged.
+ *
+ * Packets are sent to the broadcast address until rfm69_set_destination() is
+ * called.
+ *
+ * @note Acknowledgements sent by rfm69_receive_with_ack() also go to the
+ *       destination address, so both ends should point their destination at
+ *       each other's node address.
+ *
+ * @param inst The radio instance to update.
+ * @param filtering RF_ADDR_FILT_NONE to disable filtering (and the address
+ *                  byte), RF_ADDR_FILT_NODE to only receive packets sent to
+ *                  node_address, or RF_ADDR_FILT_NODE_OR_BROADCAST to also
+ *                  receive packets sent to broadcast_address.
+ * @param node_address The address of this radio.
+ * @param broadcast_address The address every radio on the network listens to.
+ */
+void rfm69_set_address_filter(
+	Rfm69Inst *inst,
+	Rfm69AddressFiltering filtering,
+	uint8_t node_address,
+	uint8_t broadcast_address)
+{
+	ASSERT(inst != NULL);
+	ASSERT(filtering <= RF_ADDR_FILT_NODE_OR_BROADCAST);
+
+	_switch_mode(inst, RF_MODE_STANDBY);
+
+	/* REG_NODE_ADRS and REG_BROADCAST_ADRS are next to each other. */
+	const uint8_t address_regs[] = { node_address, broadcast_address };
+	_write_burst(inst, REG_NODE_ADRS, address_regs, sizeof(address_regs));
+
+	const uint8_t packet_config = rfm69_read_reg(inst, REG_PACKET_CONFIG_1) & ~RF_PACKET1_ADDRESS_FILTERING();
+	rfm69_write_reg(inst, REG_PACKET_CONFIG_1, packet_config | SET_RF_PACKET1_ADDRESS_FILTERING(filtering));
+
+	inst->use_address = (filtering != RF_ADDR_FILT_NONE);
+	inst->dest_address = broadcast_address;
+
+	/* The address byte counts towards the radio's payload length. */
+	rfm69_set_payload_length(inst, inst->payload_length);
+}
+
+/**
+ * Set the address that packets get sent to when address filtering is enabled
+ * (see rfm69_set_address_filter()).
+ *
+ * @param inst The radio instance to update.
+ * @param address The node (or broadcast) address of the receiving radio.
+ */
+void rfm69_set_destination(Rfm69Inst *inst, uint8_t address)
+{
+	ASSERT(inst != NULL);
+	ASSERT(inst->use_address);
+
+	inst->dest_address = address;
+}
+
+/**
+ * Encrypt every packet with AES-128 on the radio itself. The payload (and
+ * the address byte, if address filtering is enabled) is encrypted right before
+ * it goes out and decrypted before PayloadReady is set, so the CPU never has
+ * to touch it. Both ends need the same key.
+ *
+ * @note Encryption happens inside the FIFO, so payloads are limited to
+ *       RFM69_AES_MAX_PAYLOAD_LEN bytes while it's enabled.
+ *
+ * @param inst The radio instance to update.
+ * @param key RFM69_AES_KEY_LEN bytes of key, or NULL to disable encryption.
+ */
+void rfm69_set_aes_key(Rfm69Inst *inst, const uint8_t *key)
+{
+	ASSERT(inst != NULL);
+
+	/* The key can only be changed while the radio isn't sending or receiving. */
+	_switch_mode(inst, RF_MODE_STANDBY);
+
+	if(key != NULL) {
+		_write_burst(inst, REG_AES_KEY_1, key, RFM69_AES_KEY_LEN);
+	}
+
+	inst->use_aes = (key != NULL);
+
+	const uint8_t packet_config = rfm69_read_reg(inst, REG_PACKET_CONFIG_2) & ~RF_PACKET2_AES_ON();
+	rfm69_write_reg(inst, REG_PACKET_CONFIG_2,
+		packet_config | SET_RF_PACKET2_AES_ON((key != NULL) ? RF_AES_ON : RF_AES_OFF));
+
+	/* Have the radio filter out variable length packets that are too long to decrypt. */
+	rfm69_set_payload_length(inst, inst->payload_length);
+}
+
+/**
+ * Change the bitrate, frequency deviation and preamble length. The receiver
+ * bandwidth is set to the narrowest one that fits the signal (deviation plus
+ * half the bitrate on either side of the carrier), with the DC offset
+ * canceller kept at about 4% of it. Timeouts on sending and receiving packets
+ * scale with the bitrate.
+ *
+ * @note Every setting is checked against the limits of the radio's FSK modem
+ *       (bitrate of 1.2 to 300kbps, modulation index of 0.5 to 10, and the
+ *       signal has to fit into the widest receiver bandwidth of 500kHz).
+ *
+ * @param inst The radio instance to update.
+ * @param config The modem settings (the receiver needs to match them).
+ */
+void rfm69_set_modem(Rfm69Inst *inst, const Rfm69ModemConfig *config)
+{
+	ASSERT(inst != NULL);
+
+	_switch_mode(inst, RF_MODE_STANDBY);
+	_write_modem(inst, config);
+}
+
+/**
+ * Change the modem settings to one of the presets (see Rfm69ModemPreset).
+ *
+ * @param inst The radio instance to update.
+ * @param preset The preset to use (the receiver needs to use the same one).
+ */
+void rfm69_set_modem_preset(Rfm69Inst *inst, Rfm69ModemPreset preset)
+{
+	ASSERT(preset <= RFM69_MODEM_300000);
+
+	rfm69_set_modem(inst, &_modem_presets[preset]);
+}
+
+/**
+ * Change the RF carrier frequency.
+ *
+ * @note The radio module is only matched for one of the 315MHz, 433MHz or
+ *       868/915MHz bands, so the frequency should be in the module's band.
+ *
+ * @param inst The radio instance to update.
+ * @param frequency The carrier frequency in Hz.
+ */
+void rfm69_set_frequency(Rfm69Inst *inst, uint32_t frequency)
+{
+	ASSERT(inst != NULL);
+
+	_switch_mode(inst, RF_MODE_STANDBY);
+	_write_frequency(inst, frequency);
 }
 
 /**
  * Send a packet of data over the radio. After the packet is sent, the radio
  * will be in standby mode.
  *
+ * Payloads that don't fit into the FIFO are streamed: the FIFO gets filled
+ * before transmitting, and then topped back up every time it drains down to
+ * RFM69_FIFO_THRESHOLD bytes while the packet is going out.
+ *
+ * With address filtering enabled, the packet goes to the address set by
+ * rfm69_set_destination().
+ *
  * @param inst The radio instance to transit over.
  * @param data The data to send.
  * @param length The length of the payload. If the radio was configured with a
@@ -472,91 +1165,210 @@ void rfm69_send(Rfm69Inst *inst, uint8_t *data, uint8_t length)
 	ASSERT(data != NULL);
 	ASSERT(((inst->payload_length == RFM69_VARIABLE_LENGTH_PAYLOAD) && (length > 0)) ||
 	       (inst->payload_length == length));
+	ASSERT((length + _address_len(inst)) <= RFM69_MAX_PAYLOAD_LEN);
+	ASSERT(!inst->use_aes || (length <= RFM69_AES_MAX_PAYLOAD_LEN));
 
 	_switch_mode(inst, RF_MODE_STANDBY);
 
 	/* Clear out any existing FIFO data. */
 	_clear_fifo_flags(inst);
 
-	/* Fill up the radio's FIFO while in standby or TX mode. */
-	spi_enable(&inst->spi);
-	spi_send_receive(&inst->spi, REG_FIFO | 0x80);
-
 	/**
-	 * In variable length packet mode, the first byte placed into the FIFO is
-	 * the length of the payload (not including the length byte).
+	 * Fill up the radio's FIFO while in standby or TX mode. In variable length
+	 * packet mode, the first byte placed into the FIFO is the length of the
+	 * payload (not including the length byte, but including the address byte).
+	 * With address filtering enabled, the address byte comes next.
 	 */
+	uint8_t header[3] = { REG_FIFO | 0x80 };
+	uint32_t header_len = 1;
+
 	if(inst->payload_length == RFM69_VARIABLE_LENGTH_PAYLOAD) {
-		spi_send_receive(&inst->spi, length);
+		header[header_len++] = (uint8_t)(length + _address_len(inst));
 	}
 
-	for(int i = 0; i < length; ++i) {
-		spi_send_receive(&inst->spi, data[i]);
+	if(inst->use_address) {
+		header[header_len++] = inst->dest_address;
 	}
-	spi_disable(&inst->spi);
+
+	uint32_t chunk = RFM69_FIFO_SIZE - (header_len - 1U);
+	chunk = (length < chunk) ? length : chunk;
+
+	spi_bus_acquire(&inst->spi);
+	spi_write_buf(&inst->spi, header, header_len);
+	spi_write_buf(&inst->spi, data, chunk);
+	spi_bus_release(&inst->spi);
 
 	/* Once the radio is switched to transmit, it will start sending data. */
+	inst->packet_sent = false;
 	_switch_mode(inst, RF_MODE_TX);
 
+	/**
+	 * Stream in the rest of the payload. Once FifoLevel clears there's room
+	 * for at least (RFM69_FIFO_SIZE - RFM69_FIFO_THRESHOLD) more bytes.
+	 */
+	for(uint32_t sent = chunk; sent < length; sent += chunk) {
+		if(!_wait_irq2(inst, RF_IRQ2_FIFO_LEVEL(), false, get_cycles() + inst->fifo_timeout)) {
+			ABORT("Timed out streaming a packet into the FIFO");
+		}
+
+		chunk = length - sent;
+		chunk = (chunk < (RFM69_FIFO_SIZE - RFM69_FIFO_THRESHOLD)) ?
+			chunk : (RFM69_FIFO_SIZE - RFM69_FIFO_THRESHOLD);
+
+		_write_burst(inst, REG_FIFO, &data[sent], chunk);
+	}
+
 	/* Wait for the packet to send. */
-#define RFM69_TRANSMIT_TIMEOUT MSECS(2)
-	ABORT_TIMEOUT(
-		GET_RF_IRQ2_PACKET_SENT(rfm69_read_reg(inst, REG_IRQ_FLAGS_2)) == 1,
-		RFM69_TRANSMIT_TIMEOUT);
+	if(inst->use_dio0) {
+		if(!_wait_dio0(inst, _is_packet_sent, get_cycles() + inst->fifo_timeout)) {
+			ABORT("Timed out waiting for PacketSent");
+		}
+	} else {
+		ABORT_TIMEOUT(
+			GET_RF_IRQ2_PACKET_SENT(rfm69_read_reg(inst, REG_IRQ_FLAGS_2)) == 1,
+			inst->fifo_timeout);
+	}
 
 	_switch_mode(inst, RF_MODE_STANDBY);
 }
 
 /**
- * Read a payload from the radio FIFO after a payload has been readied. It's
- * assumed that the radio is still in the RX mode.
+ * Wait for a received payload to be ready. Without the DIO0 interrupt, this
+ * also returns once FifoLevel shows a packet is on its way in, since a long
+ * packet has to be drained before it overflows the FIFO.
+ *
+ * @param inst The radio instance to wait on (must be in RX mode).
+ * @param target_cycles The cycle count (see get_cycles()) to give up at, or
+ *                      RFM69_WAIT_FOREVER.
+ *
+ * @return True if a payload is ready (or arriving), false on a timeout.
+ */
+static bool _wait_payload(Rfm69Inst *inst, uint64_t target_cycles)
+{
+	if(inst->use_dio0) {
+		return _wait_dio0(inst, _is_packet_queued, target_cycles);
+	}
+
+	return _wait_irq2(inst, RF_IRQ2_PAYLOAD_READY() | RF_IRQ2_FIFO_LEVEL(), true, target_cycles);
+}
+
+/**
+ * Take the oldest packet off of the queue filled by the DIO0 interrupt.
+ *
+ * @param inst The radio instance to read from.
+ * @param buffer A buffer to fill with the received payload.
+ * @param buffer_len The maximum amount of bytes to copy.
+ *
+ * @return The number of bytes copied (will be buffer_len at max).
+ */
+static uint8_t _pop_packet(Rfm69Inst *inst, uint8_t *buffer, uint8_t buffer_len)
+{
+	ASSERT(_is_packet_queued(inst));
+
+	const uint8_t tail = inst->rx_tail;
+	const Rfm69Packet *const packet = &inst->rx_queue[tail & (RFM69_RX_QUEUE_LEN - 1U)];
+	const uint8_t length = (buffer_len < packet->length) ? buffer_len : packet->length;
+
+	memcpy(buffer, packet->data, length);
+	inst->last_rssi = packet->rssi;
+
+	__atomic_store_n(&inst->rx_tail, (uint8_t)(tail + 1U), __ATOMIC_RELEASE);
+
+	return length;
+}
+
+/**
+ * Read a payload from the radio after a payload has been readied (see
+ * _wait_payload()). It's assumed that the radio is still in the RX mode. With
+ * the DIO0 interrupt enabled, the payload comes off of the packet queue and
+ * the radio stays in RX mode. Otherwise it's read straight out of the FIFO and
+ * the radio is left in standby mode.
+ *
+ * Without the DIO0 interrupt, a payload that doesn't fit into the FIFO gets
+ * drained RFM69_FIFO_THRESHOLD bytes at a time (whenever FifoLevel is set)
+ * while it's still arriving. The last FIFO's worth is only read once
+ * PayloadReady shows the CRC passed.
  *
  * @param inst The radio instance to read from.
  * @param buffer A buffer to fill with the received payload.
  * @param buffer_len The maximum amount of bytes to read from the radio.
  *
- * @return The number of bytes read from the radio (will be buffer_len at max).
+ * @return The number of bytes read from the radio (will be buffer_len at max),
+ *         or zero if the packet was bad (e.g., it failed the CRC check).
  */
 uint8_t _read_payload(Rfm69Inst *inst, uint8_t *buffer, uint8_t buffer_len)
 {
 	ASSERT(inst != NULL);
 	ASSERT(buffer != NULL);
 	ASSERT(buffer_len != 0);
+
+	if(inst->use_dio0) {
+		return _pop_packet(inst, buffer, buffer_len);
+	}
+
 	ASSERT(inst->mode == RF_MODE_RX);
 
-	_switch_mode(inst, RF_MODE_STANDBY);
+	/**
+	 * Read the length byte (in variable length mode) and the address byte (with
+	 * address filtering) in one go. The radio already checked the address, so
+	 * it gets skipped over.
+	 */
+	const bool variable = (inst->payload_length == RFM69_VARIABLE_LENGTH_PAYLOAD);
+	const uint32_t address_len = _address_len(inst);
+	const uint32_t header_len = (variable ? 1U : 0U) + address_len;
+	uint8_t header[2];
 
-	/* If in variable length mode, interpret the first byte as the length of the payload. */
-	uint8_t msg_length = 0;
-	if(inst->payload_length == RFM69_VARIABLE_LENGTH_PAYLOAD) {
-		msg_length = rfm69_read_reg(inst, REG_FIFO);
-		ASSERT(msg_length != 0);
-	} else {
-		/* Otherwise, assume a fixed length packet and attempt to read that many bytes. */
-		msg_length = inst->payload_length;
+	if(header_len > 0) {
+		_read_burst(inst, REG_FIFO, header, header_len);
 	}
 
-	/* Restrict number of bytes to read by the buffer length. */
-	msg_length = (buffer_len < msg_length) ? buffer_len : msg_length;
+	uint32_t length = variable ? header[0] : (inst->payload_length + address_len);
+	length = (length > address_len) ? (length - address_len) : 0;
 
-	/* Read the data from the FIFO. */
-	uint8_t num_read = 0;
-	while((num_read < msg_length) &&
-	      GET_RF_IRQ2_FIFO_NOT_EMPTY(rfm69_read_reg(inst, REG_IRQ_FLAGS_2))) {
-		buffer[num_read++] = rfm69_read_reg(inst, REG_FIFO);
+	/* Drain the FIFO until the rest of the payload is guaranteed to fit into it. */
+	uint32_t num_read = 0;
+	bool ok = (length != 0);
+
+	while(ok && ((length - num_read) > RFM69_FIFO_SIZE)) {
+		ok = _wait_irq2(inst, RF_IRQ2_FIFO_LEVEL(), true, get_cycles() + inst->fifo_timeout);
+
+		if(ok) {
+			_read_fifo(inst, buffer, buffer_len, num_read, RFM69_FIFO_THRESHOLD);
+			num_read += RFM69_FIFO_THRESHOLD;
+		}
+	}
+
+	/* A bad CRC clears the FIFO, in which case PayloadReady never gets set. */
+	ok = ok && _wait_irq2(inst, RF_IRQ2_PAYLOAD_READY(), true, get_cycles() + inst->fifo_timeout);
+
+	if(ok) {
+		inst->last_rssi = -(rfm69_read_reg(inst, REG_RSSI_VALUE)) / 2;
+	}
+
+	_switch_mode(inst, RF_MODE_STANDBY);
+
+	if(ok) {
+		_read_fifo(inst, buffer, buffer_len, num_read, length - num_read);
 	}
 
 	/* Clear out any leftover data in the FIFO. */
 	_clear_fifo_flags(inst);
 
-	inst->last_rssi = -(rfm69_read_reg(inst, REG_RSSI_VALUE)) / 2;
+	if(!ok) {
+		dblog("[RFM69] Dropped a bad packet\n");
+		return 0;
+	}
 
-	return num_read;
+	return (buffer_len < length) ? buffer_len : (uint8_t)length;
 }
 
 /**
  * Wait for a packet to be received and return the payload. After the packet is
- * received, the radio will be in standby mode.
+ * received, the radio will be in standby mode (or still in RX mode if
+ * rfm69_enable_interrupts() was called).
+ *
+ * @note Payloads longer than RFM69_FIFO_PAYLOAD_LEN are only received when
+ *       polling. With rfm69_enable_interrupts() they get dropped.
  *
  * @param inst The radio to receive the packet over.
  * @param buffer A buffer to fill with the received payload.
@@ -569,12 +1381,50 @@ uint8_t rfm69_receive(Rfm69Inst *inst, uint8_t *buffer, uint8_t buffer_len)
 	ASSERT(inst != NULL);
 	ASSERT(buffer != NULL);
 
-	_switch_mode(inst, RF_MODE_RX);
+	uint8_t num_read = 0;
+	while(num_read == 0) {
+		_switch_mode(inst, RF_MODE_RX);
 
-	/* Wait for a packet to be received. */
-	while(GET_RF_IRQ2_PAYLOAD_READY(rfm69_read_reg(inst, REG_IRQ_FLAGS_2)) == 0);
+		/* Wait for a packet to be received (bad packets are skipped). */
+		_wait_payload(inst, RFM69_WAIT_FOREVER);
+		num_read = _read_payload(inst, buffer, buffer_len);
+	}
 
-	return _read_payload(inst, buffer, buffer_len);
+	return num_read;
+}
+
+/**
+ * Wait for a packet to be received like rfm69_receive(), but give up if one
+ * doesn't show up in time.
+ *
+ * @param inst The radio to receive the packet over.
+ * @param buffer A buffer to fill with the received payload.
+ * @param buffer_len The maximum amount of bytes to read from the radio.
+ * @param timeout Number of CPU cycles to wait for a packet.
+ *
+ * @return The number of bytes read from the radio (will be buffer_len at max),
+ *         or zero on a timeout.
+ */
+uint8_t rfm69_receive_timeout(Rfm69Inst *inst, uint8_t *buffer, uint8_t buffer_len, uint32_t timeout)
+{
+	ASSERT(inst != NULL);
+	ASSERT(buffer != NULL);
+
+	const uint64_t target_cycles = get_cycles() + timeout;
+
+	uint8_t num_read = 0;
+	while(num_read == 0) {
+		_switch_mode(inst, RF_MODE_RX);
+
+		/* Wait for a packet to be received (bad packets are skipped). */
+		if(!_wait_payload(inst, target_cycles)) {
+			return 0;
+		}
+
+		num_read = _read_payload(inst, buffer, buffer_len);
+	}
+
+	return num_read;
 }
 
 /**
@@ -613,15 +1463,24 @@ bool rfm69_send_with_ack(
 		/* Attempt to send the data. */
 		rfm69_send(inst, data, length);
 
+		/**
+		 * With the DIO0 interrupt, packets received before the send are still
+		 * queued up. Throw them away so one isn't mistaken for the ACK (the
+		 * radio is in standby, so nothing gets queued in the meantime).
+		 */
+		if(inst->use_dio0) {
+			const uint8_t head = __atomic_load_n(&inst->rx_head, __ATOMIC_ACQUIRE);
+
+			inst->rx_dropped += (uint8_t)(head - inst->rx_tail);
+			__atomic_store_n(&inst->rx_tail, head, __ATOMIC_RELEASE);
+		}
+
 		_switch_mode(inst, RF_MODE_RX);
 
 		/* Wait for an ACK packet to be received or there's a timeout. */
-		const uint64_t target_cycles = get_cycles() + timeout;
-		while((GET_RF_IRQ2_PAYLOAD_READY(rfm69_read_reg(inst, REG_IRQ_FLAGS_2)) == 0) &&
-		      (get_cycles() <= target_cycles));
-
-		/* If there was a timeout, then retry again. */
-		if(get_cycles() > target_cycles) {
+		if(!_wait_payload(inst, get_cycles() + timeout)) {
+			/* If there was a timeout, then retry again. */
+			dblog("[RFM69] ACK timeout, retry %u\n", num_retries);
 			num_retries++;
 			continue;
 		}
@@ -636,6 +1495,7 @@ bool rfm69_send_with_ack(
 		/* An acknowledgement packet should only contain one byte, the RFM69_ACK_MAGIC. */
 		if((num_read != 1) || (buffer[0] != RFM69_ACK_MAGIC)) {
 			/* Some other packet was accidentally received, retry again. */
+			dblog("[RFM69] Bad ACK (%u bytes, 0x%x), retry %u\n", num_read, buffer[0], num_retries);
 			num_retries++;
 			continue;
 		}
@@ -668,12 +1528,14 @@ uint8_t rfm69_receive_with_ack(Rfm69Inst *inst, uint8_t *buffer, uint8_t buffer_
 	ASSERT(buffer != NULL);
 	ASSERT(inst->payload_length == RFM69_VARIABLE_LENGTH_PAYLOAD);
 
-	_switch_mode(inst, RF_MODE_RX);
-
-	/* Wait for a packet to be received. */
-	while(GET_RF_IRQ2_PAYLOAD_READY(rfm69_read_reg(inst, REG_IRQ_FLAGS_2)) == 0);
+	uint8_t num_read = 0;
+	while(num_read == 0) {
+		_switch_mode(inst, RF_MODE_RX);
 
-	uint8_t num_read = _read_payload(inst, buffer, buffer_len);
+		/* Wait for a packet to be received (bad packets are skipped). */
+		_wait_payload(inst, RFM69_WAIT_FOREVER);
+		num_read = _read_payload(inst, buffer, buffer_len);
+	}
 
 	/**
 	 * Add a small delay to ensure the other device is in the RX state before
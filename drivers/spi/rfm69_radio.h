@@ -9,21 +9,55 @@
 #pragma once
 
 #include "gpio.h"
+#include "os/task.h"
 #include "spi.h"
 #include "spi/rfm69_radio_reg.h"
+#include "system.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
 /**
- * To simplify operation, restrict the maximum payload length to the internal
- * FIFO size (66 bytes) minus some bytes for overhead (like payload length and CRC).
+ * Maximum payload length the radio supports. Payloads that don't fit into the
+ * FIFO (see RFM69_FIFO_PAYLOAD_LEN) are streamed through it while the packet
+ * is on the air. Long packets can always be sent, but they can only be
+ * received by polling (not after rfm69_enable_interrupts()).
  */
-#define RFM69_MAX_PAYLOAD_LEN 61U
+#define RFM69_MAX_PAYLOAD_LEN 255U
+
+/**
+ * Largest payload that fits entirely in the internal FIFO (66 bytes) minus some
+ * bytes for overhead (like payload length and CRC). This is also the largest
+ * packet the DIO0 interrupt can receive (see rfm69_enable_interrupts()).
+ * Longer packets get dropped on that path.
+ */
+#define RFM69_FIFO_PAYLOAD_LEN 61U
+
+/**
+ * Largest payload the radio can encrypt (see rfm69_set_aes_key()). Encryption
+ * happens inside the FIFO, so encrypted packets can't be streamed.
+ */
+#define RFM69_AES_MAX_PAYLOAD_LEN 64U
+
+/* Size of an AES-128 key. */
+#define RFM69_AES_KEY_LEN 16U
 
 /* Sentinel used to represent a variable length payload in Rfm69Inst->payload_length. */
 #define RFM69_VARIABLE_LENGTH_PAYLOAD 0U
 
+/**
+ * Number of received packets that can be queued up by the DIO0 interrupt (see
+ * rfm69_enable_interrupts()) before they start getting dropped. Must be a
+ * power of two.
+ */
+#define RFM69_RX_QUEUE_LEN 4U
+
+/**
+ * Size of the buffer the DIO0 interrupt reads the FIFO into: the FIFO read
+ * command plus a full payload, rounded up to whole cache lines for the DMA.
+ */
+#define RFM69_RX_BUF_SIZE 64U
+
 /**
  * Possible power modes.
  *
@@ -36,6 +70,48 @@ typedef enum {
 	RFM69_PA1_PA2_BOOST /* +5dBm to +20dBm on RFM69HW/RFM69HCW */
 } Rfm69PowerMode;
 
+/**
+ * Modem settings for common bitrates (see rfm69_set_modem_preset()). Slower
+ * presets trade throughput for range (a narrower receiver bandwidth lets in
+ * less noise), faster ones suit short links.
+ */
+typedef enum {
+	RFM69_MODEM_4800,   /* 4.8kbps, 9.6kHz deviation, 12.5kHz RX bandwidth */
+	RFM69_MODEM_9600,   /* 9.6kbps, 19.2kHz deviation, 25kHz RX bandwidth */
+	RFM69_MODEM_19200,  /* 19.2kbps, 38.4kHz deviation, 50kHz RX bandwidth */
+	RFM69_MODEM_38400,  /* 38.4kbps, 76.8kHz deviation, 100kHz RX bandwidth */
+	RFM69_MODEM_57600,  /* 57.6kbps, 120kHz deviation, 166.7kHz RX bandwidth */
+	RFM69_MODEM_115200, /* 115.2kbps, 115.2kHz deviation, 200kHz RX bandwidth (default) */
+	RFM69_MODEM_250000, /* 250kbps, 250kHz deviation, 400kHz RX bandwidth */
+	RFM69_MODEM_300000  /* 300kbps, 200kHz deviation, 400kHz RX bandwidth */
+} Rfm69ModemPreset;
+
+/**
+ * FSK modem settings (see rfm69_set_modem()). Both ends of a link need to use
+ * the same bitrate and frequency deviation.
+ */
+typedef struct {
+	/* Bitrate in bits per second (1200 to 300000). */
+	uint32_t bitrate;
+
+	/* Frequency deviation in Hz. The modulation index (2 * fdev / bitrate) must be 0.5 to 10. */
+	uint32_t fdev;
+
+	/* Number of preamble bytes sent before the sync word. */
+	uint16_t preamble_len;
+} Rfm69ModemConfig;
+
+/* A packet received by the DIO0 interrupt. */
+typedef struct {
+	/* Number of valid bytes in "data". */
+	uint8_t length;
+
+	/* RSSI (received power) of the packet in dBm. */
+	int16_t rssi;
+
+	uint8_t data[RFM69_FIFO_PAYLOAD_LEN];
+} Rfm69Packet;
+
 /* Structure used to represent a single RFM69 radio. */
 typedef struct {
 	/* SPI module the radio is connected to. */
@@ -52,6 +128,58 @@ typedef struct {
 
 	/* Which power mode the radio is operating in. */
 	Rfm69PowerMode power_mode;
+
+	/* Cycles a full FIFO's worth of data can take to go over the air at the current bitrate. */
+	uint32_t fifo_timeout;
+
+	/* True if every packet starts with an address byte (see rfm69_set_address_filter()). */
+	bool use_address;
+
+	/* Address byte sent at the start of every packet (only valid if use_address is set). */
+	uint8_t dest_address;
+
+	/* True if packets are encrypted by the radio (see rfm69_set_aes_key()). */
+	bool use_aes;
+
+	/* True once rfm69_enable_interrupts() has been called. */
+	bool use_dio0;
+
+	/* The DIO0 pin (only valid if use_dio0 is set). */
+	GpioReg *dio0_reg;
+	GpioPin dio0_pin;
+
+	/* The task waiting on a DIO0 event (NULL if none). */
+	task_t *volatile waiter;
+
+	/* Set by the DIO0 interrupt when a packet has finished transmitting. */
+	volatile bool packet_sent;
+
+	/**
+	 * Packets read out of the FIFO by the DIO0 interrupt. The interrupt adds to
+	 * the head and the receiving task takes from the tail.
+	 */
+	Rfm69Packet rx_queue[RFM69_RX_QUEUE_LEN];
+	volatile uint8_t rx_head;
+	volatile uint8_t rx_tail;
+
+	/**
+	 * Number of packets dropped because the queue was full, the length was bad,
+	 * or they were still queued when rfm69_send_with_ack() sent a packet.
+	 */
+	uint32_t rx_dropped;
+
+	/* True while the DIO0 interrupt's FIFO reads are in progress. */
+	volatile bool rx_busy;
+
+	/* The SPI transactions (and their small buffers) used to read out a packet. */
+	SpiTransaction rx_txns[3];
+	uint8_t rx_cmd[2];
+	uint8_t rx_rssi[2];
+	uint8_t rx_header[2];
+	uint8_t rx_length;
+
+	/* Where the payload gets read into (this is filled in by the DMA). */
+	uint8_t rx_buf[RFM69_RX_BUF_SIZE] __attribute__((aligned(DCACHE_LINE_SIZE)));
 } Rfm69Inst;
 
 void rfm69_init_radio(
@@ -64,11 +192,25 @@ void rfm69_init_radio(
 
 SpiInst* rfm69_get_spi_inst(Rfm69Inst *inst);
 
+/* Packets longer than RFM69_FIFO_PAYLOAD_LEN can't be received once this is called. */
+void rfm69_enable_interrupts(Rfm69Inst *inst, GpioReg *dio0_reg, GpioPin dio0_pin);
+
 void rfm69_set_payload_length(Rfm69Inst *inst, uint8_t length);
 void rfm69_set_power_mode(Rfm69Inst *inst, Rfm69PowerMode mode, uint8_t level);
+void rfm69_set_modem(Rfm69Inst *inst, const Rfm69ModemConfig *config);
+void rfm69_set_modem_preset(Rfm69Inst *inst, Rfm69ModemPreset preset);
+void rfm69_set_frequency(Rfm69Inst *inst, uint32_t frequency);
+void rfm69_set_address_filter(
+	Rfm69Inst *inst,
+	Rfm69AddressFiltering filtering,
+	uint8_t node_address,
+	uint8_t broadcast_address);
+void rfm69_set_destination(Rfm69Inst *inst, uint8_t address);
+void rfm69_set_aes_key(Rfm69Inst *inst, const uint8_t *key);
 
 void rfm69_send(Rfm69Inst *inst, uint8_t *data, uint8_t length);
 uint8_t rfm69_receive(Rfm69Inst *inst, uint8_t *data, uint8_t length);
+uint8_t rfm69_receive_timeout(Rfm69Inst *inst, uint8_t *buffer, uint8_t buffer_len, uint32_t timeout);
 
 bool rfm69_send_with_ack(
 	Rfm69Inst *inst,
@@ -213,6 +213,12 @@ BIT_FIELD2(RF_DIO1_DIO2MAPPING, 2, 3);
 BIT_FIELD2(RF_DIO1_DIO1MAPPING, 4, 5);
 BIT_FIELD2(RF_DIO1_DIO0MAPPING, 6, 7);
 
+/* Packet mode RF_DIO1_DIO0MAPPING values used by the driver (the event depends on the mode). */
+typedef enum {
+	RF_DIO0_PACKET_SENT   = 0, /* TX mode. */
+	RF_DIO0_PAYLOAD_READY = 1  /* RX mode. */
+} Rfm69Dio0Mapping;
+
 /* Dio Mapping 2 Register. */
 #define REG_DIO_MAPPING_2 0x26U
 BIT_FIELD2(RF_DIO2_CLKOUT, 0, 2);
@@ -0,0 +1,250 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Definitions and functions used to manipulate the general purpose DMA
+ * controllers (DMA1/DMA2).
+ *
+ * Each stream gets claimed by a single driver with dma_init_stream(), which
+ * picks the request channel the stream listens to and the callback that gets
+ * run from the stream's interrupt. That driver then kicks off transfers with
+ * dma_start(). Which stream/channel pairs can serve which peripheral is fixed
+ * by the hardware (see the DMA request mapping tables in the reference
+ * manual).
+ */
+#include "config.h"
+#include "debug.h"
+#include "dma.h"
+#include "interrupt.h"
+#include "system.h"
+
+#include "registers/dma_reg.h"
+#include "registers/rcc_reg.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Number of DMA controllers. */
+#define DMA_NUM_CONTROLLERS 2U
+
+/* Per-stream state. */
+typedef struct {
+	uint8_t channel;
+	DmaCallback callback;
+	void *arg;
+} DmaStreamState;
+
+static DmaStreamState stream_states[DMA_NUM_CONTROLLERS][DMA_NUM_STREAMS];
+
+/**
+ * @return The index of the given DMA controller (0 for DMA1, 1 for DMA2).
+ */
+static inline uint32_t _dma_index(DmaReg *dma)
+{
+	ASSERT((dma == DMA1) || (dma == DMA2));
+
+	return (dma == DMA1) ? 0U : 1U;
+}
+
+/**
+ * @return The interrupt flags currently set for a stream (shifted down to the
+ *         stream 0 positions).
+ */
+static inline uint32_t _get_flags(DmaReg *dma, uint8_t stream)
+{
+	const uint32_t isr = (stream < 4U) ? dma->LISR : dma->HISR;
+
+	return (isr >> DMA_ISR_SHIFT(stream)) & DMA_ISR_ALL;
+}
+
+/**
+ * Clear interrupt flags (given in the stream 0 positions) for a stream.
+ */
+static inline void _clear_flags(DmaReg *dma, uint8_t stream, uint32_t flags)
+{
+	if(stream < 4U) {
+		dma->LIFCR = flags << DMA_ISR_SHIFT(stream);
+	} else {
+		dma->HIFCR = flags << DMA_ISR_SHIFT(stream);
+	}
+}
+
+/**
+ * Interrupt handler shared by every stream. Clears the stream's flags and
+ * passes them along to the stream's callback.
+ */
+static void _dma_isr(DmaReg *dma, uint8_t stream)
+{
+	const uint32_t flags = _get_flags(dma, stream);
+	_clear_flags(dma, stream, flags);
+
+	DmaStreamState *const state = &stream_states[_dma_index(dma)][stream];
+
+	if(state->callback != NULL) {
+		state->callback(state->arg, flags);
+	}
+}
+
+/* Generate an interrupt handler for each stream. */
+#define DMA_ISR(dma_num, stream) \
+	static void _dma##dma_num##_stream##stream##_isr(void) { _dma_isr(DMA##dma_num, stream); }
+DMA_ISR(1, 0)
+DMA_ISR(1, 1)
+DMA_ISR(1, 2)
+DMA_ISR(1, 3)
+DMA_ISR(1, 4)
+DMA_ISR(1, 5)
+DMA_ISR(1, 6)
+DMA_ISR(1, 7)
+DMA_ISR(2, 0)
+DMA_ISR(2, 1)
+DMA_ISR(2, 2)
+DMA_ISR(2, 3)
+DMA_ISR(2, 4)
+DMA_ISR(2, 5)
+DMA_ISR(2, 6)
+DMA_ISR(2, 7)
+
+static const isr_func_t stream_isrs[DMA_NUM_CONTROLLERS][DMA_NUM_STREAMS] = {
+	{
+		_dma1_stream0_isr, _dma1_stream1_isr, _dma1_stream2_isr, _dma1_stream3_isr,
+		_dma1_stream4_isr, _dma1_stream5_isr, _dma1_stream6_isr, _dma1_stream7_isr
+	},
+	{
+		_dma2_stream0_isr, _dma2_stream1_isr, _dma2_stream2_isr, _dma2_stream3_isr,
+		_dma2_stream4_isr, _dma2_stream5_isr, _dma2_stream6_isr, _dma2_stream7_isr
+	}
+};
+
+static const irq_num_t stream_irqs[DMA_NUM_CONTROLLERS][DMA_NUM_STREAMS] = {
+	{
+		DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+		DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn
+	},
+	{
+		DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+		DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn
+	}
+};
+
+/**
+ * Claim a DMA stream. This enables the DMA controller's clock and the stream's
+ * interrupt.
+ *
+ * @param dma The DMA controller the stream belongs to (DMA1 or DMA2).
+ * @param stream The stream to claim (0-7).
+ * @param channel The request channel the stream should listen to (0-7).
+ * @param callback Called from the stream's interrupt (can be NULL).
+ * @param arg Argument passed to the callback.
+ */
+void dma_init_stream(
+	DmaReg *dma,
+	uint8_t stream,
+	uint8_t channel,
+	DmaCallback callback,
+	void *arg)
+{
+	ASSERT(stream < DMA_NUM_STREAMS);
+	ASSERT(channel <= GET_DMA_SxCR_CHSEL(DMA_SxCR_CHSEL()));
+
+	const uint32_t index = _dma_index(dma);
+	DmaStreamState *const state = &stream_states[index][stream];
+
+	SET_FIELD(RCC->AHB1ENR, (index == 0) ? RCC_AHB1ENR_DMA1EN() : RCC_AHB1ENR_DMA2EN());
+	DSB();
+
+	dma_stop(dma, stream);
+
+	state->channel = channel;
+	state->callback = callback;
+	state->arg = arg;
+
+	intr_register(stream_irqs[index][stream], stream_isrs[index][stream], LOWEST_INTR_PRIORITY);
+}
+
+/**
+ * Start a transfer on a stream (stopping any transfer still in progress).
+ *
+ * @note For memory-to-peripheral transfers out of cacheable memory, clean the
+ *       data cache over the buffer first (see dcache_clean()). For
+ *       peripheral-to-memory transfers, invalidate it before reading the data.
+ *
+ * @param dma The DMA controller the stream belongs to.
+ * @param stream The stream to use (must have been claimed with dma_init_stream()).
+ * @param config Stream configuration register value (direction, data sizes,
+ *               increment modes, interrupt enables, etc.). The channel and
+ *               enable bits get filled in by this function.
+ * @param periph_addr Address of the peripheral's data register.
+ * @param mem_addr Address of the memory buffer.
+ * @param count Number of data items to transfer.
+ */
+void dma_start(
+	DmaReg *dma,
+	uint8_t stream,
+	uint32_t config,
+	volatile void *periph_addr,
+	const void *mem_addr,
+	uint16_t count)
+{
+	ASSERT(stream < DMA_NUM_STREAMS);
+	ASSERT(count > 0);
+
+	DmaStreamReg *const regs = &dma->STREAM[stream];
+	const DmaStreamState *const state = &stream_states[_dma_index(dma)][stream];
+
+	dma_stop(dma, stream);
+
+	regs->PAR = (uint32_t)periph_addr;
+	regs->M0AR = (uint32_t)mem_addr;
+	regs->NDTR = count;
+
+	/* Direct mode (no FIFO). */
+	regs->FCR = 0;
+
+	/* Make sure the buffer contents are visible to the DMA before it starts. */
+	DSB();
+
+	regs->CR = (config & ~(DMA_SxCR_CHSEL() | DMA_SxCR_EN())) | SET_DMA_SxCR_CHSEL(state->channel);
+	SET_FIELD(regs->CR, DMA_SxCR_EN());
+}
+
+/**
+ * Stop any transfer in progress on a stream and clear its interrupt flags.
+ *
+ * @param dma The DMA controller the stream belongs to.
+ * @param stream The stream to stop.
+ */
+void dma_stop(DmaReg *dma, uint8_t stream)
+{
+	ASSERT(stream < DMA_NUM_STREAMS);
+
+	DmaStreamReg *const regs = &dma->STREAM[stream];
+
+	CLEAR_FIELD(regs->CR, DMA_SxCR_EN());
+
+	/* The stream only stops once the current data item has been transferred. */
+	while(GET_DMA_SxCR_EN(regs->CR)) { }
+
+	_clear_flags(dma, stream, DMA_ISR_ALL);
+}
+
+/**
+ * @return The number of data items the stream still has left to transfer.
+ *         Circular transfers reload this once it reaches zero.
+ */
+uint16_t dma_get_remaining(DmaReg *dma, uint8_t stream)
+{
+	ASSERT(stream < DMA_NUM_STREAMS);
+
+	return (uint16_t)dma->STREAM[stream].NDTR;
+}
+
+/**
+ * @return True if the stream is currently enabled (a transfer is in progress).
+ */
+bool dma_is_busy(DmaReg *dma, uint8_t stream)
+{
+	ASSERT(stream < DMA_NUM_STREAMS);
+
+	return GET_DMA_SxCR_EN(dma->STREAM[stream].CR);
+}
@@ -0,0 +1,77 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Definitions and functions used to manipulate the general purpose DMA
+ * controllers (DMA1/DMA2).
+ */
+#pragma once
+
+#include "registers/dma_reg.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * DMA request mappings (controller, stream, channel) for the peripherals that
+ * have drivers using DMA. These expand into three arguments just like the GPIO
+ * pin macros, e.g., usart_enable_dma_tx(USART6, DMA_USART6_TX).
+ *
+ * Some requests can be served by more than one stream (see the DMA request
+ * mapping tables in the reference manual). Two peripherals can't share a
+ * stream at the same time.
+ */
+#define DMA_USART1_TX DMA2, 7, 4
+#define DMA_USART1_RX DMA2, 5, 4
+#define DMA_USART2_TX DMA1, 6, 4
+#define DMA_USART2_RX DMA1, 5, 4
+#define DMA_USART3_TX DMA1, 3, 4
+#define DMA_USART3_RX DMA1, 1, 4
+#define DMA_UART4_TX  DMA1, 4, 4
+#define DMA_UART4_RX  DMA1, 2, 4
+#define DMA_UART5_TX  DMA1, 7, 4
+#define DMA_UART5_RX  DMA1, 0, 4
+#define DMA_USART6_TX DMA2, 6, 5
+#define DMA_USART6_RX DMA2, 1, 5
+#define DMA_UART7_TX  DMA1, 1, 5
+#define DMA_UART7_RX  DMA1, 3, 5
+#define DMA_UART8_TX  DMA1, 0, 5
+#define DMA_UART8_RX  DMA1, 6, 5
+#define DMA_SPI1_TX   DMA2, 3, 3
+#define DMA_SPI1_RX   DMA2, 2, 3
+#define DMA_SPI2_TX   DMA1, 4, 0
+#define DMA_SPI2_RX   DMA1, 3, 0
+#define DMA_SPI3_TX   DMA1, 7, 0
+#define DMA_SPI3_RX   DMA1, 2, 0
+#define DMA_SPI4_TX   DMA2, 1, 4
+#define DMA_SPI4_RX   DMA2, 0, 4
+#define DMA_SPI5_TX   DMA2, 4, 2
+#define DMA_SPI5_RX   DMA2, 3, 2
+#define DMA_SPI6_TX   DMA2, 5, 1
+#define DMA_SPI6_RX   DMA2, 6, 1
+
+/**
+ * Called from the DMA stream's interrupt. "flags" contains the stream's
+ * interrupt flags (DMA_ISR_TCIF(), DMA_ISR_HTIF(), DMA_ISR_TEIF(), etc.) that
+ * were set, already shifted down to the stream 0 positions.
+ */
+typedef void (*DmaCallback)(void *arg, uint32_t flags);
+
+void dma_init_stream(
+	DmaReg *dma,
+	uint8_t stream,
+	uint8_t channel,
+	DmaCallback callback,
+	void *arg);
+
+void dma_start(
+	DmaReg *dma,
+	uint8_t stream,
+	uint32_t config,
+	volatile void *periph_addr,
+	const void *mem_addr,
+	uint16_t count);
+void dma_stop(DmaReg *dma, uint8_t stream);
+
+uint16_t dma_get_remaining(DmaReg *dma, uint8_t stream);
+bool dma_is_busy(DmaReg *dma, uint8_t stream);
@@ -10,6 +10,7 @@
 #include "debug.h"
 #include "dma2d.h"
 #include "interrupt.h"
+#include "os/work_queue.h"
 #include "system.h"
 
 #include "registers/dma2d_reg.h"
@@ -27,6 +28,21 @@ static volatile bool dma_complete = true;
 /* The callback function to call when a DMA transfer finishes. */
 static void (*dma_callback) (void) = NULL;
 
+#if ENABLE_WORK_QUEUE
+/* Work item used to run the DMA callback outside of interrupt context. */
+static work_t dma_work;
+
+/**
+ * Run the DMA callback from the work queue.
+ */
+static void _dma_callback_work(__unused void *arg)
+{
+	if(dma_callback != NULL) {
+		dma_callback();
+	}
+}
+#endif /* ENABLE_WORK_QUEUE */
+
 /**
  * DMA2D ISR. Set dma_complete if transfer complete or spin on error.
  */
@@ -36,9 +52,13 @@ void dma2d_isr(void)
 		SET_FIELD(DMA2D->IFCR, DMA2D_IFCR_CTCIF());
 		dma_complete = true;
 
+#if ENABLE_WORK_QUEUE
+		work_submit(&dma_work);
+#else
 		if(dma_callback != NULL) {
 			dma_callback();
 		}
+#endif /* ENABLE_WORK_QUEUE */
 	} else if(GET_DMA2D_ISR_TEIF(DMA2D->ISR)) {
 		SET_FIELD(DMA2D->IFCR, DMA2D_IFCR_CTEIF());
 		ABORT("DMA2D Error: Transfer Error\n");
@@ -60,6 +80,10 @@ void dma2d_init(void)
 	SET_FIELD(RCC->AHB1ENR, RCC_AHB1ENR_DMA2DEN());
 	DSB();
 
+#if ENABLE_WORK_QUEUE
+	work_init(&dma_work, _dma_callback_work, NULL);
+#endif /* ENABLE_WORK_QUEUE */
+
 	/* Setup interrupt service routine. */
 	SET_FIELD(DMA2D->CR, DMA2D_CR_TCIE() |
 	                     DMA2D_ISR_TEIF() |
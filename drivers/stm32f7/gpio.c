@@ -7,12 +7,32 @@
 #include "bitfield.h"
 #include "debug.h"
 #include "gpio.h"
+#include "interrupt.h"
 #include "system.h"
 
+#include "registers/exti_reg.h"
 #include "registers/gpio_reg.h"
 #include "registers/rcc_reg.h"
+#include "registers/syscfg_reg.h"
 
 #include <stdbool.h>
+#include <stddef.h>
+
+/* The handler (and its argument) for each EXTI line requested as an interrupt. */
+typedef struct {
+	GpioCallback callback;
+	void *arg;
+} GpioIntrHandler;
+
+static GpioIntrHandler exti_handlers[EXTI_NUM_GPIO_LINES];
+
+/* The interrupt each EXTI line triggers (lines 5-9 and 10-15 share one). */
+static const irq_num_t exti_irqs[EXTI_NUM_GPIO_LINES] = {
+	EXTI0_IRQn, EXTI1_IRQn, EXTI2_IRQn, EXTI3_IRQn, EXTI4_IRQn,
+	EXTI9_5_IRQn, EXTI9_5_IRQn, EXTI9_5_IRQn, EXTI9_5_IRQn, EXTI9_5_IRQn,
+	EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn,
+	EXTI15_10_IRQn, EXTI15_10_IRQn, EXTI15_10_IRQn
+};
 
 /*
  * Check if a pin is already in use, and enable it's port clock if not.
@@ -178,3 +198,124 @@ DigitalState gpio_get_input(GpioReg *reg, GpioPin pin)
 {
 	return (DigitalState)((reg->IDR >> GPIO_GET_PIN(pin)) & 0x1U);
 }
+
+/**
+ * Shared by every EXTI interrupt. Calls the handler for each pending line that
+ * has its interrupt enabled.
+ */
+static void _exti_isr(void)
+{
+	const uint32_t pending = EXTI->PR & EXTI->IMR & (EXTI_LINE(EXTI_NUM_GPIO_LINES) - 1U);
+
+	/* Writing a one clears the pending bit. */
+	EXTI->PR = pending;
+
+	for(uint32_t line = 0; line < EXTI_NUM_GPIO_LINES; ++line) {
+		if(pending & EXTI_LINE(line)) {
+			exti_handlers[line].callback(exti_handlers[line].arg);
+		}
+	}
+}
+
+/**
+ * Request a GPIO pin to be set as an input that generates an interrupt on the
+ * wanted edge(s). The interrupt is enabled before this returns.
+ *
+ * @note Every pin number has a single EXTI line shared by all of the ports
+ *       (e.g., PA3 and PB3 both use line 3), so only one pin per pin number
+ *       can be used as an interrupt.
+ *
+ * @param reg The port register to use.
+ * @param pin The pin to set as an interrupt input.
+ * @param pull The pull state for this pin.
+ * @param trigger Which edge(s) trigger the interrupt.
+ * @param callback Called from the interrupt every time the edge is seen.
+ * @param arg Argument passed to the callback.
+ */
+void gpio_request_interrupt(
+	GpioReg *reg,
+	GpioPin pin,
+	GpioPull pull,
+	GpioTrigger trigger,
+	GpioCallback callback,
+	void *arg)
+{
+	ASSERT(callback != NULL);
+
+	const uint32_t line = GPIO_GET_PIN(pin);
+	const uint32_t mask = EXTI_LINE(line);
+
+	ABORT_IF(exti_handlers[line].callback != NULL);
+
+	gpio_request_input(reg, pin, pull);
+
+	SET_FIELD(RCC->APB2ENR, RCC_APB2ENR_SYSCFGEN());
+	DSB();
+
+	/* Route the pin's port to its EXTI line. */
+	volatile uint32_t *const exticr = &SYSCFG->EXTICR[line / 4U];
+	*exticr = (*exticr & ~(SYSCFG_EXTICR_MASK << SYSCFG_EXTICR_SHIFT(line))) |
+	          ((uint32_t)GPIO_GET_PORT(pin) << SYSCFG_EXTICR_SHIFT(line));
+
+	if(trigger & GPIO_TRIGGER_RISING) {
+		SET_FIELD(EXTI->RTSR, mask);
+	} else {
+		CLEAR_FIELD(EXTI->RTSR, mask);
+	}
+
+	if(trigger & GPIO_TRIGGER_FALLING) {
+		SET_FIELD(EXTI->FTSR, mask);
+	} else {
+		CLEAR_FIELD(EXTI->FTSR, mask);
+	}
+
+	/* Only register the ISR the first time one of the lines sharing it is used. */
+	bool irq_registered = false;
+	for(uint32_t i = 0; i < EXTI_NUM_GPIO_LINES; ++i) {
+		if((exti_irqs[i] == exti_irqs[line]) && (exti_handlers[i].callback != NULL)) {
+			irq_registered = true;
+		}
+	}
+
+	exti_handlers[line].callback = callback;
+	exti_handlers[line].arg = arg;
+
+	if(!irq_registered) {
+		intr_register(exti_irqs[line], _exti_isr, LOWEST_INTR_PRIORITY);
+	}
+
+	gpio_enable_interrupt(reg, pin);
+}
+
+/**
+ * Start generating interrupts for a pin set up with gpio_request_interrupt().
+ * Any edge seen while the interrupt was disabled is thrown away.
+ *
+ * @param reg The port register to use.
+ * @param pin The interrupt pin to enable.
+ */
+void gpio_enable_interrupt(__unused GpioReg *reg, GpioPin pin)
+{
+	const uint32_t line = GPIO_GET_PIN(pin);
+
+	ASSERT(exti_handlers[line].callback != NULL);
+
+	EXTI->PR = EXTI_LINE(line);
+
+	const uint32_t primask = intr_enter_critical();
+	SET_FIELD(EXTI->IMR, EXTI_LINE(line));
+	intr_exit_critical(primask);
+}
+
+/**
+ * Stop generating interrupts for a pin set up with gpio_request_interrupt().
+ *
+ * @param reg The port register to use.
+ * @param pin The interrupt pin to disable.
+ */
+void gpio_disable_interrupt(__unused GpioReg *reg, GpioPin pin)
+{
+	const uint32_t primask = intr_enter_critical();
+	CLEAR_FIELD(EXTI->IMR, EXTI_LINE(GPIO_GET_PIN(pin)));
+	intr_exit_critical(primask);
+}
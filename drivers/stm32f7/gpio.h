@@ -45,6 +45,16 @@ typedef enum 	{
 	GPIO_PULL_DOWN = 0x2
 } GpioPull;
 
+/* Which edges of an input generate an interrupt (see gpio_request_interrupt()). */
+typedef enum {
+	GPIO_TRIGGER_RISING = 0x1,
+	GPIO_TRIGGER_FALLING = 0x2,
+	GPIO_TRIGGER_BOTH = 0x3
+} GpioTrigger;
+
+/* Called from the EXTI interrupt when a GPIO interrupt pin sees its edge. */
+typedef void (*GpioCallback)(void *arg);
+
 /**
  * Each pin has up to 16 different alternate functions it can take on.
  *
@@ -468,3 +478,13 @@ void gpio_set_pullstate(GpioReg *reg, GpioPin pin, GpioPull pull);
 
 void gpio_set_output(GpioReg *reg, GpioPin pin, DigitalState state);
 DigitalState gpio_get_input(GpioReg *reg, GpioPin pin);
+
+void gpio_request_interrupt(
+	GpioReg *reg,
+	GpioPin pin,
+	GpioPull pull,
+	GpioTrigger trigger,
+	GpioCallback callback,
+	void *arg);
+void gpio_enable_interrupt(GpioReg *reg, GpioPin pin);
+void gpio_disable_interrupt(GpioReg *reg, GpioPin pin);
@@ -11,6 +11,7 @@
 #include "gpio.h"
 #include "interrupt.h"
 #include "lcd_ctrl.h"
+#include "os/work_queue.h"
 #include "system.h"
 
 #include "registers/lcd_ctrl_reg.h"
@@ -30,6 +31,19 @@
 /* The callback function to call when a vertical blanking period occurs. */
 static void (*vblank_callback) (void) = NULL;
 
+#if ENABLE_WORK_QUEUE
+/* Work item used to run the vblank callback outside of interrupt context. */
+static work_t vblank_work;
+
+/**
+ * Run the vblank callback from the work queue.
+ */
+static void _vblank_callback_work(__unused void *arg)
+{
+	vblank_callback();
+}
+#endif /* ENABLE_WORK_QUEUE */
+
 /**
  * Triggered during every vertical blanking period.
  */
@@ -38,9 +52,14 @@ static void vblank_isr(void)
 	if(GET_LTDC_ISR_LIF(LTDC->ISR)) {
 		SET_FIELD(LTDC->ICR, LTDC_ICR_CLIF());
 
+#if ENABLE_WORK_QUEUE
+		/* If the last vblank's work hasn't run yet, this period gets skipped. */
+		work_submit(&vblank_work);
+#else
 		if(vblank_callback != NULL) {
 			vblank_callback();
 		}
+#endif /* ENABLE_WORK_QUEUE */
 	}
 }
 
@@ -147,6 +166,9 @@ void lcd_ctrl_init(uint32_t framebuffer, void (*callback) (void))
 	/* Setup LCD vblank and error interrupts. */
 	vblank_callback = callback;
 	if(vblank_callback) {
+#if ENABLE_WORK_QUEUE
+		work_init(&vblank_work, _vblank_callback_work, NULL);
+#endif /* ENABLE_WORK_QUEUE */
 		intr_register(LTDC_IRQn, vblank_isr, LOWEST_INTR_PRIORITY);
 		SET_FIELD(LTDC->LIPCR, SET_LTDC_LIPCR_LIPOS(LCD_CONFIG_HEIGHT));
 		SET_FIELD(LTDC->IER, LTDC_IER_LIE());
@@ -0,0 +1,107 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * DMA Controller (DMA1/DMA2) Register Map.
+ */
+#pragma once
+
+#include "bitfield.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+/* Number of streams in each DMA controller. */
+#define DMA_NUM_STREAMS 8U
+
+/* Type defining a single DMA stream's register map. */
+typedef struct {
+	volatile uint32_t CR;   /* DMA stream configuration register,      Address offset: 0x10 + 0x18 * stream */
+	volatile uint32_t NDTR; /* DMA stream number of data register,     Address offset: 0x14 + 0x18 * stream */
+	volatile uint32_t PAR;  /* DMA stream peripheral address register, Address offset: 0x18 + 0x18 * stream */
+	volatile uint32_t M0AR; /* DMA stream memory 0 address register,   Address offset: 0x1C + 0x18 * stream */
+	volatile uint32_t M1AR; /* DMA stream memory 1 address register,   Address offset: 0x20 + 0x18 * stream */
+	volatile uint32_t FCR;  /* DMA stream FIFO control register,       Address offset: 0x24 + 0x18 * stream */
+} DmaStreamReg;
+
+/* Type defining the DMA Controller register map. */
+typedef struct {
+	volatile uint32_t LISR;  /* DMA low interrupt status register,      Address offset: 0x00 */
+	volatile uint32_t HISR;  /* DMA high interrupt status register,     Address offset: 0x04 */
+	volatile uint32_t LIFCR; /* DMA low interrupt flag clear register,  Address offset: 0x08 */
+	volatile uint32_t HIFCR; /* DMA high interrupt flag clear register, Address offset: 0x0C */
+	DmaStreamReg STREAM[DMA_NUM_STREAMS];
+} DmaReg;
+
+/* Define the DMA Controller register map accessors. */
+#define DMA1_BASE (AHB1PERIPH_BASE + 0x6000U)
+#define DMA2_BASE (AHB1PERIPH_BASE + 0x6400U)
+
+#define DMA1 ((DmaReg *) DMA1_BASE)
+#define DMA2 ((DmaReg *) DMA2_BASE)
+
+/**
+ * Interrupt status/clear register flags for a single stream. Streams 0-3 live
+ * in the low registers and 4-7 in the high registers, at a bit offset of
+ * DMA_ISR_SHIFT(stream).
+ */
+BIT_FIELD2(DMA_ISR_FEIF,  0, 0);
+BIT_FIELD2(DMA_ISR_DMEIF, 2, 2);
+BIT_FIELD2(DMA_ISR_TEIF,  3, 3);
+BIT_FIELD2(DMA_ISR_HTIF,  4, 4);
+BIT_FIELD2(DMA_ISR_TCIF,  5, 5);
+
+/* All of a stream's interrupt flags. */
+#define DMA_ISR_ALL (DMA_ISR_FEIF() | DMA_ISR_DMEIF() | DMA_ISR_TEIF() | DMA_ISR_HTIF() | DMA_ISR_TCIF())
+
+/* Bit offset of a stream's flags within the (low or high) status registers. */
+#define DMA_ISR_SHIFT(stream) ((((stream) & 1U) * 6U) + ((((stream) >> 1U) & 1U) * 16U))
+
+/* Stream Configuration Register. */
+BIT_FIELD2(DMA_SxCR_EN,      0, 0);
+BIT_FIELD2(DMA_SxCR_DMEIE,   1, 1);
+BIT_FIELD2(DMA_SxCR_TEIE,    2, 2);
+BIT_FIELD2(DMA_SxCR_HTIE,    3, 3);
+BIT_FIELD2(DMA_SxCR_TCIE,    4, 4);
+BIT_FIELD2(DMA_SxCR_PFCTRL,  5, 5);
+BIT_FIELD2(DMA_SxCR_DIR,     6, 7);
+BIT_FIELD2(DMA_SxCR_CIRC,    8, 8);
+BIT_FIELD2(DMA_SxCR_PINC,    9, 9);
+BIT_FIELD2(DMA_SxCR_MINC,   10, 10);
+BIT_FIELD2(DMA_SxCR_PSIZE,  11, 12);
+BIT_FIELD2(DMA_SxCR_MSIZE,  13, 14);
+BIT_FIELD2(DMA_SxCR_PINCOS, 15, 15);
+BIT_FIELD2(DMA_SxCR_PL,     16, 17);
+BIT_FIELD2(DMA_SxCR_DBM,    18, 18);
+BIT_FIELD2(DMA_SxCR_CT,     19, 19);
+BIT_FIELD2(DMA_SxCR_PBURST, 21, 22);
+BIT_FIELD2(DMA_SxCR_MBURST, 23, 24);
+BIT_FIELD2(DMA_SxCR_CHSEL,  25, 27);
+
+/* DMA_SxCR_DIR (Data transfer direction) field options. */
+typedef enum {
+	DMA_PERIPH_TO_MEM = 0,
+	DMA_MEM_TO_PERIPH = 1,
+	DMA_MEM_TO_MEM = 2
+} DmaDirection;
+
+/* DMA_SxCR_PSIZE/MSIZE (Data size) field options. */
+typedef enum {
+	DMA_SIZE_8BIT = 0,
+	DMA_SIZE_16BIT = 1,
+	DMA_SIZE_32BIT = 2
+} DmaDataSize;
+
+/* DMA_SxCR_PL (Priority level) field options. */
+typedef enum {
+	DMA_PRIORITY_LOW = 0,
+	DMA_PRIORITY_MEDIUM = 1,
+	DMA_PRIORITY_HIGH = 2,
+	DMA_PRIORITY_VERY_HIGH = 3
+} DmaPriority;
+
+/* Stream FIFO Control Register. */
+BIT_FIELD2(DMA_SxFCR_FTH,   0, 1);
+BIT_FIELD2(DMA_SxFCR_DMDIS, 2, 2);
+BIT_FIELD2(DMA_SxFCR_FS,    3, 5);
+BIT_FIELD2(DMA_SxFCR_FEIE,  7, 7);
@@ -0,0 +1,35 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * External Interrupt/Event Controller (EXTI) Register map.
+ */
+#pragma once
+
+#include "bitfield.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+/* Number of EXTI lines that can be connected to GPIO pins (one per pin number). */
+#define EXTI_NUM_GPIO_LINES 16U
+
+/**
+ * Type defining the EXTI register map. Every register has one bit per line, so
+ * line N is bit N.
+ */
+typedef struct {
+	volatile uint32_t IMR;   /* Interrupt mask register,            Address offset: 0x00 */
+	volatile uint32_t EMR;   /* Event mask register,                Address offset: 0x04 */
+	volatile uint32_t RTSR;  /* Rising trigger selection register,  Address offset: 0x08 */
+	volatile uint32_t FTSR;  /* Falling trigger selection register, Address offset: 0x0C */
+	volatile uint32_t SWIER; /* Software interrupt event register,  Address offset: 0x10 */
+	volatile uint32_t PR;    /* Pending register,                   Address offset: 0x14 */
+} ExtiReg;
+
+/* Define the EXTI register map accessor. */
+#define EXTI_BASE (APB2PERIPH_BASE + 0x3C00U)
+#define EXTI ((ExtiReg *) EXTI_BASE)
+
+/* Mask for a single line in any of the EXTI registers. */
+#define EXTI_LINE(line) (1UL << (line))
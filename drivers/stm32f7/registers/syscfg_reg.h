@@ -0,0 +1,33 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * System Configuration Controller (SYSCFG) Register map.
+ */
+#pragma once
+
+#include "bitfield.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+/* Type defining the SYSCFG register map. */
+typedef struct {
+	volatile uint32_t MEMRMP;      /* Memory remap register,                      Address offset: 0x00      */
+	volatile uint32_t PMC;         /* Peripheral mode configuration register,     Address offset: 0x04      */
+	volatile uint32_t EXTICR[4];   /* External interrupt configuration registers, Address offset: 0x08-0x14 */
+	volatile uint32_t RESERVED[2]; /* Reserved,                                   Address offset: 0x18-0x1C */
+	volatile uint32_t CMPCR;       /* Compensation cell control register,         Address offset: 0x20      */
+} SyscfgReg;
+
+/* Define the SYSCFG register map accessor. */
+#define SYSCFG_BASE (APB2PERIPH_BASE + 0x3800U)
+#define SYSCFG ((SyscfgReg *) SYSCFG_BASE)
+
+/**
+ * External Interrupt Configuration Registers. Each register selects the GPIO
+ * port (0 = Port A, 1 = Port B, etc.) for four EXTI lines, with line N's field
+ * in EXTICR[N / 4] at a bit offset of SYSCFG_EXTICR_SHIFT(N).
+ */
+#define SYSCFG_EXTICR_MASK 0xFU
+#define SYSCFG_EXTICR_SHIFT(line) (((line) % 4U) * 4U)
@@ -205,7 +205,7 @@ static SdStatus send_cmd(
 
 	if((type == SD_SHORT_RESP) && !is_acmd41 &&
 	   (GET_SDMMC_RESPCMD_RESPCMD(SDMMC->RESPCMD) != cmd_index)) {
-		dbprintf("[SDMMC] Received invalid RESPCMD: %u %lu\n", cmd_index, SDMMC->RESPCMD);
+		dblog("[SDMMC] Received invalid RESPCMD: %u %lu\n", cmd_index, SDMMC->RESPCMD);
 		return SD_INCORRECT_RESPCMD;
 	}
 
@@ -491,7 +491,7 @@ static SdStatus wait_for_card_ready(void)
 	do {
 		status = send_cmd13_send_status(&card_status);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD13_SEND_STATUS %d\n", status);
+			dblog("[SDMMC] Failed to send CMD13_SEND_STATUS %d\n", status);
 			return status;
 		}
 	} while(!(card_status & R1_READY_FOR_DATA));
@@ -624,20 +624,20 @@ SdStatus sd_read_data(void *data, uint32_t block_addr, uint16_t num_blocks)
 	if(num_blocks == 1) {
 		status = send_cmd(SD_CMD17_READ_SINGLE_BLOCK, block_addr, SD_SHORT_RESP, &resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD17_READ_SINGLE_BLOCK %d\n", status);
+			dblog("[SDMMC] Failed to send CMD17_READ_SINGLE_BLOCK %d\n", status);
 			return status;
 		}
 	} else {
 		status = send_cmd(SD_CMD18_READ_MULTIPLE_BLOCK, block_addr, SD_SHORT_RESP, &resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD18_READ_MULTIPLE_BLOCK %d\n", status);
+			dblog("[SDMMC] Failed to send CMD18_READ_MULTIPLE_BLOCK %d\n", status);
 			return status;
 		}
 	}
 
 	status = check_r1_resp(resp);
 	if(status != SD_SUCCESS) {
-		dbprintf("[SDMMC] R1 response from CMD17/CMD18 (Read Blocks) contains errors: %d\n", status);
+		dblog("[SDMMC] R1 response from CMD17/CMD18 (Read Blocks) contains errors: %d\n", status);
 		return status;
 	}
 
@@ -659,13 +659,13 @@ SdStatus sd_read_data(void *data, uint32_t block_addr, uint16_t num_blocks)
 	if((GET_SDMMC_STA_DATAEND(flags)) && (num_blocks > 1)) {
 		status = send_cmd(SD_CMD12_STOP_TRANSMISSION, 0, SD_SHORT_RESP, &resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD12_STOP_TRANSMISSION %d\n", status);
+			dblog("[SDMMC] Failed to send CMD12_STOP_TRANSMISSION %d\n", status);
 			return status;
 		}
 
 		status = check_r1_resp(resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] R1 response from CMD12 (Stop Transmission) contains errors: %d\n", status);
+			dblog("[SDMMC] R1 response from CMD12 (Stop Transmission) contains errors: %d\n", status);
 			return status;
 		}
 	}
@@ -716,20 +716,20 @@ SdStatus sd_write_data(void *data, uint32_t block_addr, uint16_t num_blocks)
 	if(num_blocks == 1) {
 		status = send_cmd(SD_CMD24_WRITE_BLOCK, block_addr, SD_SHORT_RESP, &resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD24_WRITE_BLOCK %d\n", status);
+			dblog("[SDMMC] Failed to send CMD24_WRITE_BLOCK %d\n", status);
 			return status;
 		}
 	} else {
 		status = send_cmd(SD_CMD25_WRITE_MULTIPLE_BLOCK, block_addr, SD_SHORT_RESP, &resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD25_WRITE_MULTIPLE_BLOCK %d\n", status);
+			dblog("[SDMMC] Failed to send CMD25_WRITE_MULTIPLE_BLOCK %d\n", status);
 			return status;
 		}
 	}
 
 	status = check_r1_resp(resp);
 	if(status != SD_SUCCESS) {
-		dbprintf("[SDMMC] R1 response from CMD24/CMD25 (Write Blocks) contains errors: %d\n", status);
+		dblog("[SDMMC] R1 response from CMD24/CMD25 (Write Blocks) contains errors: %d\n", status);
 		return status;
 	}
 
@@ -762,13 +762,13 @@ SdStatus sd_write_data(void *data, uint32_t block_addr, uint16_t num_blocks)
 	if((GET_SDMMC_STA_DATAEND(flags)) && (num_blocks > 1)) {
 		status = send_cmd(SD_CMD12_STOP_TRANSMISSION, 0, SD_SHORT_RESP, &resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] Failed to send CMD12_STOP_TRANSMISSION %d\n", status);
+			dblog("[SDMMC] Failed to send CMD12_STOP_TRANSMISSION %d\n", status);
 			return status;
 		}
 
 		status = check_r1_resp(resp);
 		if(status != SD_SUCCESS) {
-			dbprintf("[SDMMC] R1 response from CMD12 (Stop Transmission) contains errors: %d\n", status);
+			dblog("[SDMMC] R1 response from CMD12 (Stop Transmission) contains errors: %d\n", status);
 			return status;
 		}
 	}
@@ -4,17 +4,106 @@
  *
  * Definitions and functions used to manipulate the SPI module. The only SPI
  * configuration currently supported is full-duplex master mode.
+ *
+ * Besides the polled functions, whole transactions (slave select asserted,
+ * data transferred, slave select released) can be run with spi_transaction()
+ * and spi_transaction_async(). Each SPI module acts as a bus that queues up the
+ * transactions from every device (SpiInst) connected to it and runs them one
+ * at a time, so devices sharing a module can be used from different tasks. The
+ * module only gets reconfigured when a transaction is for a different device
+ * than the last one. Once spi_enable_dma() has given an SPI module a pair of
+ * DMA streams, longer transactions are moved by the DMA controller so the CPU
+ * is free (and the calling task sleeps) for the length of the transfer.
  */
+#include "config.h"
 #include "debug.h"
+#include "dma.h"
+#include "interrupt.h"
+#include "os/task.h"
 #include "spi.h"
 #include "system.h"
 
+#include "registers/dma_reg.h"
 #include "registers/rcc_reg.h"
 #include "registers/spi_reg.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/* Size of the TX and RX FIFOs in bytes. */
+#define SPI_FIFO_SIZE 4U
+
+/* Data sent when a transfer only cares about what's received. */
+#define SPI_DUMMY_DATA 0x0000U
+
+/* Number of SPI modules. */
+#define SPI_NUM_MODULES 6U
+
+/**
+ * Transactions shorter than this many frames are run without DMA, since
+ * setting up the DMA streams takes longer than just sending them.
+ */
+#define SPI_DMA_MIN_LEN 16U
+
+/**
+ * State for a single SPI module (bus). Every SpiInst on the module submits its
+ * transactions to the bus's queue and they're run one at a time, in order.
+ */
+typedef struct {
+	/* Streams used to feed the TX FIFO and drain the RX FIFO (NULL if no DMA). */
+	DmaReg *tx_dma;
+	uint8_t tx_stream;
+	DmaReg *rx_dma;
+	uint8_t rx_stream;
+
+	/**
+	 * Transactions waiting to run. The head is the one in progress while the
+	 * bus is busy.
+	 */
+	SpiTransaction *head;
+	SpiTransaction *tail;
+
+	/* True while something is running transactions or holding the bus. */
+	bool busy;
+
+	/* The instance that's been given the bus by spi_bus_acquire() (if any). */
+	SpiInst *owner;
+
+	/* The instance whose configuration was last written into the module. */
+	SpiInst *configured;
+
+	/* Receive buffer of the DMA transfer in progress (to invalidate afterwards). */
+	void *rx;
+	uint32_t rx_size;
+
+	/* Source/destination for the side of a transfer that has no buffer. */
+	uint16_t dummy_tx;
+	uint16_t dummy_rx;
+} SpiBus;
+
+static SpiBus spi_buses[SPI_NUM_MODULES];
+
+/* The register map for each SPI module (in spi_buses order). */
+static SpiReg *const spi_regs[SPI_NUM_MODULES] = {
+	SPI1, SPI2, SPI3, SPI4, SPI5, SPI6
+};
+
+/**
+ * @return The bus state for the given SPI module.
+ */
+static SpiBus * _get_bus(SpiReg *spi)
+{
+	for(uint32_t i = 0; i < SPI_NUM_MODULES; ++i) {
+		if(spi_regs[i] == spi) {
+			return &spi_buses[i];
+		}
+	}
+
+	ABORT("Invalid SPI module passed to %s\n", __FUNCTION__);
+	return NULL;
+}
+
 /**
  * Initialize an SPI module.
  *
@@ -82,12 +171,12 @@ void spi_init(
 
 /**
  * Re-initialize the underlying SPI module with the same parameters used in
- * spi_init(). This is useful when two slaves are using the same SPI interface
- * but require different SPI configurations.
+ * spi_init(). Transactions call this automatically whenever the module was last
+ * configured for a different device, so it only needs to be called directly
+ * after changing the instance's parameters.
  *
- * @note Make sure to call this function before calling any other SPI functions
- *       after talking to a different device on the same SPI interface
- *       as this one.
+ * @note The module has to be idle (no transaction in progress, and the bus not
+ *       acquired by another device).
  *
  * @param inst The SPI instance to re-initialize.
  */
@@ -111,6 +200,8 @@ void spi_reinit(SpiInst *inst)
 	spi->CR2 = SET_SPI_CR2_FRXTH((inst->data_size > SPI_DS_8BIT) ? 0 : 1) |
 	           SET_SPI_CR2_SSOE(inst->use_software_ss ? 0 : 1) |
 	           SET_SPI_CR2_DS(inst->data_size);
+
+	_get_bus(spi)->configured = inst;
 }
 
 /**
@@ -278,3 +369,584 @@ uint16_t spi_send_receive(SpiInst *inst, uint16_t data)
 
 	return result;
 }
+
+/**
+ * Wait for every queued up frame to be sent and then throw away anything that
+ * was received (clearing the overrun flag if the RX FIFO overflowed).
+ */
+static void _finish_write(SpiReg *spi)
+{
+	while(GET_SPI_SR_FTLVL(spi->SR) != 0);
+	while(GET_SPI_SR_BSY(spi->SR) != 0);
+
+	while(GET_SPI_SR_FRLVL(spi->SR) != 0) {
+		(void)*(volatile uint8_t *)&spi->DR;
+	}
+
+	/* Reading DR and then SR clears the overrun flag. */
+	(void)spi->SR;
+}
+
+/**
+ * Send a buffer of data over SPI without reading the responses. The TX FIFO is
+ * kept full the whole time, so the frames go out back-to-back.
+ *
+ * @note When the data size is 8 bits or less, "data" is an array of bytes and
+ *       pairs of bytes get packed into single 16-bit writes. Otherwise "data" is
+ *       an array of uint16_t.
+ *
+ * @param inst Pointer to the SPI instance for the wanted SPI module.
+ * @param data The frames to send over the MOSI line.
+ * @param len The number of frames to send.
+ */
+void spi_write_buf(SpiInst *inst, const void *data, uint32_t len)
+{
+	ASSERT(inst != NULL);
+	ASSERT(inst->spi != NULL);
+	ASSERT((data != NULL) || (len == 0));
+	SpiReg * const spi = inst->spi;
+
+	if(GET_SPI_CR2_DS(spi->CR2) > SPI_DS_8BIT) {
+		const uint16_t *words = (const uint16_t *)data;
+
+		for(uint32_t i = 0; i < len; ++i) {
+			while(!GET_SPI_SR_TXE(spi->SR));
+			spi->DR = words[i];
+		}
+	} else {
+		const uint8_t *bytes = (const uint8_t *)data;
+
+		/* TXE means the TX FIFO is at most half full, so there's room for two bytes. */
+		for(; len >= 2; len -= 2, bytes += 2) {
+			while(!GET_SPI_SR_TXE(spi->SR));
+			*(volatile uint16_t *)&spi->DR = (uint16_t)(bytes[0] | (bytes[1] << 8));
+		}
+
+		if(len > 0) {
+			while(!GET_SPI_SR_TXE(spi->SR));
+			*(volatile uint8_t *)&spi->DR = *bytes;
+		}
+	}
+
+	_finish_write(spi);
+}
+
+/**
+ * Send and receive a buffer of 16-bit frames.
+ */
+static void _transfer16(SpiReg *spi, const uint16_t *tx, uint16_t *rx, uint32_t len)
+{
+	uint32_t tx_left = len;
+	uint32_t rx_left = len;
+
+	while(rx_left > 0) {
+		const uint32_t sr = spi->SR;
+
+		/* Don't send more than the RX FIFO can hold onto. */
+		if((tx_left > 0) && GET_SPI_SR_TXE(sr) && ((rx_left - tx_left) < (SPI_FIFO_SIZE / 2U))) {
+			spi->DR = (tx != NULL) ? tx[len - tx_left] : SPI_DUMMY_DATA;
+			tx_left--;
+		}
+
+		if(GET_SPI_SR_RXNE(sr)) {
+			const uint16_t data = (uint16_t)spi->DR;
+
+			if(rx != NULL) {
+				rx[len - rx_left] = data;
+			}
+
+			rx_left--;
+		}
+	}
+}
+
+/**
+ * Send and receive a buffer of 8-bit (or smaller) frames, moving two frames at
+ * a time through the data register wherever possible.
+ */
+static void _transfer8(SpiReg *spi, const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+	uint32_t tx_left = len;
+	uint32_t rx_left = len;
+
+	/* Only flag RXNE once two bytes can be read out at once. */
+	if(len >= 2) {
+		CLEAR_FIELD(spi->CR2, SPI_CR2_FRXTH());
+	}
+
+	while(rx_left > 0) {
+		const uint32_t sr = spi->SR;
+		const uint32_t in_flight = rx_left - tx_left;
+
+		/* Don't send more than the RX FIFO can hold onto. */
+		if((tx_left > 0) && GET_SPI_SR_TXE(sr)) {
+			const uint32_t pos = len - tx_left;
+
+			if((tx_left >= 2) && ((in_flight + 2U) <= SPI_FIFO_SIZE)) {
+				*(volatile uint16_t *)&spi->DR = (tx != NULL) ?
+					(uint16_t)(tx[pos] | (tx[pos + 1U] << 8)) : SPI_DUMMY_DATA;
+				tx_left -= 2;
+			} else if(in_flight < SPI_FIFO_SIZE) {
+				*(volatile uint8_t *)&spi->DR = (tx != NULL) ? tx[pos] : (uint8_t)SPI_DUMMY_DATA;
+				tx_left--;
+			}
+		}
+
+		if(GET_SPI_SR_RXNE(sr)) {
+			const uint32_t pos = len - rx_left;
+
+			if(rx_left >= 2) {
+				const uint16_t data = *(volatile uint16_t *)&spi->DR;
+
+				if(rx != NULL) {
+					rx[pos] = (uint8_t)data;
+					rx[pos + 1U] = (uint8_t)(data >> 8);
+				}
+
+				rx_left -= 2;
+
+				/* The last odd byte has to be flagged on its own. */
+				if(rx_left == 1) {
+					SET_FIELD(spi->CR2, SPI_CR2_FRXTH());
+				}
+			} else {
+				const uint8_t data = *(volatile uint8_t *)&spi->DR;
+
+				if(rx != NULL) {
+					rx[pos] = data;
+				}
+
+				rx_left--;
+			}
+		}
+	}
+
+	SET_FIELD(spi->CR2, SPI_CR2_FRXTH());
+}
+
+/**
+ * Send a buffer of data over SPI while reading the responses into another. The
+ * TX FIFO is kept as full as possible (without letting the RX FIFO overflow) so
+ * the frames go out back-to-back.
+ *
+ * @note When the data size is 8 bits or less, "tx" and "rx" are arrays of bytes
+ *       and pairs of bytes get moved with single 16-bit accesses. Otherwise
+ *       they're arrays of uint16_t.
+ *
+ * @param inst Pointer to the SPI instance for the wanted SPI module.
+ * @param tx The frames to send over the MOSI line (NULL to send zeroes).
+ * @param rx Where to store the frames received on the MISO line (NULL to throw
+ *           them away). Can be the same buffer as "tx".
+ * @param len The number of frames to transfer.
+ */
+void spi_transfer(SpiInst *inst, const void *tx, void *rx, uint32_t len)
+{
+	ASSERT(inst != NULL);
+	ASSERT(inst->spi != NULL);
+	SpiReg * const spi = inst->spi;
+
+	if(GET_SPI_CR2_DS(spi->CR2) > SPI_DS_8BIT) {
+		_transfer16(spi, (const uint16_t *)tx, (uint16_t *)rx, len);
+	} else {
+		_transfer8(spi, (const uint8_t *)tx, (uint8_t *)rx, len);
+	}
+}
+
+
+/**
+ * Remove the finished transaction from the head of the bus's queue and call its
+ * callback. The bus stays busy, so the caller has to keep running the queue.
+ */
+static void _bus_complete(SpiBus *bus)
+{
+	SpiTransaction *const txn = bus->head;
+	SpiInst *const inst = txn->inst;
+	const SpiCallback callback = txn->callback;
+	void *const arg = txn->arg;
+
+	const uint32_t primask = intr_enter_critical();
+
+	bus->head = txn->next;
+	if(bus->head == NULL) {
+		bus->tail = NULL;
+	}
+
+	intr_exit_critical(primask);
+
+	/* The transaction can get reused (or go out of scope) from here on. */
+	if(callback != NULL) {
+		callback(inst, arg);
+	}
+}
+
+/**
+ * Start a transaction's transfer on the DMA streams. It gets finished off in
+ * _dma_rx_callback().
+ */
+static void _bus_start_dma(SpiBus *bus, SpiTransaction *txn)
+{
+	SpiInst *const inst = txn->inst;
+	SpiReg *const spi = inst->spi;
+
+	const bool wide = (inst->data_size > SPI_DS_8BIT);
+	const uint32_t frame_size = wide ? sizeof(uint16_t) : sizeof(uint8_t);
+	const uint32_t size = wide ? DMA_SIZE_16BIT : DMA_SIZE_8BIT;
+	const uint32_t config = SET_DMA_SxCR_PSIZE(size) | SET_DMA_SxCR_MSIZE(size);
+
+	bus->rx = txn->rx;
+	bus->rx_size = txn->len * frame_size;
+	bus->dummy_tx = SPI_DUMMY_DATA;
+
+	/**
+	 * Write back the transmit data, and any dirty lines over the receive buffer
+	 * so they can't get evicted on top of what the DMA writes.
+	 */
+	if(txn->tx != NULL) {
+		dcache_clean(txn->tx, txn->len * frame_size);
+	}
+
+	if(txn->rx != NULL) {
+		dcache_clean(txn->rx, txn->len * frame_size);
+	}
+
+	/* The dummy frame gets read by the DMA too. */
+	if(txn->tx == NULL) {
+		dcache_clean(&bus->dummy_tx, sizeof(bus->dummy_tx));
+	}
+
+	/* Frames are moved one at a time (no packing), so FRXTH is left set. */
+	SET_FIELD(spi->CR2, SPI_CR2_RXDMAEN());
+
+	/* The side without a buffer uses a single dummy frame over and over. */
+	dma_start(bus->rx_dma,
+	          bus->rx_stream,
+	          config |
+	          SET_DMA_SxCR_DIR(DMA_PERIPH_TO_MEM) |
+	          SET_DMA_SxCR_MINC((txn->rx != NULL) ? 1 : 0) |
+	          DMA_SxCR_TCIE() |
+	          DMA_SxCR_TEIE(),
+	          &spi->DR,
+	          (txn->rx != NULL) ? txn->rx : (void*)&bus->dummy_rx,
+	          (uint16_t)txn->len);
+
+	dma_start(bus->tx_dma,
+	          bus->tx_stream,
+	          config |
+	          SET_DMA_SxCR_DIR(DMA_MEM_TO_PERIPH) |
+	          SET_DMA_SxCR_MINC((txn->tx != NULL) ? 1 : 0),
+	          &spi->DR,
+	          (txn->tx != NULL) ? txn->tx : (const void*)&bus->dummy_tx,
+	          (uint16_t)txn->len);
+
+	/* The reference manual requires the TX requests to be enabled after the streams. */
+	SET_FIELD(spi->CR2, SPI_CR2_TXDMAEN());
+	spi_enable(inst);
+}
+
+/**
+ * Run the transactions queued up on a bus until either the queue is empty (and
+ * the bus goes idle), a DMA transfer has been started, or an instance has been
+ * given the bus with spi_bus_acquire().
+ *
+ * @note Only whoever marked the bus as busy gets to call this.
+ */
+static void _bus_run(SpiBus *bus)
+{
+	while(true) {
+		const uint32_t primask = intr_enter_critical();
+		SpiTransaction *const txn = bus->head;
+
+		if(txn == NULL) {
+			bus->busy = false;
+		}
+
+		intr_exit_critical(primask);
+
+		if(txn == NULL) {
+			return;
+		}
+
+		SpiInst *const inst = txn->inst;
+
+		/* The module only needs reconfiguring when switching between devices. */
+		if(bus->configured != inst) {
+			spi_reinit(inst);
+		}
+
+		if(txn->hold) {
+			/* The bus stays busy until spi_bus_release() gets called. */
+			spi_enable(inst);
+			bus->owner = inst;
+			_bus_complete(bus);
+			return;
+		}
+
+		if((bus->tx_dma != NULL) && (txn->len >= SPI_DMA_MIN_LEN)) {
+			_bus_start_dma(bus, txn);
+			return;
+		}
+
+		spi_enable(inst);
+		spi_transfer(inst, txn->tx, txn->rx, txn->len);
+		spi_disable(inst);
+
+		_bus_complete(bus);
+	}
+}
+
+/**
+ * Called from the RX stream's interrupt. The RX stream finishes last (once the
+ * final frame has been shifted in), so this is the end of the transaction.
+ */
+static void _dma_rx_callback(void *arg, uint32_t flags)
+{
+	SpiBus *const bus = (SpiBus*)arg;
+
+	if(flags & DMA_ISR_TEIF()) {
+		ABORT("SPI DMA transfer error");
+	}
+
+	if(!(flags & DMA_ISR_TCIF()) || (bus->head == NULL)) {
+		return;
+	}
+
+	SpiInst *const inst = bus->head->inst;
+
+	/* The DMA wrote the receive buffer behind the data cache's back. */
+	if(bus->rx != NULL) {
+		dcache_invalidate(bus->rx, bus->rx_size);
+	}
+
+	/* Releases the slave select line. */
+	spi_disable(inst);
+	CLEAR_FIELD(inst->spi->CR2, SPI_CR2_TXDMAEN() | SPI_CR2_RXDMAEN());
+
+	_bus_complete(bus);
+	_bus_run(bus);
+}
+
+/**
+ * Give an SPI module a pair of DMA streams to run its transactions with (see
+ * spi_transaction()). Every SpiInst that uses this module shares the streams.
+ *
+ * @note The DMA arguments are normally given with the DMA_SPIx_TX/RX macros
+ *       from dma.h, e.g., spi_enable_dma(SPI2, DMA_SPI2_TX, DMA_SPI2_RX).
+ *
+ * @param spi Pointer to the SPI register map for the wanted SPI module.
+ * @param tx_dma The DMA controller used to feed the TX FIFO.
+ * @param tx_stream The DMA stream used to feed the TX FIFO.
+ * @param tx_channel The TX stream's request channel for this SPI module.
+ * @param rx_dma The DMA controller used to drain the RX FIFO.
+ * @param rx_stream The DMA stream used to drain the RX FIFO.
+ * @param rx_channel The RX stream's request channel for this SPI module.
+ */
+void spi_enable_dma(
+	SpiReg *spi,
+	DmaReg *tx_dma,
+	uint8_t tx_stream,
+	uint8_t tx_channel,
+	DmaReg *rx_dma,
+	uint8_t rx_stream,
+	uint8_t rx_channel)
+{
+	SpiBus *const bus = _get_bus(spi);
+
+	ASSERT(bus->tx_dma == NULL);
+	ASSERT(!bus->busy);
+
+	dma_init_stream(tx_dma, tx_stream, tx_channel, NULL, NULL);
+	dma_init_stream(rx_dma, rx_stream, rx_channel, _dma_rx_callback, bus);
+
+	bus->tx_dma = tx_dma;
+	bus->tx_stream = tx_stream;
+	bus->rx_dma = rx_dma;
+	bus->rx_stream = rx_stream;
+}
+
+/**
+ * Add a transaction to the end of its bus's queue, and start running the queue
+ * if the bus was idle.
+ */
+static void _bus_submit(SpiTransaction *txn)
+{
+	ASSERT(txn->inst != NULL);
+	ASSERT(txn->inst->spi != NULL);
+	ASSERT(txn->len <= UINT16_MAX);
+
+	SpiBus *const bus = _get_bus(txn->inst->spi);
+	txn->next = NULL;
+
+	const uint32_t primask = intr_enter_critical();
+
+	if(bus->tail != NULL) {
+		bus->tail->next = txn;
+	} else {
+		bus->head = txn;
+	}
+
+	bus->tail = txn;
+
+	/* Whoever finds the bus idle is the one who has to get it going. */
+	const bool start = !bus->busy;
+	bus->busy = true;
+
+	intr_exit_critical(primask);
+
+	if(start) {
+		_bus_run(bus);
+	}
+}
+
+/**
+ * Queue up a transaction on its instance's SPI module. Once every transaction
+ * queued before it has finished, the module gets reconfigured for the
+ * transaction's instance (only if the last transaction was for a different
+ * device), the slave select line is asserted, the frames are transferred, the
+ * slave select line is released, and then the callback gets called.
+ *
+ * If the bus is idle, the transaction starts right away. Short transactions
+ * (and every transaction on a module without DMA) are run by the CPU, either
+ * before this returns or from wherever the transaction ahead of it finished.
+ * With DMA enabled (see spi_enable_dma()), longer transactions are moved by the
+ * DMA controller and their callbacks get called from the DMA's interrupt.
+ *
+ * @note The transaction and its buffers must stay valid until the callback has
+ *       been called. The DMA bypasses the data cache, so a receive buffer
+ *       should be aligned to (and a multiple of) DCACHE_LINE_SIZE; anything else
+ *       sharing its cache lines shouldn't be written while the transfer is in
+ *       progress.
+ *
+ * @note Safe to call from ISRs and transaction callbacks.
+ *
+ * @param txn The transaction to run. Everything but the "next" and "hold"
+ *            fields has to be filled in.
+ */
+void spi_transaction_async(SpiTransaction *txn)
+{
+	ASSERT(txn != NULL);
+
+	txn->hold = false;
+	_bus_submit(txn);
+}
+
+/* Context shared between a blocking bus call and its completion callback. */
+typedef struct {
+	task_t *volatile waiter;
+	volatile bool done;
+} SpiWaitContext;
+
+static void _transaction_done(__unused SpiInst *inst, void *arg)
+{
+	SpiWaitContext *const context = (SpiWaitContext*)arg;
+
+	context->done = true;
+
+	if(context->waiter != NULL) {
+		sched_wake(context->waiter);
+	}
+}
+
+/**
+ * Queue up a transaction and wait for its callback, sleeping while it's
+ * waiting on the bus or being moved by the DMA controller.
+ */
+static void _bus_submit_wait(SpiTransaction *txn)
+{
+	SpiWaitContext context = {
+		.waiter = NULL,
+		.done = false
+	};
+
+	txn->callback = _transaction_done;
+	txn->arg = &context;
+	_bus_submit(txn);
+
+	/**
+	 * Transactions run by the CPU are already done by now. Only ask to be woken
+	 * up otherwise, so a finished transaction doesn't leave a stale wakeup
+	 * behind (that would cut the task's next sched_block() short).
+	 */
+	if(context.done) {
+		return;
+	}
+
+	if(task_can_block()) {
+		context.waiter = get_current_task();
+	}
+
+	while(!context.done) {
+		if(context.waiter != NULL) {
+			sched_block();
+		}
+	}
+}
+
+/**
+ * Run a transaction (see spi_transaction_async()) and wait for it to finish.
+ *
+ * @param inst Pointer to the SPI instance for the wanted device.
+ * @param tx The frames to send (NULL to send zeroes). See spi_transfer() for
+ *           the layout of the buffers.
+ * @param rx Where to store the received frames (NULL to throw them away).
+ * @param len The number of frames to transfer.
+ */
+void spi_transaction(SpiInst *inst, const void *tx, void *rx, uint32_t len)
+{
+	SpiTransaction txn = {
+		.inst = inst,
+		.tx = tx,
+		.rx = rx,
+		.len = len,
+		.hold = false
+	};
+
+	_bus_submit_wait(&txn);
+}
+
+/**
+ * Wait for exclusive use of a device's SPI module, for devices that need more
+ * than a single transfer with the slave select line asserted (e.g., delays
+ * between frames). Once this returns, the module has been configured for this
+ * instance, the slave select line is asserted, and the polled functions
+ * (spi_send_receive(), spi_transfer(), etc.) can be used until
+ * spi_bus_release() is called. Transactions from other devices queue up in the
+ * meantime.
+ *
+ * @note Can only be called from a task (or before the scheduler has started).
+ *
+ * @param inst Pointer to the SPI instance for the wanted device.
+ */
+void spi_bus_acquire(SpiInst *inst)
+{
+	SpiTransaction txn = {
+		.inst = inst,
+		.tx = NULL,
+		.rx = NULL,
+		.len = 0,
+		.hold = true
+	};
+
+	_bus_submit_wait(&txn);
+}
+
+/**
+ * Release the slave select line and give up the bus claimed by
+ * spi_bus_acquire(). Any transactions that queued up in the meantime get
+ * started.
+ *
+ * @param inst Pointer to the SPI instance that acquired the bus.
+ */
+void spi_bus_release(SpiInst *inst)
+{
+	ASSERT(inst != NULL);
+	ASSERT(inst->spi != NULL);
+
+	SpiBus *const bus = _get_bus(inst->spi);
+
+	ASSERT(bus->busy && (bus->owner == inst));
+
+	spi_disable(inst);
+	bus->owner = NULL;
+
+	_bus_run(bus);
+}
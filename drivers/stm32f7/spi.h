@@ -9,6 +9,7 @@
 
 #include "gpio.h"
 
+#include "registers/dma_reg.h"
 #include "registers/spi_reg.h"
 
 #include <stdbool.h>
@@ -17,8 +18,9 @@
 /**
  * Structure used to represent a single configuration for a SPI module. Multiple
  * configurations can exist that use a single SPI module (e.g., multiple devices
- * are connected to the same SPI module), the user just has to make sure to call
- * the spi_reinit() function before talking to each individual device.
+ * are connected to the same SPI module). Transactions (and spi_bus_acquire())
+ * reconfigure the module for each device as needed, but anything using the
+ * polled functions on their own has to call spi_reinit() first.
  */
 typedef struct {
 	/* SPI module this instance uses. */
@@ -47,6 +49,32 @@ typedef struct {
 	GpioPin ss_pin;
 } SpiInst;
 
+/* Called once an asynchronous transaction has finished (from an ISR with DMA). */
+typedef void (*SpiCallback)(SpiInst *inst, void *arg);
+
+/* A transaction queued up on an SPI module (see spi_transaction_async()). */
+typedef struct SpiTransaction {
+	/* Next transaction in the module's queue (filled in when queued). */
+	struct SpiTransaction *next;
+
+	/* The device to talk to. */
+	SpiInst *inst;
+
+	/* Frames to send (NULL to send zeroes) and where to store received frames (or NULL). */
+	const void *tx;
+	void *rx;
+
+	/* The number of frames to transfer. */
+	uint32_t len;
+
+	/* Called once the transaction is over (can be NULL). */
+	SpiCallback callback;
+	void *arg;
+
+	/* True if the bus stays claimed after the callback (see spi_bus_acquire()). */
+	bool hold;
+} SpiTransaction;
+
 void spi_init(
 	SpiInst *inst,
 	SpiReg *spi,
@@ -63,3 +91,21 @@ uint32_t spi_get_periph_clock(SpiReg *spi);
 
 void spi_write(SpiInst *inst, uint16_t data);
 uint16_t spi_send_receive(SpiInst *inst, uint16_t data);
+
+void spi_write_buf(SpiInst *inst, const void *data, uint32_t len);
+void spi_transfer(SpiInst *inst, const void *tx, void *rx, uint32_t len);
+
+void spi_enable_dma(
+	SpiReg *spi,
+	DmaReg *tx_dma,
+	uint8_t tx_stream,
+	uint8_t tx_channel,
+	DmaReg *rx_dma,
+	uint8_t rx_stream,
+	uint8_t rx_channel);
+
+void spi_transaction(SpiInst *inst, const void *tx, void *rx, uint32_t len);
+void spi_transaction_async(SpiTransaction *txn);
+
+void spi_bus_acquire(SpiInst *inst);
+void spi_bus_release(SpiInst *inst);
@@ -3,15 +3,120 @@
  * @created 12/27/2018
  *
  * Definitions and functions used to manipulate the USART.
+ *
+ * By default every function polls the USART's status flags. Calling
+ * usart_enable_buffering() switches a USART over to being interrupt-driven: an
+ * ISR moves bytes between the data registers and a pair of ring buffers, so
+ * sending only has to copy bytes into the TX ring (usart_write()) and received
+ * bytes are buffered until they're read out (usart_read()). The blocking
+ * functions (usart_send(), usart_receive(), etc.) keep working in that mode
+ * but wait by blocking the calling task instead of spinning. Each USART only
+ * keeps track of one waiting task per direction, so only one task at a time
+ * may block sending on a buffered USART (and one task receiving).
+ *
+ * On top of that, a buffered USART can hand its rings over to the DMA
+ * controller:
+ *
+ * - usart_enable_dma_tx(): Whenever the TX ring has data, a DMA transfer sends
+ *   the longest contiguous run of it, so a bulk send costs one interrupt per
+ *   transfer instead of one per byte.
+ * - usart_enable_dma_rx(): The RX ring becomes the target of a circular DMA
+ *   transfer. The ring's head is only updated when the line goes idle (and at
+ *   the half/full points of the ring), so a variable-length frame arrives with a
+ *   single interrupt. usart_rx_peek()/usart_rx_consume() let the frame be
+ *   processed in place without copying it out of the ring.
  */
+#include "config.h"
 #include "debug.h"
+#include "dma.h"
+#include "interrupt.h"
+#include "os/task.h"
 #include "usart.h"
 #include "system.h"
 
 #include "registers/rcc_reg.h"
 #include "registers/usart_reg.h"
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+/* Number of USART modules. */
+#define USART_NUM_MODULES 8U
+
+/* A ring buffer of bytes. The indices are free-running (masked on access). */
+typedef struct {
+	uint8_t *buf;
+	uint32_t mask;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+} UsartRing;
+
+/* Driver state for a single USART module. */
+typedef struct {
+	/* True once usart_enable_buffering() has been called. */
+	bool buffered;
+
+	UsartRing tx;
+	UsartRing rx;
+
+	/* Tasks blocked waiting for room in the TX ring or data in the RX ring. */
+	task_t *volatile tx_waiter;
+	task_t *volatile rx_waiter;
+
+	/* DMA streams feeding the TX ring and filling the RX ring (NULL if unused). */
+	DmaReg *tx_dma;
+	uint8_t tx_stream;
+	DmaReg *rx_dma;
+	uint8_t rx_stream;
+
+	/* Number of bytes the current TX DMA transfer is sending (zero if idle). */
+	uint32_t tx_dma_len;
+
+	/* Size of the TX ring space held by usart_tx_reserve() (zero if none). */
+	uint32_t tx_reserved;
+
+	UsartStats stats;
+} UsartState;
+
+static UsartState usart_states[USART_NUM_MODULES];
+
+/* Receive errors that get counted (and cleared). */
+#define USART_ERROR_FLAGS (USART_ISR_PE() | USART_ISR_FE() | USART_ISR_NF() | USART_ISR_ORE())
+
+/* The register map and interrupt for each USART module (in usart_states order). */
+static UsartReg *const usart_regs[USART_NUM_MODULES] = {
+	USART1, USART2, USART3, UART4, UART5, USART6, UART7, UART8
+};
+
+static const irq_num_t usart_irqs[USART_NUM_MODULES] = {
+	USART1_IRQn, USART2_IRQn, USART3_IRQn, UART4_IRQn,
+	UART5_IRQn, USART6_IRQn, UART7_IRQn, UART8_IRQn
+};
+
+/**
+ * @return The driver state for the given USART module.
+ */
+static UsartState *_get_state(UsartReg *usart)
+{
+	for(uint32_t i = 0; i < USART_NUM_MODULES; ++i) {
+		if(usart_regs[i] == usart) {
+			return &usart_states[i];
+		}
+	}
+
+	ABORT("Invalid USART module passed to %s\n", __FUNCTION__);
+	return NULL;
+}
+
+/**
+ * @return The register map for the USART module that owns the given state.
+ */
+static UsartReg *_get_reg(UsartState *state)
+{
+	return usart_regs[state - usart_states];
+}
 
 /**
  * Initialize a USART module with some basic settings.
@@ -61,12 +166,17 @@ void usart_init(
 		ABORT("Invalid USART module passed to %s\n", __FUNCTION__);
 	}
 
+	memset(&usart_states[usart_num], 0, sizeof(usart_states[usart_num]));
+
 	/* The USART clock selection fields are contiguous in RCC->DCKCFGR2[15:0]. */
 	RCC->DCKCFGR2 |= (RCC_USARTSEL_SYSCLK) << (usart_num * 2);
 	DSB();
 
+	/**
+	 * Overrun detection is left enabled (OVRDIS = 0) so that lost bytes get
+	 * counted in the USART's statistics instead of silently disappearing.
+	 */
 	SET_FIELD(usart->BRR, SET_USART_BRR_BRR(CPU_HZ / baud));
-	SET_FIELD(usart->CR3, SET_USART_CR3_OVRDIS(1));
 	SET_FIELD(usart->CR2, SET_USART_CR2_STOP(stop_bits));
 	SET_FIELD(usart->CR1, SET_USART_CR1_M0(data_bits & 1) |
 	                      SET_USART_CR1_M1((data_bits >> 1) & 1) |
@@ -97,45 +207,754 @@ void usart_enable_rx(UsartReg *usart, bool enable)
 	SET_FIELD(usart->CR1, SET_USART_CR1_RE((enable) ? 1 : 0));
 }
 
+/**
+ * Count (and clear) any receive errors that are flagged in an ISR value.
+ */
+static void _handle_errors(UsartReg *usart, UsartState *state, uint32_t isr)
+{
+	if(isr & USART_ERROR_FLAGS) {
+		if(GET_USART_ISR_ORE(isr)) { state->stats.overrun_errors++; }
+		if(GET_USART_ISR_FE(isr))  { state->stats.framing_errors++; }
+		if(GET_USART_ISR_NF(isr))  { state->stats.noise_errors++; }
+		if(GET_USART_ISR_PE(isr))  { state->stats.parity_errors++; }
+
+		usart->ICR = USART_ICR_ORECF() | USART_ICR_FECF() | USART_ICR_NCF() | USART_ICR_PECF();
+	}
+}
+
+/**
+ * Start sending the next contiguous run of bytes in the TX ring over DMA, if
+ * the ring has data and no transfer is already in progress.
+ *
+ * @note Must be called with interrupts disabled (or from the DMA's ISR).
+ */
+static void _tx_dma_kick(UsartState *state)
+{
+	UsartRing *const tx = &state->tx;
+	const uint32_t used = tx->head - tx->tail;
+
+	if((state->tx_dma_len != 0) || (used == 0)) {
+		return;
+	}
+
+	/* Stop at the end of the ring, the rest gets sent by the next transfer. */
+	const uint32_t start = tx->tail & tx->mask;
+	uint32_t len = (tx->mask + 1U) - start;
+	len = (used < len) ? used : len;
+	len = (len < UINT16_MAX) ? len : UINT16_MAX;
+
+	dcache_clean(&tx->buf[start], len);
+
+	state->tx_dma_len = len;
+	dma_start(state->tx_dma,
+	          state->tx_stream,
+	          SET_DMA_SxCR_DIR(DMA_MEM_TO_PERIPH) |
+	          SET_DMA_SxCR_PSIZE(DMA_SIZE_8BIT) |
+	          SET_DMA_SxCR_MSIZE(DMA_SIZE_8BIT) |
+	          DMA_SxCR_MINC() |
+	          DMA_SxCR_TCIE() |
+	          DMA_SxCR_TEIE(),
+	          &_get_reg(state)->TDR,
+	          &tx->buf[start],
+	          (uint16_t)len);
+}
+
+/**
+ * Called when a TX DMA transfer finishes. Frees up the bytes it sent and starts
+ * on whatever got queued up in the meantime.
+ */
+static void _tx_dma_callback(void *arg, uint32_t flags)
+{
+	UsartState *const state = (UsartState*)arg;
+
+	if(!(flags & (DMA_ISR_TCIF() | DMA_ISR_TEIF()))) {
+		return;
+	}
+
+	/**
+	 * A transfer error stops the stream. The bytes are thrown away (instead of
+	 * retried) so that writers waiting on the ring don't get stuck.
+	 */
+	if(flags & DMA_ISR_TEIF()) {
+		state->stats.dma_errors++;
+	} else {
+		state->stats.tx_bytes += state->tx_dma_len;
+	}
+
+	state->tx.tail += state->tx_dma_len;
+	state->tx_dma_len = 0;
+
+	_tx_dma_kick(state);
+
+	if(state->tx_waiter != NULL) {
+		sched_wake(state->tx_waiter);
+	}
+}
+
+/**
+ * Move the RX ring's head up to wherever the circular DMA transfer has gotten
+ * to and wake up any task waiting on received data.
+ *
+ * @note Called from the USART's ISR (line idle) and the DMA's ISR (half and
+ *       full points of the ring), which run at the same priority.
+ */
+static void _rx_dma_update(UsartState *state)
+{
+	if(state->rx_dma == NULL) {
+		return;
+	}
+
+	UsartRing *const rx = &state->rx;
+	const uint32_t size = rx->mask + 1U;
+
+	/* NDTR counts down from the ring size and reloads once it hits zero. */
+	const uint32_t pos = (size - dma_get_remaining(state->rx_dma, state->rx_stream)) & rx->mask;
+	const uint32_t received = (pos - rx->head) & rx->mask;
+
+	if(received == 0) {
+		return;
+	}
+
+	rx->head += received;
+	state->stats.rx_bytes += received;
+
+	/**
+	 * The DMA doesn't care whether the oldest bytes have been read yet. If it
+	 * lapped the reader, those bytes are gone, so skip the tail past them.
+	 */
+	const uint32_t used = rx->head - rx->tail;
+
+	if(used > size) {
+		state->stats.rx_dropped += used - size;
+		rx->tail = rx->head - size;
+	}
+
+	if(state->rx_waiter != NULL) {
+		sched_wake(state->rx_waiter);
+	}
+}
+
+/**
+ * Called at the half and full points of the RX ring's circular DMA transfer.
+ */
+static void _rx_dma_callback(void *arg, uint32_t flags)
+{
+	UsartState *const state = (UsartState*)arg;
+
+	/* A transfer error stops the stream, and with it any further reception. */
+	if(flags & DMA_ISR_TEIF()) {
+		state->stats.dma_errors++;
+	}
+
+	_rx_dma_update(state);
+}
+
+/**
+ * Interrupt handler shared by every buffered USART. Counts receive errors,
+ * moves received bytes into the RX ring, and feeds the transmitter from the TX
+ * ring (disabling the TXE interrupt once the ring runs dry). With DMA reception,
+ * the line going idle is what tells the driver a frame has arrived.
+ */
+static void _usart_isr(UsartState *state)
+{
+	UsartReg *const usart = _get_reg(state);
+	const uint32_t isr = usart->ISR;
+
+	_handle_errors(usart, state, isr);
+
+	/* With DMA reception, the DMA controller is the one emptying RDR. */
+	if(GET_USART_CR1_RXNEIE(usart->CR1) && GET_USART_ISR_RXNE(isr)) {
+		const uint8_t data = (uint8_t)usart->RDR;
+		UsartRing *const rx = &state->rx;
+
+		if((rx->head - rx->tail) > rx->mask) {
+			state->stats.rx_dropped++;
+		} else {
+			rx->buf[rx->head & rx->mask] = data;
+			rx->head++;
+			state->stats.rx_bytes++;
+		}
+
+		if(state->rx_waiter != NULL) {
+			sched_wake(state->rx_waiter);
+		}
+	}
+
+	if(GET_USART_CR1_TXEIE(usart->CR1) && GET_USART_ISR_TXE(isr)) {
+		UsartRing *const tx = &state->tx;
+
+		if(tx->head == tx->tail) {
+			CLEAR_FIELD(usart->CR1, USART_CR1_TXEIE());
+		} else {
+			usart->TDR = tx->buf[tx->tail & tx->mask];
+			tx->tail++;
+			state->stats.tx_bytes++;
+
+			if(state->tx_waiter != NULL) {
+				sched_wake(state->tx_waiter);
+			}
+		}
+	}
+
+	if(GET_USART_CR1_IDLEIE(usart->CR1) && GET_USART_ISR_IDLE(isr)) {
+		usart->ICR = USART_ICR_IDLECF();
+		_rx_dma_update(state);
+	}
+}
+
+/* Generate an interrupt handler for each USART module. */
+#define USART_ISR(index) static void _usart##index##_isr(void) { _usart_isr(&usart_states[index]); }
+USART_ISR(0)
+USART_ISR(1)
+USART_ISR(2)
+USART_ISR(3)
+USART_ISR(4)
+USART_ISR(5)
+USART_ISR(6)
+USART_ISR(7)
+
+static const isr_func_t usart_isrs[USART_NUM_MODULES] = {
+	_usart0_isr, _usart1_isr, _usart2_isr, _usart3_isr,
+	_usart4_isr, _usart5_isr, _usart6_isr, _usart7_isr
+};
+
+/**
+ * Make a USART interrupt-driven. Bytes get sent from (and received into) the
+ * given ring buffers by an ISR, and the non-blocking usart_write()/usart_read()
+ * functions become available.
+ *
+ * @note Call this after usart_init(). The buffers must stay valid for as long
+ *       as the USART is in use.
+ *
+ * @note Only one task may block sending on the USART at a time, and only one
+ *       task may block receiving (a second one would overwrite the first's
+ *       wakeup). Tasks sharing a direction need to serialize their accesses.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param tx_buf Buffer used to hold bytes waiting to be sent.
+ * @param tx_size Size of the TX buffer (must be a power of two).
+ * @param rx_buf Buffer used to hold received bytes until they're read.
+ * @param rx_size Size of the RX buffer (must be a power of two).
+ */
+void usart_enable_buffering(
+	UsartReg *usart,
+	uint8_t *tx_buf,
+	uint32_t tx_size,
+	uint8_t *rx_buf,
+	uint32_t rx_size)
+{
+	ASSERT((tx_buf != NULL) && (rx_buf != NULL));
+	ASSERT((tx_size != 0) && ((tx_size & (tx_size - 1U)) == 0));
+	ASSERT((rx_size != 0) && ((rx_size & (rx_size - 1U)) == 0));
+
+	UsartState *const state = _get_state(usart);
+	const uint32_t index = (uint32_t)(state - usart_states);
+
+	ASSERT(!state->buffered);
+
+	state->tx.buf = tx_buf;
+	state->tx.mask = tx_size - 1U;
+	state->rx.buf = rx_buf;
+	state->rx.mask = rx_size - 1U;
+	state->buffered = true;
+
+	/* Throw away any stale data or errors from before the ISR took over. */
+	usart->ICR = USART_ICR_ORECF() | USART_ICR_FECF() | USART_ICR_NCF() | USART_ICR_PECF();
+
+	intr_register(usart_irqs[index], usart_isrs[index], LOWEST_INTR_PRIORITY);
+
+	SET_FIELD(usart->CR3, USART_CR3_EIE());
+	SET_FIELD(usart->CR1, USART_CR1_RXNEIE() | USART_CR1_PEIE());
+}
+
+/**
+ * Send the contents of a buffered USART's TX ring using DMA instead of the TXE
+ * interrupt.
+ *
+ * @note Call this after usart_enable_buffering(). The DMA arguments are
+ *       normally given with one of the DMA_*_TX macros from dma.h.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param dma The DMA controller to use.
+ * @param stream The DMA stream to use.
+ * @param channel The stream's request channel for this USART's TX requests.
+ */
+void usart_enable_dma_tx(UsartReg *usart, DmaReg *dma, uint8_t stream, uint8_t channel)
+{
+	UsartState *const state = _get_state(usart);
+
+	ASSERT(state->buffered && (state->tx_dma == NULL));
+
+	dma_init_stream(dma, stream, channel, _tx_dma_callback, state);
+
+	/* Let anything queued up so far drain through the ISR first. */
+	usart_flush(usart);
+
+	const uint32_t primask = intr_enter_critical();
+
+	state->tx_dma = dma;
+	state->tx_stream = stream;
+	state->tx_dma_len = 0;
+	SET_FIELD(usart->CR3, USART_CR3_DMAT());
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Receive into a buffered USART's RX ring using a circular DMA transfer. The
+ * ring gets updated each time the line goes idle instead of on every byte.
+ *
+ * @note Call this after usart_enable_buffering(). The DMA arguments are
+ *       normally given with one of the DMA_*_RX macros from dma.h.
+ *
+ * @note The DMA writes the RX ring behind the data cache's back, so the ring
+ *       must be aligned to (and a multiple of) DCACHE_LINE_SIZE. Any bytes
+ *       still sitting in the ring are thrown away.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param dma The DMA controller to use.
+ * @param stream The DMA stream to use.
+ * @param channel The stream's request channel for this USART's RX requests.
+ */
+void usart_enable_dma_rx(UsartReg *usart, DmaReg *dma, uint8_t stream, uint8_t channel)
+{
+	UsartState *const state = _get_state(usart);
+	UsartRing *const rx = &state->rx;
+
+	ASSERT(state->buffered && (state->rx_dma == NULL));
+	ASSERT(((uintptr_t)rx->buf & (DCACHE_LINE_SIZE - 1U)) == 0);
+	ASSERT(((rx->mask + 1U) % DCACHE_LINE_SIZE) == 0);
+	ASSERT(rx->mask < UINT16_MAX);
+
+	dma_init_stream(dma, stream, channel, _rx_dma_callback, state);
+
+	const uint32_t primask = intr_enter_critical();
+
+	/* The DMA always starts at the beginning of the ring. */
+	CLEAR_FIELD(usart->CR1, USART_CR1_RXNEIE());
+	rx->head = 0;
+	rx->tail = 0;
+
+	/* Anything cached from the ring is about to be stale. */
+	dcache_invalidate(rx->buf, rx->mask + 1U);
+
+	state->rx_dma = dma;
+	state->rx_stream = stream;
+
+	dma_start(dma,
+	          stream,
+	          SET_DMA_SxCR_DIR(DMA_PERIPH_TO_MEM) |
+	          SET_DMA_SxCR_PSIZE(DMA_SIZE_8BIT) |
+	          SET_DMA_SxCR_MSIZE(DMA_SIZE_8BIT) |
+	          DMA_SxCR_MINC() |
+	          DMA_SxCR_CIRC() |
+	          DMA_SxCR_HTIE() |
+	          DMA_SxCR_TCIE() |
+	          DMA_SxCR_TEIE(),
+	          &usart->RDR,
+	          rx->buf,
+	          (uint16_t)(rx->mask + 1U));
+
+	usart->ICR = USART_ICR_IDLECF();
+	SET_FIELD(usart->CR3, USART_CR3_DMAR());
+	SET_FIELD(usart->CR1, USART_CR1_IDLEIE());
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Get the transmitter going after bytes were added to the TX ring.
+ *
+ * @note Must be called with interrupts disabled.
+ */
+static void _tx_start(UsartState *state, uint32_t count)
+{
+	if(state->tx_dma != NULL) {
+		_tx_dma_kick(state);
+	} else if(count > 0) {
+		SET_FIELD(_get_reg(state)->CR1, USART_CR1_TXEIE());
+	}
+}
+
+/**
+ * Queue up as many bytes as will fit into a buffered USART's TX ring and
+ * return immediately.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param data The bytes of data to send.
+ * @param num_bytes The number of bytes of data to send.
+ *
+ * @return The number of bytes queued up (less than num_bytes if the ring
+ *         filled up).
+ */
+uint32_t usart_write(UsartReg *usart, const uint8_t *data, uint32_t num_bytes)
+{
+	UsartState *const state = _get_state(usart);
+	UsartRing *const tx = &state->tx;
+
+	ASSERT(state->buffered);
+	ASSERT(state->tx_reserved == 0);
+
+	/* Multiple tasks (and ISRs) are allowed to write at the same time. */
+	const uint32_t primask = intr_enter_critical();
+
+	const uint32_t space = (tx->mask + 1U) - (tx->head - tx->tail);
+	const uint32_t count = (num_bytes < space) ? num_bytes : space;
+
+	for(uint32_t i = 0; i < count; ++i) {
+		tx->buf[(tx->head + i) & tx->mask] = data[i];
+	}
+
+	tx->head += count;
+	_tx_start(state, count);
+
+	intr_exit_critical(primask);
+
+	return count;
+}
+
+/**
+ * Copy up to num_bytes received bytes out of a buffered USART's RX ring and
+ * return immediately.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param data Buffer to copy the received bytes into.
+ * @param num_bytes The maximum number of bytes to copy.
+ *
+ * @return The number of bytes copied (zero if nothing has been received).
+ */
+uint32_t usart_read(UsartReg *usart, uint8_t *data, uint32_t num_bytes)
+{
+	uint32_t count = 0;
+
+	while(count < num_bytes) {
+		const uint8_t *span = NULL;
+		uint32_t len = usart_rx_peek(usart, &span);
+
+		if(len == 0) {
+			break;
+		}
+
+		len = ((num_bytes - count) < len) ? (num_bytes - count) : len;
+		memcpy(&data[count], span, len);
+		usart_rx_consume(usart, len);
+		count += len;
+	}
+
+	return count;
+}
+
+/**
+ * Get the longest contiguous run of received bytes that can be read directly
+ * out of a buffered USART's RX ring. The bytes stay in the ring until they're
+ * released with usart_rx_consume(), so a frame can be parsed in place.
+ *
+ * @note Bytes that wrapped around to the start of the ring are returned by the
+ *       next call (after consuming this run).
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param data Set to point at the first unread byte.
+ *
+ * @return The number of bytes that can be read from "data" (zero if nothing
+ *         has been received).
+ */
+uint32_t usart_rx_peek(UsartReg *usart, const uint8_t **data)
+{
+	ASSERT(data != NULL);
+
+	UsartState *const state = _get_state(usart);
+	UsartRing *const rx = &state->rx;
+
+	ASSERT(state->buffered);
+
+	const uint32_t tail = rx->tail;
+	const uint32_t used = rx->head - tail;
+	const uint32_t start = tail & rx->mask;
+	const uint32_t to_end = (rx->mask + 1U) - start;
+	const uint32_t len = (used < to_end) ? used : to_end;
+
+	/* Make sure the bytes the DMA wrote are read from memory, not the cache. */
+	if((state->rx_dma != NULL) && (len > 0)) {
+		dcache_invalidate(&rx->buf[start], len);
+	}
+
+	*data = &rx->buf[start];
+
+	return len;
+}
+
+/**
+ * Release bytes returned by usart_rx_peek() so the ring can reuse the space.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param num_bytes The number of bytes to release (no more than were peeked).
+ */
+void usart_rx_consume(UsartReg *usart, uint32_t num_bytes)
+{
+	UsartState *const state = _get_state(usart);
+
+	ASSERT(state->buffered);
+	ASSERT(num_bytes <= (state->rx.head - state->rx.tail));
+
+	/**
+	 * Only the ISRs move the head, but with DMA reception they also push the tail
+	 * forward when the DMA laps the reader. An atomic add keeps either update
+	 * from getting lost.
+	 */
+	__atomic_fetch_add(&state->rx.tail, num_bytes, __ATOMIC_RELEASE);
+}
+
+/**
+ * @return The number of received bytes waiting to be read out of a buffered
+ *         USART's RX ring.
+ */
+uint32_t usart_rx_available(UsartReg *usart)
+{
+	UsartState *const state = _get_state(usart);
+
+	ASSERT(state->buffered);
+
+	return state->rx.head - state->rx.tail;
+}
+
+/**
+ * Wait on a buffered USART until a condition (updated by its ISR) becomes true.
+ * Tasks block until the ISR wakes them up; anything that can't block spins.
+ *
+ * @param state The USART being waited on.
+ * @param waiter Where the ISR looks for the task to wake up.
+ * @param done Returns true once the wait is over.
+ */
+static void _wait(UsartState *state, task_t *volatile *waiter, bool (*done)(UsartState*))
+{
+	while(!done(state)) {
+		if(task_can_block()) {
+			/* There's only room for one waiting task (see usart_enable_buffering()). */
+			ASSERT(*waiter == NULL);
+			*waiter = get_current_task();
+
+			/* Re-check now that the ISR knows to wake this task up. */
+			if(!done(state)) {
+				sched_block();
+			}
+
+			*waiter = NULL;
+		}
+	}
+}
+
+/* Conditions used with _wait(). */
+static bool _tx_has_space(UsartState *state)
+{
+	return (state->tx.head - state->tx.tail) <= state->tx.mask;
+}
+
+static bool _rx_has_data(UsartState *state)
+{
+	return state->rx.head != state->rx.tail;
+}
+
+static bool _tx_is_empty(UsartState *state)
+{
+	return state->tx.head == state->tx.tail;
+}
+
+static bool _tx_has_reserve_space(UsartState *state)
+{
+	return ((state->tx.mask + 1U) - (state->tx.head - state->tx.tail)) >= state->tx_reserved;
+}
+
 /**
  * Send a single byte of data over the USART.
  *
+ * @note With buffering enabled, this waits for room in the TX ring instead of
+ *       for the transmitter.
+ *
  * @param usart Pointer to the USART register map for the wanted USART module.
  * @param data The byte of data to send.
  */
 void usart_send_byte(UsartReg *usart, uint8_t data)
 {
-	/* Wait for any current transmissions to complete. */
-	while(!GET_USART_ISR_TXE(usart->ISR));
-
-	usart->TDR = data;
+	usart_send(usart, &data, 1);
 }
 
 /**
  * Send a multiple bytes of data over the USART.
  *
+ * @note With buffering enabled, this returns as soon as every byte has been
+ *       queued up (blocking the calling task while the TX ring is full).
+ *
  * @param usart Pointer to the USART register map for the wanted USART module.
  * @param data The bytes of data to send.
  * @param num_bytes The number of bytes of data to send.
  */
 void usart_send(UsartReg *usart, uint8_t *data, uint32_t num_bytes)
 {
+	UsartState *const state = _get_state(usart);
+
+	if(state->buffered) {
+		while(num_bytes > 0) {
+			_wait(state, &state->tx_waiter, _tx_has_space);
+
+			const uint32_t count = usart_write(usart, data, num_bytes);
+			data += count;
+			num_bytes -= count;
+		}
+
+		return;
+	}
+
 	for(uint32_t i = 0; i < num_bytes; ++i) {
-		usart_send_byte(usart, data[i]);
+		/* Wait for any current transmissions to complete. */
+		while(!GET_USART_ISR_TXE(usart->ISR));
+
+		usart->TDR = data[i];
+		state->stats.tx_bytes++;
 	}
 }
 
+/**
+ * Reserve space in a buffered USART's TX ring so data can be generated straight
+ * into the ring instead of being built up in a separate buffer and copied in.
+ * The calling task blocks until enough space is free. Nothing gets sent until
+ * the data is handed over with usart_tx_commit().
+ *
+ * @note Only one reservation can be held at a time, and nothing else can write
+ *       to the USART (e.g., with usart_send()) while it's held.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param num_bytes The number of bytes to reserve (no more than the ring size).
+ * @param space Filled in with where the reserved bytes are. Byte "i" of the
+ *              reservation is space->buf[(space->start + i) & space->mask].
+ */
+void usart_tx_reserve(UsartReg *usart, uint32_t num_bytes, UsartTxSpace *space)
+{
+	ASSERT(space != NULL);
+
+	UsartState *const state = _get_state(usart);
+
+	ASSERT(state->buffered);
+	ASSERT(state->tx_reserved == 0);
+	ASSERT((num_bytes > 0) && (num_bytes <= (state->tx.mask + 1U)));
+
+	state->tx_reserved = num_bytes;
+	_wait(state, &state->tx_waiter, _tx_has_reserve_space);
+
+	space->buf = state->tx.buf;
+	space->mask = state->tx.mask;
+	space->start = state->tx.head;
+}
+
+/**
+ * Send data that was written into space from usart_tx_reserve() and release
+ * the reservation.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param num_bytes The number of bytes written at the start of the
+ *                  reservation (can be less than were reserved).
+ */
+void usart_tx_commit(UsartReg *usart, uint32_t num_bytes)
+{
+	UsartState *const state = _get_state(usart);
+
+	ASSERT(num_bytes <= state->tx_reserved);
+
+	const uint32_t primask = intr_enter_critical();
+
+	state->tx.head += num_bytes;
+	state->tx_reserved = 0;
+	_tx_start(state, num_bytes);
+
+	intr_exit_critical(primask);
+}
+
 /**
  * Block until a character is received over the USART and return it.
  *
+ * @note With buffering enabled, the calling task blocks until a byte arrives
+ *       in the RX ring.
+ *
  * @param usart Pointer to the USART register map for the wanted USART module.
  *
  * @return The received byte of data.
  */
 uint8_t usart_receive(UsartReg *usart)
 {
+	UsartState *const state = _get_state(usart);
+
+	if(state->buffered) {
+		uint8_t data = 0;
+
+		while(usart_read(usart, &data, 1) == 0) {
+			_wait(state, &state->rx_waiter, _rx_has_data);
+		}
+
+		return data;
+	}
+
 	/* Wait for a character to be received. */
-	while(!GET_USART_ISR_RXNE(usart->ISR));
+	while(!GET_USART_ISR_RXNE(usart->ISR)) {
+		_handle_errors(usart, state, usart->ISR);
+	}
+
+	_handle_errors(usart, state, usart->ISR);
+	state->stats.rx_bytes++;
 
 	return (uint8_t)usart->RDR;
 }
+
+/**
+ * Block until a buffered USART has received data and return how much is
+ * waiting. With DMA reception this returns once per frame (when the line goes
+ * idle), making it a natural fit for usart_rx_peek()/usart_rx_consume().
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ *
+ * @return The number of received bytes waiting to be read (never zero).
+ */
+uint32_t usart_rx_wait(UsartReg *usart)
+{
+	UsartState *const state = _get_state(usart);
+
+	ASSERT(state->buffered);
+
+	_wait(state, &state->rx_waiter, _rx_has_data);
+
+	return state->rx.head - state->rx.tail;
+}
+
+/**
+ * Wait until every queued up byte has been sent out over the wire.
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ */
+void usart_flush(UsartReg *usart)
+{
+	UsartState *const state = _get_state(usart);
+
+	if(state->buffered) {
+		_wait(state, &state->tx_waiter, _tx_is_empty);
+	}
+
+	/* Wait for the last byte to leave the shift register. */
+	while(!GET_USART_ISR_TC(usart->ISR));
+}
+
+/**
+ * Retrieve a USART's byte and error counters (counted since usart_init()).
+ *
+ * @param usart Pointer to the USART register map for the wanted USART module.
+ * @param stats Filled in with the USART's statistics.
+ */
+void usart_get_stats(UsartReg *usart, UsartStats *stats)
+{
+	ASSERT(stats != NULL);
+
+	UsartState *const state = _get_state(usart);
+
+	const uint32_t primask = intr_enter_critical();
+	*stats = state->stats;
+	intr_exit_critical(primask);
+}
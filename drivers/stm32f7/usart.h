@@ -8,11 +8,38 @@
 
 #include "gpio.h"
 
+#include "registers/dma_reg.h"
 #include "registers/usart_reg.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Byte and error counters kept for every USART. */
+typedef struct {
+	/* Bytes sent and received. */
+	uint32_t tx_bytes;
+	uint32_t rx_bytes;
+
+	/* Received bytes thrown away because the RX ring was full. */
+	uint32_t rx_dropped;
+
+	/* Receive errors flagged by the hardware. */
+	uint32_t overrun_errors;
+	uint32_t framing_errors;
+	uint32_t noise_errors;
+	uint32_t parity_errors;
+
+	/* DMA transfer errors (the affected stream gets stopped). */
+	uint32_t dma_errors;
+} UsartStats;
+
+/* Space in a USART's TX ring held by usart_tx_reserve(). */
+typedef struct {
+	uint8_t *buf;
+	uint32_t mask;
+	uint32_t start;
+} UsartTxSpace;
+
 void usart_init(
 	UsartReg *usart,
 	uint32_t baud,
@@ -25,3 +52,30 @@ void usart_send_byte(UsartReg *usart, uint8_t data);
 void usart_send(UsartReg *usart, uint8_t *data, uint32_t num_bytes);
 
 uint8_t usart_receive(UsartReg *usart);
+
+/**
+ * A buffered USART wakes up a single waiting task per direction: only one task
+ * may block writing to it at a time, and only one task may block reading.
+ */
+void usart_enable_buffering(
+	UsartReg *usart,
+	uint8_t *tx_buf,
+	uint32_t tx_size,
+	uint8_t *rx_buf,
+	uint32_t rx_size);
+
+void usart_enable_dma_tx(UsartReg *usart, DmaReg *dma, uint8_t stream, uint8_t channel);
+void usart_enable_dma_rx(UsartReg *usart, DmaReg *dma, uint8_t stream, uint8_t channel);
+
+uint32_t usart_write(UsartReg *usart, const uint8_t *data, uint32_t num_bytes);
+uint32_t usart_read(UsartReg *usart, uint8_t *data, uint32_t num_bytes);
+uint32_t usart_rx_available(UsartReg *usart);
+uint32_t usart_rx_peek(UsartReg *usart, const uint8_t **data);
+void usart_rx_consume(UsartReg *usart, uint32_t num_bytes);
+uint32_t usart_rx_wait(UsartReg *usart);
+void usart_flush(UsartReg *usart);
+
+void usart_tx_reserve(UsartReg *usart, uint32_t num_bytes, UsartTxSpace *space);
+void usart_tx_commit(UsartReg *usart, uint32_t num_bytes);
+
+void usart_get_stats(UsartReg *usart, UsartStats *stats);
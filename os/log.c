@@ -0,0 +1,326 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Lock-free log ring buffer.
+ *
+ * Any number of tasks and ISRs can write messages into the ring at the same
+ * time without ever blocking or disabling interrupts. A low-priority task then
+ * drains the ring and hands the messages to the output function (semihosting
+ * by default). This keeps slow debug output (a semihosting call halts the CPU
+ * for milliseconds) from distorting the timing of the code doing the logging.
+ *
+ * Every message is stored as a record: a 32-bit header followed by the message
+ * (padded to a multiple of four bytes). Writers reserve space for a record by
+ * atomically advancing the reserve index with a compare-and-swap, copy their
+ * message in, and then publish the record by setting the committed bit in its
+ * header. Records never wrap around the end of the ring; if one doesn't fit,
+ * the rest of the ring gets filled with a "skip" record. The reader stops at
+ * the first record that hasn't been committed yet, and zeroes out every record
+ * it consumes so stale data is never mistaken for a committed header.
+ *
+ * If the ring is full, messages are dropped (and counted) instead of waiting.
+ *
+ * With ENABLE_LOG_BINARY set, LOG_BINARY() messages are stored as small binary
+ * frames (see log_binary()) that get decoded on the host by
+ * tools/log_decode.py. Text and binary messages can be freely mixed.
+ */
+#include "config.h"
+#include "debug.h"
+#include "os/log.h"
+#include "os/task.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if ENABLE_LOG_RING
+
+#ifdef SEMIHOSTING_ENABLED
+/**
+ * Newlib's semihosting write syscall. This is declared here instead of pulling
+ * in <unistd.h>, whose sleep() conflicts with the one in system_timer.h.
+ */
+int _write(int file, char *ptr, int len);
+#define SEMIHOSTING_STDOUT 1
+#endif /* SEMIHOSTING_ENABLED */
+
+_Static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1U)) == 0, "LOG_RING_SIZE must be a power of two");
+
+#define LOG_RING_MASK (LOG_RING_SIZE - 1U)
+
+/* Record header fields. */
+#define HDR_COMMITTED 0x80000000U
+#define HDR_SKIP      0x40000000U
+#define HDR_LEN_MASK  0x0000FFFFU
+
+#define HDR_SIZE sizeof(uint32_t)
+
+/* Total size of a record holding "len" bytes of message. */
+#define RECORD_SIZE(len) (HDR_SIZE + (((len) + 3U) & ~3U))
+
+/* Longest message that can be written (anything longer gets truncated). */
+#define MAX_MSG_LEN ((LOG_RING_SIZE / 2U) - HDR_SIZE)
+
+/* The ring itself. Records are always word aligned. */
+static uint8_t ring[LOG_RING_SIZE] __attribute__ ((aligned (4)));
+
+/* Free-running byte counts of everything reserved and consumed. */
+static uint32_t reserve_head = 0;
+static uint32_t tail = 0;
+
+/* Number of messages dropped because the ring was full. */
+static uint32_t dropped = 0;
+
+/* Set while a reader is draining the ring (only one reader at a time). */
+static bool draining = false;
+
+/**
+ * Default output function. Writes to the debugger's console over semihosting.
+ */
+static void _semihosting_output(const char *data, size_t len)
+{
+#ifdef SEMIHOSTING_ENABLED
+	_write(SEMIHOSTING_STDOUT, (char*)data, (int)len);
+#else
+	(void)data;
+	(void)len;
+#endif /* SEMIHOSTING_ENABLED */
+}
+
+/* Where drained messages go. */
+static log_output_t output = _semihosting_output;
+
+/* The task that drains the ring. */
+STATIC_TASK_ALLOC(log, LOG_TASK_STACK_SIZE);
+static volatile bool log_task_created = false;
+
+/**
+ * Reserve space in the ring for a record holding "len" bytes of message.
+ *
+ * @param len Length of the message (must be no more than MAX_MSG_LEN).
+ *
+ * @return The start of the record (its header), or NULL if the ring is full.
+ */
+static uint8_t *_log_reserve(size_t len)
+{
+	const uint32_t record_size = RECORD_SIZE(len);
+	uint32_t head = __atomic_load_n(&reserve_head, __ATOMIC_RELAXED);
+	uint32_t padding;
+
+	/* Reserve space for the record (and any padding needed before it). */
+	do {
+		const uint32_t offset = head & LOG_RING_MASK;
+		padding = (offset + record_size > LOG_RING_SIZE) ? (LOG_RING_SIZE - offset) : 0;
+
+		if((head + padding + record_size - __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) > LOG_RING_SIZE) {
+			__atomic_fetch_add(&dropped, 1U, __ATOMIC_RELAXED);
+			return NULL;
+		}
+	} while(!__atomic_compare_exchange_n(&reserve_head,
+	                                     &head,
+	                                     head + padding + record_size,
+	                                     true,
+	                                     __ATOMIC_ACQUIRE,
+	                                     __ATOMIC_RELAXED));
+
+	if(padding != 0) {
+		uint32_t *const skip = (uint32_t*)&ring[head & LOG_RING_MASK];
+		__atomic_store_n(skip, HDR_COMMITTED | HDR_SKIP | (padding - HDR_SIZE), __ATOMIC_RELEASE);
+	}
+
+	return &ring[(head + padding) & LOG_RING_MASK];
+}
+
+/**
+ * Publish a record that was filled in after being reserved with _log_reserve()
+ * and get it output.
+ *
+ * @param record The record returned by _log_reserve().
+ * @param len Length of the message stored in the record.
+ */
+static void _log_commit(uint8_t *record, size_t len)
+{
+	__atomic_store_n((uint32_t*)record, HDR_COMMITTED | len, __ATOMIC_RELEASE);
+
+	if(log_task_created) {
+		sched_wake(&log_task);
+	} else {
+		log_flush();
+	}
+}
+
+/**
+ * Write a message into the log ring. If the drain task isn't running yet, the
+ * message gets output immediately by the caller.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param data The message to write.
+ * @param len Length of the message in bytes. Messages longer than half of the
+ *            ring get truncated.
+ */
+void log_write(const char *data, size_t len)
+{
+	if(len == 0) {
+		return;
+	}
+
+	if(len > MAX_MSG_LEN) {
+		len = MAX_MSG_LEN;
+	}
+
+	uint8_t *const record = _log_reserve(len);
+	if(record == NULL) {
+		return;
+	}
+
+	memcpy(record + HDR_SIZE, data, len);
+	_log_commit(record, len);
+}
+
+#if ENABLE_LOG_BINARY
+_Static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Binary log frames are assumed to be little endian");
+
+/**
+ * Write a binary log message into the ring. This is what LOG_BINARY() calls;
+ * nothing gets formatted on the target, the format string's ID and the raw
+ * argument words are copied into the ring as a single frame:
+ *
+ *     byte 0:    0x00 (text output never contains a NUL, so this marks a frame)
+ *     byte 1:    Number of arguments
+ *     byte 2-3:  Format string ID (little endian)
+ *     byte 4-:   Arguments, one 32-bit little endian word each
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param id The format string's ID (its offset within the .log_fmt section).
+ * @param nargs The number of arguments that follow (at most LOG_BINARY_MAX_ARGS).
+ */
+void log_binary(uint32_t id, uint32_t nargs, ...)
+{
+	const size_t len = (nargs + 1U) * sizeof(uint32_t);
+
+	uint8_t *const record = _log_reserve(len);
+	if(record == NULL) {
+		return;
+	}
+
+	uint32_t *frame = (uint32_t*)(record + HDR_SIZE);
+	*frame++ = (id << 16) | (nargs << 8);
+
+	va_list args;
+	va_start(args, nargs);
+	for(uint32_t i = 0; i < nargs; ++i) {
+		*frame++ = va_arg(args, uint32_t);
+	}
+	va_end(args);
+
+	_log_commit(record, len);
+}
+#endif /* ENABLE_LOG_BINARY */
+
+/**
+ * Output every committed message in the ring. The caller has to be the only
+ * reader.
+ */
+static void _log_drain(void)
+{
+	uint32_t pos = tail;
+
+	while(pos != __atomic_load_n(&reserve_head, __ATOMIC_ACQUIRE)) {
+		uint8_t *const record = &ring[pos & LOG_RING_MASK];
+		const uint32_t header = __atomic_load_n((uint32_t*)record, __ATOMIC_ACQUIRE);
+
+		/* The writer of this record hasn't finished yet. */
+		if(!(header & HDR_COMMITTED)) {
+			break;
+		}
+
+		const uint32_t len = header & HDR_LEN_MASK;
+
+		if(!(header & HDR_SKIP) && (output != NULL)) {
+			output((const char*)(record + HDR_SIZE), len);
+		}
+
+		memset(record, 0, RECORD_SIZE(len));
+		pos += RECORD_SIZE(len);
+		__atomic_store_n(&tail, pos, __ATOMIC_RELEASE);
+	}
+}
+
+/**
+ * Output every committed message in the ring from the caller's context. This
+ * is normally done by the drain task, but can be called directly when the
+ * output needs to happen right away.
+ */
+void log_flush(void)
+{
+	/* Only one reader at a time. If someone else is already draining, let them. */
+	if(__atomic_exchange_n(&draining, true, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	_log_drain();
+
+	__atomic_store_n(&draining, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * Output every committed message in the ring, even if the drain task was
+ * interrupted partway through draining it (in which case the message it was
+ * outputting may show up twice). This is only meant for when the system is
+ * dying: interrupts have to be disabled, since the interrupted reader is never
+ * expected to run again.
+ */
+void log_panic_flush(void)
+{
+	__atomic_store_n(&draining, true, __ATOMIC_RELAXED);
+	_log_drain();
+}
+
+/**
+ * Change where log messages get sent to.
+ *
+ * @param new_output The new output function (or NULL to throw messages away).
+ */
+void log_set_output(log_output_t new_output)
+{
+	output = new_output;
+}
+
+/**
+ * @return The number of messages that were dropped because the ring was full.
+ */
+uint32_t log_get_dropped(void)
+{
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+/**
+ * The drain task. Outputs messages whenever any get written.
+ */
+static void _log_task(__unused void *param)
+{
+	while(1) {
+		log_flush();
+		sched_block();
+	}
+}
+
+/**
+ * Create the task that drains the log ring. This is called by sched_begin().
+ */
+void log_task_create(void)
+{
+	STATIC_TASK_CREATE(log, LOG_TASK_STACK_SIZE, _log_task, NULL);
+	task_set_priority(&log_task, LOG_TASK_PRIORITY);
+	log_task_created = true;
+
+	/* Catch up on anything written before the task existed. */
+	sched_wake(&log_task);
+}
+
+#endif /* ENABLE_LOG_RING */
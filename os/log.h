@@ -0,0 +1,65 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Lock-free log ring buffer that decouples debug output from the code that
+ * produces it.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Signature for functions that send log data to the outside world. */
+typedef void (*log_output_t)(const char *data, size_t len);
+
+#if ENABLE_LOG_RING
+void log_write(const char *data, size_t len);
+void log_flush(void);
+void log_panic_flush(void);
+
+void log_set_output(log_output_t output);
+uint32_t log_get_dropped(void);
+
+void log_task_create(void);
+
+#if ENABLE_LOG_BINARY
+/* Maximum number of arguments a LOG_BINARY() message can have. */
+#define LOG_BINARY_MAX_ARGS 8U
+
+void log_binary(uint32_t id, uint32_t nargs, ...);
+
+/* Never called, only used to have the compiler check LOG_BINARY() arguments. */
+void log_binary_check_format(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+
+/* Count the arguments passed to LOG_BINARY() (one past the maximum gets caught). */
+#define _LOG_NARGS(...) _LOG_NARGS_(0, ##__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, N, ...) N
+
+/**
+ * Log a message without formatting it on the target. The format string gets
+ * placed into the .log_fmt section (which is kept in the ELF file but never
+ * loaded onto the target) and only its ID plus the raw argument words get
+ * written into the log ring. Use tools/log_decode.py to turn the output back
+ * into text.
+ *
+ * Every argument must be 32 bits or smaller (no "%ll", "%j" or floating point).
+ * "%s" arguments are printed by the decoder only if they point to a string
+ * constant stored in flash.
+ */
+#define LOG_BINARY(format, ...)                                                       \
+	do {                                                                              \
+		_Static_assert(_LOG_NARGS(__VA_ARGS__) <= LOG_BINARY_MAX_ARGS,                \
+		               "Too many LOG_BINARY() arguments");                            \
+		static const char _log_fmt[] __attribute__ ((section (".log_fmt"))) = format; \
+		if(0) {                                                                       \
+			log_binary_check_format(format, ##__VA_ARGS__);                           \
+		}                                                                             \
+		log_binary((uint32_t)(uintptr_t)_log_fmt,                                     \
+		           _LOG_NARGS(__VA_ARGS__),                                           \
+		           ##__VA_ARGS__);                                                    \
+	} while(0)
+#endif /* ENABLE_LOG_BINARY */
+#endif /* ENABLE_LOG_RING */
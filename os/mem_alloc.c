@@ -2,24 +2,86 @@
  * @author Devon Andrade
  * @created 3/28/21
  *
- * Simple dynamic memory allocation library. The algorithm used is an
- * "init-only, no free" allocator. The expectation is that all dynamic memory
- * allocations would be performed during bootstrap() (potentially influenced by
- * runtime configuration data) and won't be changed after that.
+ * Dynamic memory allocation library. Allocations come out of a TLSF heap (see
+ * os/tlsf.c) which gives mem_alloc() and mem_free() bounded execution time and
+ * no unbounded fragmentation, so memory can be allocated and freed at runtime.
+ *
+ * Every memory region (see mem_region_t) gets its own heap so that memory can
+ * be allocated from a specific region with mem_alloc_in(). The RAM between the
+ * end of the BSS section and the interrupt stack (except for the
+ * MEM_ALLOC_NEWLIB_RESERVE bytes left for newlib's malloc() through _sbrk())
+ * is split up at the region boundaries into the DTCM, SRAM1, and SRAM2 heaps.
+ * These heaps get created the first time memory is allocated. Other memory
+ * (like SDRAM, which has to be initialized first) is added with
+ * mem_region_add().
+ *
+ * Fixed-size objects that get recycled a lot should use a zone instead (see
+ * os/zone_alloc.c).
  */
 #include "config.h"
 #include "debug.h"
+#include "interrupt.h"
 #include "os/mem_alloc.h"
+#include "os/tlsf.h"
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+/**
+ * Region boundaries. These symbols are created by the board's linker script.
+ */
+extern uint8_t _dtcm_start, _dtcm_end;
+extern uint8_t _sram1_start, _sram1_end;
+extern uint8_t _sram2_start, _sram2_end;
+#if ENABLE_SDRAM
+extern uint8_t _sdram_start, _sdram_end;
+#endif /* ENABLE_SDRAM */
+
+/* Address range covered by each memory region. */
+static const struct {
+	uint8_t *start;
+	uint8_t *end;
+} regions[MEM_REGION_COUNT] = {
+	[MEM_REGION_DTCM] = { &_dtcm_start, &_dtcm_end },
+	[MEM_REGION_SRAM1] = { &_sram1_start, &_sram1_end },
+	[MEM_REGION_SRAM2] = { &_sram2_start, &_sram2_end },
+#if ENABLE_SDRAM
+	[MEM_REGION_SDRAM] = { &_sdram_start, &_sdram_end },
+#else
+	[MEM_REGION_SDRAM] = { NULL, NULL },
+#endif /* ENABLE_SDRAM */
+};
+
+/**
+ * The order mem_alloc() tries the regions in. DTCM is scarce so it's left for
+ * memory that explicitly asks for it, and SDRAM is the slowest.
+ */
+static const mem_region_t default_order[MEM_REGION_COUNT] = {
+	MEM_REGION_SRAM1,
+	MEM_REGION_SRAM2,
+	MEM_REGION_DTCM,
+	MEM_REGION_SDRAM,
+};
+
+/* The heap for each region (NULL if the region doesn't have a heap). */
+static tlsf_t *heaps[MEM_REGION_COUNT];
+
+/* Set once the internal RAM heaps have been created. */
+static bool heaps_initialized = false;
+
+#if ENABLE_MEM_DEBUG
+/* The furthest _sbrk() has ever grown. */
+static uintptr_t sbrk_high_water = 0;
+#endif /* ENABLE_MEM_DEBUG */
 
 /**
  * Overload the weak linkage of the newlib-provided _sbrk() system call. This
  * call is used by newlib's malloc() to allocate and free memory. This call is
- * also used by the mem_alloc() functions in this file to provide a very simple
- * init-only, no-free allocator. By using the same _sbrk() system call as the
- * newlib malloc(), it ensures that allocating heap memory outside of malloc()
- * does not clobber malloc() memory.
+ * also used to carve out the memory for the default mem_alloc() heap. By using
+ * the same _sbrk() system call as the newlib malloc(), it ensures that the
+ * mem_alloc() heap does not clobber malloc() memory.
  *
  * The malloc() call is used by various newlib functions (like printf).
  *
@@ -67,11 +129,278 @@ void * _sbrk(int incr) {
 
 	heap_current += incr;
 
+#if ENABLE_MEM_DEBUG
+	if((uintptr_t)heap_current > sbrk_high_water) {
+		sbrk_high_water = (uintptr_t)heap_current;
+	}
+#endif /* ENABLE_MEM_DEBUG */
+
 	return (void*)prev_heap;
 }
 
 /**
- * Allocate a chunk of memory from the heap.
+ * Split all of the memory _sbrk() has left (minus what is reserved for newlib)
+ * into a heap for each internal RAM region.
+ */
+static void _heap_init(void)
+{
+	/* See _sbrk() for details on this symbol. */
+	extern const void *_interrupt_stack_top;
+
+	heaps_initialized = true;
+
+	const uintptr_t heap_start = (uintptr_t)_sbrk(0);
+	const uintptr_t heap_end = (uintptr_t)&_interrupt_stack_top -
+	                           MIN_INTR_STACK_SIZE -
+	                           MEM_ALLOC_NEWLIB_RESERVE;
+
+	ABORT_IF(heap_end <= heap_start);
+	ABORT_IF(_sbrk((int)(heap_end - heap_start)) == ALLOC_FAILURE);
+
+	for(mem_region_t region = MEM_REGION_DTCM; region <= MEM_REGION_SRAM2; region++) {
+		const uintptr_t region_start = (uintptr_t)regions[region].start;
+		const uintptr_t region_end = (uintptr_t)regions[region].end;
+		const uintptr_t start = (heap_start > region_start) ? heap_start : region_start;
+		const uintptr_t end = (heap_end < region_end) ? heap_end : region_end;
+
+		/* Regions that are too small to hold a heap are skipped. */
+		if(start < end) {
+			heaps[region] = tlsf_create((void*)start, end - start);
+		}
+	}
+}
+
+/**
+ * Give a chunk of memory to a region's heap. This is meant for memory that
+ * can't be used until it has been initialized (e.g., add the SDRAM after
+ * calling fmc_sdram_init()).
+ *
+ * @param region The region the memory belongs to. The region can't already
+ *               have a heap.
+ * @param mem Start of the memory.
+ * @param size Size of the memory in bytes.
+ */
+void mem_region_add(mem_region_t region, void *mem, size_t size)
+{
+	ASSERT(region < MEM_REGION_COUNT);
+	ASSERT((uint8_t*)mem >= regions[region].start);
+	ASSERT((uint8_t*)mem + size <= regions[region].end);
+
+	const uint32_t primask = intr_enter_critical();
+
+	ABORT_IF(heaps[region] != NULL);
+	heaps[region] = tlsf_create(mem, size);
+	ABORT_IF(heaps[region] == NULL);
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Allocate memory from a region's heap. Must be called with interrupts
+ * disabled.
+ *
+ * @param region The region to allocate from, or MEM_REGION_COUNT to try every
+ *               region in the default order.
+ *
+ * @return The memory or NULL if it couldn't be allocated.
+ */
+static void * _alloc(mem_region_t region, size_t size, size_t align)
+{
+	if(!heaps_initialized) {
+		_heap_init();
+	}
+
+	if(region == MEM_REGION_COUNT) {
+		void *data = NULL;
+
+		for(uint32_t i = 0; (i < MEM_REGION_COUNT) && (data == NULL); i++) {
+			data = _alloc(default_order[i], size, align);
+		}
+
+		return data;
+	}
+
+	if(heaps[region] == NULL) {
+		return NULL;
+	}
+
+	return tlsf_memalign(heaps[region], align, size);
+}
+
+/**
+ * Return memory to whichever heap it came from. Must be called with interrupts
+ * disabled.
+ */
+static void _free(void *data)
+{
+	mem_region_t region = MEM_REGION_DTCM;
+	while((region < MEM_REGION_COUNT) &&
+	      ((heaps[region] == NULL) || !tlsf_owns(heaps[region], data))) {
+		region++;
+	}
+
+	ABORT_IF(region == MEM_REGION_COUNT);
+	tlsf_free(heaps[region], data);
+}
+
+#if ENABLE_MEM_DEBUG
+/* Value stored directly in front of every instrumented allocation. */
+#define MEM_DEBUG_CANARY 0xC0DEFACEU
+
+/**
+ * Header placed in front of every instrumented allocation. If the allocation
+ * needed extra alignment, the header is pushed forward to sit directly in front
+ * of the data, and the first word of the padding also holds the offset.
+ */
+typedef struct {
+	/* Offset from the start of the TLSF block to the allocation's data. */
+	uint32_t offset;
+
+	/* The number of bytes requested. */
+	uint32_t size;
+
+	/* Index of the allocation's call site in the "sites" array. */
+	uint32_t site;
+
+	/* Must always be MEM_DEBUG_CANARY (catches underruns). */
+	uint32_t canary;
+} mem_debug_hdr_t;
+
+/* Statistics for every call site that has allocated memory. */
+static mem_site_stats_t sites[MEM_DEBUG_MAX_CALL_SITES];
+static uint32_t num_sites = 0;
+
+/* Heap-wide statistics (in bytes requested). */
+static size_t cur_bytes = 0;
+static size_t peak_bytes = 0;
+static uint32_t num_live = 0;
+static uint32_t total_allocs = 0;
+static uint32_t num_failures = 0;
+
+/**
+ * Find (or create) the statistics entry for a call site.
+ *
+ * @return The index of the call site in the "sites" array.
+ */
+static uint32_t _find_site(uintptr_t caller)
+{
+	for(uint32_t i = 0; i < num_sites; i++) {
+		if(sites[i].caller == caller) {
+			return i;
+		}
+	}
+
+	if(num_sites < (MEM_DEBUG_MAX_CALL_SITES - 1U)) {
+		sites[num_sites].caller = caller;
+		return num_sites++;
+	}
+
+	/* Out of room, everything else goes into the last entry. */
+	num_sites = MEM_DEBUG_MAX_CALL_SITES;
+	return MEM_DEBUG_MAX_CALL_SITES - 1U;
+}
+
+/**
+ * Verify an instrumented allocation's canary and red zone. Aborts if either
+ * one has been overwritten.
+ *
+ * @return The allocation's header.
+ */
+static mem_debug_hdr_t * _debug_check(uint8_t *data)
+{
+	mem_debug_hdr_t *const hdr = (mem_debug_hdr_t*)data - 1;
+
+	if(hdr->canary != MEM_DEBUG_CANARY) {
+		ABORT("Heap corruption in front of %p", data);
+	}
+
+	for(uint32_t i = 0; i < MEM_DEBUG_REDZONE_SIZE; i++) {
+		if(data[hdr->size + i] != MEM_DEBUG_REDZONE_VALUE) {
+			ABORT("Heap overrun past %p (%lu bytes allocated)", data, hdr->size);
+		}
+	}
+
+	return hdr;
+}
+
+/**
+ * Allocate memory with a header and red zone. Must be called with interrupts
+ * disabled.
+ */
+static void * _debug_alloc(mem_region_t region, size_t size, size_t align, uintptr_t caller)
+{
+	const size_t offset = (align > sizeof(mem_debug_hdr_t)) ? align : sizeof(mem_debug_hdr_t);
+	uint8_t *const block = _alloc(region, offset + size + MEM_DEBUG_REDZONE_SIZE, align);
+
+	if(block == NULL) {
+		num_failures++;
+		return NULL;
+	}
+
+	uint8_t *const data = block + offset;
+	mem_debug_hdr_t *const hdr = (mem_debug_hdr_t*)data - 1;
+
+	*(uint32_t*)block = offset;
+	hdr->offset = offset;
+	hdr->size = size;
+	hdr->site = _find_site(caller);
+	hdr->canary = MEM_DEBUG_CANARY;
+	memset(data + size, MEM_DEBUG_REDZONE_VALUE, MEM_DEBUG_REDZONE_SIZE);
+
+	mem_site_stats_t *const site = &sites[hdr->site];
+	site->cur_bytes += size;
+	site->num_live++;
+	site->total_allocs++;
+	if(site->cur_bytes > site->peak_bytes) {
+		site->peak_bytes = site->cur_bytes;
+	}
+
+	cur_bytes += size;
+	num_live++;
+	total_allocs++;
+	if(cur_bytes > peak_bytes) {
+		peak_bytes = cur_bytes;
+	}
+
+	return data;
+}
+
+/**
+ * Check and free an instrumented allocation. Must be called with interrupts
+ * disabled.
+ */
+static void _debug_free(uint8_t *data)
+{
+	mem_debug_hdr_t *const hdr = _debug_check(data);
+	mem_site_stats_t *const site = &sites[hdr->site];
+
+	site->cur_bytes -= hdr->size;
+	site->num_live--;
+	cur_bytes -= hdr->size;
+	num_live--;
+
+	/* Smash the canary to catch double frees. */
+	hdr->canary = 0;
+
+	_free(data - hdr->offset);
+}
+
+/**
+ * tlsf_walk() callback that checks every allocated block's red zones.
+ */
+static void _debug_check_block(void *ptr, __unused size_t size, bool used, __unused void *arg)
+{
+	if(used) {
+		_debug_check((uint8_t*)ptr + *(uint32_t*)ptr);
+	}
+}
+#endif /* ENABLE_MEM_DEBUG */
+
+/**
+ * Allocate a chunk of memory from the heap. The memory will come from
+ * whichever region has enough space (trying SRAM before DTCM and SDRAM).
+ *
+ * @note Safe to call from ISRs.
  *
  * @param size The number of bytes to allocate from the heap. Can't be zero.
  *
@@ -82,22 +411,233 @@ void * mem_alloc(size_t size)
 {
 	ASSERT(size > 0);
 
-	return _sbrk(size);
+	const uint32_t primask = intr_enter_critical();
+#if ENABLE_MEM_DEBUG
+	void *const data = _debug_alloc(MEM_REGION_COUNT,
+	                                size,
+	                                TLSF_ALIGNMENT,
+	                                (uintptr_t)__builtin_return_address(0));
+#else
+	void *const data = _alloc(MEM_REGION_COUNT, size, TLSF_ALIGNMENT);
+#endif /* ENABLE_MEM_DEBUG */
+	intr_exit_critical(primask);
+
+	return (data != NULL) ? data : ALLOC_FAILURE;
+}
+
+/**
+ * Allocate a chunk of memory from a specific memory region.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param region The memory region to allocate from.
+ * @param size The number of bytes to allocate. Can't be zero.
+ * @param align Alignment of the memory (must be a power of two). For instance,
+ *              buffers in cached memory that get used by DMA should be aligned
+ *              to the cache line size.
+ *
+ * @return A pointer to the beginning of the dynamically allocated memory on
+ *         success, or ALLOC_FAILURE if the memory could not be allocated.
+ */
+void * mem_alloc_in(mem_region_t region, size_t size, size_t align)
+{
+	ASSERT(region < MEM_REGION_COUNT);
+	ASSERT(size > 0);
+
+	const uint32_t primask = intr_enter_critical();
+#if ENABLE_MEM_DEBUG
+	void *const data = _debug_alloc(region,
+	                                size,
+	                                align,
+	                                (uintptr_t)__builtin_return_address(0));
+#else
+	void *const data = _alloc(region, size, align);
+#endif /* ENABLE_MEM_DEBUG */
+	intr_exit_critical(primask);
+
+	return (data != NULL) ? data : ALLOC_FAILURE;
 }
 
 /**
- * This allocator doesn't support the freeing of memory which means there can't
- * be any memory fragmentation. This function is left in here as a dummy
- * function so that if the algorithm changes, none of the client code will need
- * to be updated.
+ * Return memory previously allocated with mem_alloc() or mem_alloc_in() back
+ * to the heap.
  *
- * It's expected that consumers of this API will use this function to "free"
- * their buffers if needed even though nothing will actually happen.
+ * @note Safe to call from ISRs.
  *
  * @param data The previously allocated heap memory to free. Cannot be NULL.
  */
-void mem_free(__unused void *data)
+void mem_free(void *data)
 {
-	/* Intentionally left blank. */
 	ASSERT(data != NULL);
+	ASSERT(data != ALLOC_FAILURE);
+
+	const uint32_t primask = intr_enter_critical();
+#if ENABLE_MEM_DEBUG
+	_debug_free((uint8_t*)data);
+#else
+	_free(data);
+#endif /* ENABLE_MEM_DEBUG */
+	intr_exit_critical(primask);
+}
+
+/**
+ * Get a snapshot of a region heap's usage statistics.
+ *
+ * @param region The memory region to query.
+ * @param stats Filled in with the heap's statistics.
+ *
+ * @return False if the region doesn't have a heap.
+ */
+bool mem_get_stats(mem_region_t region, tlsf_stats_t *stats)
+{
+	ASSERT(region < MEM_REGION_COUNT);
+	ASSERT(stats != NULL);
+
+	const uint32_t primask = intr_enter_critical();
+
+	if(!heaps_initialized) {
+		_heap_init();
+	}
+
+	const bool has_heap = (heaps[region] != NULL);
+	if(has_heap) {
+		tlsf_get_stats(heaps[region], stats);
+	}
+
+	intr_exit_critical(primask);
+
+	return has_heap;
+}
+
+/**
+ * Verify the bookkeeping data of every heap (and when ENABLE_MEM_DEBUG is set,
+ * the red zones of every allocation). Interrupts are disabled while every block
+ * in every heap is checked, so this is only meant for debugging.
+ *
+ * @return True if every heap is consistent. Aborts if a red zone was
+ *         overwritten.
+ */
+bool mem_check(void)
+{
+	bool valid = true;
+	const uint32_t primask = intr_enter_critical();
+
+	for(mem_region_t region = MEM_REGION_DTCM; region < MEM_REGION_COUNT; region++) {
+		if(heaps[region] != NULL) {
+			valid = valid && tlsf_check(heaps[region]);
+
+#if ENABLE_MEM_DEBUG
+			if(valid) {
+				tlsf_walk(heaps[region], _debug_check_block, NULL);
+			}
+#endif /* ENABLE_MEM_DEBUG */
+		}
+	}
+
+	intr_exit_critical(primask);
+
+	return valid;
+}
+
+#if ENABLE_MEM_DEBUG
+/**
+ * Get a snapshot of the heap-wide allocation statistics.
+ *
+ * @param stats Filled in with the statistics.
+ */
+void mem_stats_get(mem_stats_t *stats)
+{
+	/* See _sbrk() for details on this symbol. */
+	extern const void *_interrupt_stack_top;
+
+	ASSERT(stats != NULL);
+
+	const uintptr_t sbrk_limit = (uintptr_t)&_interrupt_stack_top - MIN_INTR_STACK_SIZE;
+	const uint32_t primask = intr_enter_critical();
+
+	stats->cur_bytes = cur_bytes;
+	stats->peak_bytes = peak_bytes;
+	stats->num_live = num_live;
+	stats->total_allocs = total_allocs;
+	stats->num_failures = num_failures;
+	stats->headroom = sbrk_limit - (uintptr_t)_sbrk(0);
+	stats->min_headroom = sbrk_limit - sbrk_high_water;
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Copy out the per-call-site allocation statistics.
+ *
+ * @param out Filled in with the statistics for each call site.
+ * @param max The number of entries "out" can hold.
+ *
+ * @return The number of entries copied.
+ */
+uint32_t mem_stats_get_sites(mem_site_stats_t *out, uint32_t max)
+{
+	ASSERT(out != NULL);
+
+	const uint32_t primask = intr_enter_critical();
+
+	const uint32_t count = (num_sites < max) ? num_sites : max;
+	memcpy(out, sites, count * sizeof(mem_site_stats_t));
+
+	intr_exit_critical(primask);
+
+	return count;
+}
+
+/**
+ * Print out every allocation statistic. Call site addresses can be converted
+ * into source lines with addr2line.
+ */
+void mem_stats_dump(void)
+{
+	mem_stats_t stats;
+	mem_stats_get(&stats);
+
+	dbprintf("Heap: %u bytes in %lu allocations (peak %u bytes), %lu total allocations, %lu failed\n",
+	         (unsigned)stats.cur_bytes,
+	         stats.num_live,
+	         (unsigned)stats.peak_bytes,
+	         stats.total_allocs,
+	         stats.num_failures);
+	dbprintf("Newlib headroom: %u bytes (minimum %u bytes)\n",
+	         (unsigned)stats.headroom,
+	         (unsigned)stats.min_headroom);
+
+	for(mem_region_t region = MEM_REGION_DTCM; region < MEM_REGION_COUNT; region++) {
+		__unused tlsf_stats_t heap;
+
+		if(mem_get_stats(region, &heap)) {
+			dbprintf("Region %d: %u/%u bytes used (peak %u), largest allocation %u bytes\n",
+			         region,
+			         (unsigned)heap.used_bytes,
+			         (unsigned)heap.total_bytes,
+			         (unsigned)heap.peak_bytes,
+			         (unsigned)heap.largest_free);
+		}
+	}
+
+	__unused mem_site_stats_t site;
+	for(uint32_t i = 0; i < num_sites; i++) {
+		const uint32_t primask = intr_enter_critical();
+		site = sites[i];
+		intr_exit_critical(primask);
+
+		/* The last entry is shared by every call site that didn't get its own. */
+		if(i == (MEM_DEBUG_MAX_CALL_SITES - 1U)) {
+			dbprintf("  Other sites: ");
+		} else {
+			dbprintf("  Caller %#lx: ", (uint32_t)(site.caller & ~1U));
+		}
+
+		dbprintf("%u bytes in %lu allocations (peak %u bytes), %lu total\n",
+		         (unsigned)site.cur_bytes,
+		         site.num_live,
+		         (unsigned)site.peak_bytes,
+		         site.total_allocs);
+	}
 }
+#endif /* ENABLE_MEM_DEBUG */
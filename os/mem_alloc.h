@@ -6,9 +6,107 @@
  */
 #pragma once
 
+#include "config.h"
+#include "os/tlsf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 /* Returned from mem_alloc to denote an allocation failure. */
 #define ALLOC_FAILURE ((void*)-1)
 
+/**
+ * The distinct memory regions that can be allocated from. Each region has its
+ * own heap.
+ */
+typedef enum {
+	/* Zero wait state and never cached. Good for hot data and stacks. */
+	MEM_REGION_DTCM = 0,
+
+	/* General purpose SRAM (cached). */
+	MEM_REGION_SRAM1 = 1,
+
+	/* Small SRAM bank that by default also holds the interrupt stack (cached). */
+	MEM_REGION_SRAM2 = 2,
+
+	/* External SDRAM (slow, only available after calling mem_region_add()). */
+	MEM_REGION_SDRAM = 3,
+
+	MEM_REGION_COUNT
+} mem_region_t;
+
+/**
+ * Statically place a variable into a specific region. DTCM variables come
+ * first in the .data/.bss sections, and the linker script fails the build if
+ * they don't all fit into DTCM.
+ */
+#define __dtcm_data __attribute__ ((section (".data.dtcm")))
+#define __dtcm_bss __attribute__ ((section (".bss.dtcm")))
+
+#if ENABLE_SDRAM
+/**
+ * Variables in SDRAM aren't zeroed or initialized by the startup code, and
+ * can't be accessed until fmc_sdram_init() gets called.
+ */
+#define __sdram __attribute__ ((section (".sdram"), aligned (8)))
+#endif /* ENABLE_SDRAM */
+
+#if ENABLE_MEM_DEBUG
+/* Snapshot of the heap-wide allocation statistics. */
+typedef struct {
+	/* Bytes currently allocated (as requested, not including overhead). */
+	size_t cur_bytes;
+
+	/* The most bytes that have ever been allocated at once. */
+	size_t peak_bytes;
+
+	/* Number of allocations that haven't been freed. */
+	uint32_t num_live;
+
+	/* Total number of successful and failed allocations. */
+	uint32_t total_allocs;
+	uint32_t num_failures;
+
+	/**
+	 * Bytes left between the end of the _sbrk() heap (used by newlib) and the
+	 * interrupt stack (_interrupt_stack_top - MIN_INTR_STACK_SIZE), and the
+	 * smallest that gap has ever been.
+	 */
+	size_t headroom;
+	size_t min_headroom;
+} mem_stats_t;
+
+/* Allocation statistics for a single call site. */
+typedef struct {
+	/**
+	 * Address the allocation function was called from. Zero for the last
+	 * entry, which collects every call site after the first
+	 * (MEM_DEBUG_MAX_CALL_SITES - 1) of them.
+	 */
+	uintptr_t caller;
+
+	/* Bytes currently allocated by this call site and the most ever. */
+	size_t cur_bytes;
+	size_t peak_bytes;
+
+	/* Number of allocations that haven't been freed, and the total ever made. */
+	uint32_t num_live;
+	uint32_t total_allocs;
+} mem_site_stats_t;
+#endif /* ENABLE_MEM_DEBUG */
+
 void * _sbrk(int incr);
 void * mem_alloc(size_t size);
+void * mem_alloc_in(mem_region_t region, size_t size, size_t align);
 void mem_free(void *data);
+
+void mem_region_add(mem_region_t region, void *mem, size_t size);
+bool mem_get_stats(mem_region_t region, tlsf_stats_t *stats);
+bool mem_check(void);
+
+#if ENABLE_MEM_DEBUG
+void mem_stats_get(mem_stats_t *stats);
+uint32_t mem_stats_get_sites(mem_site_stats_t *out, uint32_t max);
+void mem_stats_dump(void);
+#endif /* ENABLE_MEM_DEBUG */
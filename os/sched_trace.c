@@ -0,0 +1,119 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Ring buffer of context switch events used to figure out what the scheduler
+ * has been doing.
+ *
+ * The context switch handler is the only writer. Once the buffer fills up, the
+ * oldest events get overwritten. Events can either be printed out over the
+ * debug channel (semihosting) with sched_trace_dump(), or read out in their
+ * binary form with sched_trace_read() and sent wherever is convenient (e.g., a
+ * USART).
+ */
+#include "config.h"
+#include "debug.h"
+#include "interrupt.h"
+#include "os/sched_trace.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if ENABLE_SCHED_TRACE
+
+_Static_assert((SCHED_TRACE_SIZE & (SCHED_TRACE_SIZE - 1)) == 0,
+               "SCHED_TRACE_SIZE must be a power of two");
+
+/* The recorded events. */
+static sched_trace_event_t trace_buffer[SCHED_TRACE_SIZE];
+
+/**
+ * Free-running count of events written and read. The buffer index is found by
+ * masking off the upper bits.
+ */
+static volatile uint32_t write_count = 0;
+static uint32_t read_count = 0;
+
+/**
+ * Record a context switch event.
+ *
+ * @note This is called from the context switch handler.
+ *
+ * @param timestamp Value of the cycle counter at the time of the switch.
+ * @param from ID of the task being switched out.
+ * @param to ID of the task being switched to.
+ * @param reason Why the switch occurred.
+ */
+void sched_trace_record(uint32_t timestamp, uint8_t from, uint8_t to, sched_reason_t reason)
+{
+	sched_trace_event_t *event = &trace_buffer[write_count & (SCHED_TRACE_SIZE - 1)];
+
+	event->timestamp = timestamp;
+	event->from = from;
+	event->to = to;
+	event->reason = (uint8_t)reason;
+	event->reserved = 0;
+
+	write_count++;
+}
+
+/**
+ * Copy the oldest unread events out of the trace buffer (oldest first). Events
+ * that were overwritten before being read are skipped.
+ *
+ * @param events Buffer to copy the events into.
+ * @param max_events The maximum number of events to copy into [events].
+ *
+ * @return The number of events copied into [events].
+ */
+size_t sched_trace_read(sched_trace_event_t *events, size_t max_events)
+{
+	ASSERT(events != NULL);
+
+	size_t num_events = 0;
+
+	/* Prevent a context switch from modifying the buffer while it's copied. */
+	const uint32_t primask = intr_enter_critical();
+
+	if((write_count - read_count) > SCHED_TRACE_SIZE) {
+		read_count = write_count - SCHED_TRACE_SIZE;
+	}
+
+	while((read_count != write_count) && (num_events < max_events)) {
+		events[num_events++] = trace_buffer[read_count & (SCHED_TRACE_SIZE - 1)];
+		read_count++;
+	}
+
+	intr_exit_critical(primask);
+
+	return num_events;
+}
+
+/**
+ * Print out (and consume) every unread event over the debug channel.
+ */
+void sched_trace_dump(void)
+{
+	__unused static const char *reasons[] = {
+		[SCHED_REASON_PREEMPT] = "preempt",
+		[SCHED_REASON_YIELD] = "yield",
+		[SCHED_REASON_BLOCK] = "block",
+		[SCHED_REASON_WAKEUP] = "wakeup"
+	};
+
+	sched_trace_event_t events[8];
+	size_t num_events = 0;
+
+	while((num_events = sched_trace_read(events, sizeof(events) / sizeof(events[0]))) > 0) {
+		for(size_t i = 0; i < num_events; ++i) {
+			dbprintf("[%10lu] task %u -> task %u (%s)\n",
+			         events[i].timestamp,
+			         events[i].from,
+			         events[i].to,
+			         (events[i].reason < (sizeof(reasons) / sizeof(reasons[0]))) ?
+			             reasons[events[i].reason] : "unknown");
+		}
+	}
+}
+
+#endif /* ENABLE_SCHED_TRACE */
@@ -0,0 +1,42 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Ring buffer of context switch events used to figure out what the scheduler
+ * has been doing.
+ */
+#pragma once
+
+#include "config.h"
+#include "os/task.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A single context switch event. This is the binary format that gets returned
+ * by sched_trace_read() (little-endian, 8 bytes per event).
+ */
+typedef struct {
+	/* Value of the DWT cycle counter when the switch occurred. */
+	uint32_t timestamp;
+
+	/* ID of the task being switched out. */
+	uint8_t from;
+
+	/* ID of the task being switched to. */
+	uint8_t to;
+
+	/* The sched_reason_t for the switch. */
+	uint8_t reason;
+
+	uint8_t reserved;
+} sched_trace_event_t;
+
+#if ENABLE_SCHED_TRACE
+void sched_trace_record(uint32_t timestamp, uint8_t from, uint8_t to, sched_reason_t reason);
+
+size_t sched_trace_read(sched_trace_event_t *events, size_t max_events);
+
+void sched_trace_dump(void);
+#endif /* ENABLE_SCHED_TRACE */
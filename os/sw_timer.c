@@ -0,0 +1,509 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * One-shot and periodic software timers.
+ *
+ * Pending timers are stored in a hierarchical timing wheel. The wheel has
+ * WHEEL_LEVELS levels of WHEEL_SLOTS slots each. Level 0 has one slot per tick,
+ * level 1 has one slot per WHEEL_SLOTS ticks, and so on. A timer is placed into
+ * the lowest level that can represent how far into the future it expires.
+ * Every time the level 0 index wraps around, the timers in the next slot of the
+ * level above are "cascaded" down into the lower levels. This makes starting,
+ * stopping, and expiring a timer O(1) regardless of how many timers are
+ * pending.
+ *
+ * The wheel is advanced by the SysTick interrupt. Expired timers are either run
+ * directly in the interrupt (SW_TIMER_FLAG_ISR) or handed off to the timer task
+ * which runs the callbacks in task context.
+ */
+#include "config.h"
+#include "debug.h"
+#include "interrupt.h"
+#include "os/sw_timer.h"
+#include "os/task.h"
+#include "system_timer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if ENABLE_SW_TIMERS
+
+/* Dimensions of the timing wheel. */
+#define WHEEL_LEVELS 4U
+#define WHEEL_SLOT_BITS 6U
+#define WHEEL_SLOTS (1U << WHEEL_SLOT_BITS)
+#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1U)
+
+/**
+ * The furthest into the future (in ticks) that a timer can be placed. Timers
+ * further out than this are placed at the end of the wheel and get re-inserted
+ * once they cascade down.
+ */
+#define WHEEL_MAX_DELTA ((1UL << (WHEEL_LEVELS * WHEEL_SLOT_BITS)) - 1U)
+
+_Static_assert(WHEEL_SLOTS == 64, "The slot bitmaps are 64 bits wide");
+
+/* Every slot of the wheel is a list of the timers expiring in that slot. */
+static sw_timer_t *wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+
+/* Bitmap of the slots that have timers in them for each level. */
+static uint64_t wheel_occupied[WHEEL_LEVELS];
+
+/* The last tick the wheel was advanced to. */
+static uint64_t wheel_tick = 0;
+
+/* Timers that have expired, but haven't been processed by sw_timer_advance(). */
+static sw_timer_t *due_list = NULL;
+
+/* Timers waiting for their callbacks to be run by the timer task. */
+static sw_timer_t *expired_list = NULL;
+
+/* Task that runs the callbacks of expired timers. */
+STATIC_TASK_ALLOC(sw_timer, SW_TIMER_TASK_STACK_SIZE);
+static bool timer_task_created = false;
+
+/**
+ * Add a timer to the front of a timer list.
+ *
+ * @note Must be called from within a critical section.
+ *
+ * @param list The list to add to.
+ * @param timer The timer to add (must not currently be on a list).
+ */
+static void _list_add(sw_timer_t **list, sw_timer_t *timer)
+{
+	timer->list = list;
+	timer->prev = NULL;
+	timer->next = *list;
+
+	if(*list != NULL) {
+		(*list)->prev = timer;
+	}
+
+	*list = timer;
+}
+
+/**
+ * Remove a timer from whichever list it's on (if any).
+ *
+ * @note Must be called from within a critical section.
+ *
+ * @param timer The timer to remove.
+ */
+static void _list_remove(sw_timer_t *timer)
+{
+	sw_timer_t **list = timer->list;
+
+	if(list == NULL) {
+		return;
+	}
+
+	if(timer->prev != NULL) {
+		timer->prev->next = timer->next;
+	} else {
+		*list = timer->next;
+	}
+
+	if(timer->next != NULL) {
+		timer->next->prev = timer->prev;
+	}
+
+	/* Keep the occupancy bitmap in sync if a wheel slot was just emptied. */
+	if((*list == NULL) &&
+	   (list >= &wheel[0][0]) &&
+	   (list < &wheel[0][0] + (WHEEL_LEVELS * WHEEL_SLOTS))) {
+		const uint32_t index = (uint32_t)(list - &wheel[0][0]);
+		wheel_occupied[index / WHEEL_SLOTS] &= ~(1ULL << (index % WHEEL_SLOTS));
+	}
+
+	timer->list = NULL;
+	timer->next = NULL;
+	timer->prev = NULL;
+}
+
+/**
+ * Place a timer into the wheel based on its expiry. Timers that have already
+ * expired get put onto the due list.
+ *
+ * @note Must be called from within a critical section.
+ *
+ * @param timer The timer to insert (must not currently be on a list).
+ */
+static void _wheel_insert(sw_timer_t *timer)
+{
+	uint32_t delta = timer->expiry - (uint32_t)wheel_tick;
+
+	if((int32_t)delta <= 0) {
+		_list_add(&due_list, timer);
+		return;
+	}
+
+	if(delta > WHEEL_MAX_DELTA) {
+		delta = WHEEL_MAX_DELTA;
+	}
+
+	/* Find the lowest level whose range covers the delta. */
+	uint32_t level = 0;
+	while((level < (WHEEL_LEVELS - 1)) && (delta >= (1UL << ((level + 1) * WHEEL_SLOT_BITS)))) {
+		level++;
+	}
+
+	const uint32_t when = (uint32_t)wheel_tick + delta;
+	const uint32_t slot = (when >> (level * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK;
+
+	_list_add(&wheel[level][slot], timer);
+	wheel_occupied[level] |= 1ULL << slot;
+}
+
+/**
+ * Re-insert every timer in a wheel slot. This moves the timers down into the
+ * lower levels as their expiry gets closer.
+ *
+ * @note Must be called from within a critical section.
+ *
+ * @param level The level of the slot to cascade.
+ * @param slot The slot to cascade.
+ */
+static void _cascade(uint32_t level, uint32_t slot)
+{
+	while(wheel[level][slot] != NULL) {
+		sw_timer_t *timer = wheel[level][slot];
+		_list_remove(timer);
+		_wheel_insert(timer);
+	}
+}
+
+/**
+ * Start a timer that expires on the first tick on or after [target_cycles].
+ *
+ * @param timer The timer to start. If it's already active, it gets restarted.
+ * @param target_cycles The absolute cycle count (see get_cycles()) to expire at.
+ * @param period_ticks Number of ticks between expirations (zero for one-shot).
+ */
+static void _start_at(sw_timer_t *timer, uint64_t target_cycles, uint32_t period_ticks)
+{
+	ASSERT(timer != NULL);
+	ASSERT(timer->callback != NULL);
+
+	const uint32_t primask = intr_enter_critical();
+
+	_list_remove(timer);
+
+	timer->expiry = (uint32_t)((target_cycles + SYSTIMER_TICK - 1) / SYSTIMER_TICK);
+	timer->period = period_ticks;
+	_wheel_insert(timer);
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Initialize a software timer. This must be called before any other function
+ * is called on the timer.
+ *
+ * @param timer The timer to initialize.
+ * @param callback Function called every time the timer expires.
+ * @param arg Argument passed to [callback].
+ * @param flags SW_TIMER_FLAG_* values (zero to run the callback in the timer
+ *              task).
+ */
+void sw_timer_init(sw_timer_t *timer, sw_timer_callback_t callback, void *arg, uint32_t flags)
+{
+	ASSERT((timer != NULL) && (callback != NULL));
+
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->list = NULL;
+	timer->expiry = 0;
+	timer->period = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->flags = flags;
+}
+
+/**
+ * Start (or restart) a one-shot timer.
+ *
+ * @note Timers have tick granularity (SYSTIMER_TICK) so the callback will run
+ *       at least [cycles] cycles from now (rounded up to the next tick).
+ *
+ * @param timer The timer to start.
+ * @param cycles Number of CPU cycles from now to expire in.
+ */
+void sw_timer_start(sw_timer_t *timer, uint64_t cycles)
+{
+	_start_at(timer, get_cycles() + cycles, 0);
+}
+
+/**
+ * Start (or restart) a periodic timer. The first expiration occurs one period
+ * from now. Periods don't drift, but if the timer falls behind by more than a
+ * period the missed expirations are skipped.
+ *
+ * @param timer The timer to start.
+ * @param period_cycles Number of CPU cycles between expirations. Rounded up to
+ *                      a multiple of SYSTIMER_TICK.
+ */
+void sw_timer_start_periodic(sw_timer_t *timer, uint64_t period_cycles)
+{
+	const uint64_t period_ticks = (period_cycles + SYSTIMER_TICK - 1) / SYSTIMER_TICK;
+	ASSERT((period_ticks > 0) && (period_ticks <= WHEEL_MAX_DELTA));
+
+	_start_at(timer, get_cycles() + period_cycles, (uint32_t)period_ticks);
+}
+
+/**
+ * Stop a timer. Its callback won't be called again (unless the callback is
+ * currently running, in which case that call will complete).
+ *
+ * @param timer The timer to stop. It's okay if the timer isn't active.
+ */
+void sw_timer_stop(sw_timer_t *timer)
+{
+	ASSERT(timer != NULL);
+
+	const uint32_t primask = intr_enter_critical();
+	_list_remove(timer);
+	timer->period = 0;
+	intr_exit_critical(primask);
+}
+
+/**
+ * @return True if the timer has been started and hasn't expired (or had its
+ *         callback run) yet. Periodic timers are active until stopped.
+ */
+bool sw_timer_is_active(sw_timer_t *timer)
+{
+	ASSERT(timer != NULL);
+
+	return timer->list != NULL;
+}
+
+/* Callback used by sw_timer_sleep_until() to wake the sleeping task back up. */
+static void _wake_task(void *arg)
+{
+	sched_wake((task_t*)arg);
+}
+
+/**
+ * Block the current task until [target_cycles] has been reached. Other tasks
+ * (or the idle task) get to run in the meantime.
+ *
+ * @note Can only be called from tasks (see task_can_block()).
+ *
+ * @param target_cycles The absolute cycle count (see get_cycles()) to sleep
+ *                      until. The task will be woken up on the first tick on
+ *                      or after this time.
+ */
+void sw_timer_sleep_until(uint64_t target_cycles)
+{
+	ASSERT(task_can_block());
+
+	task_t *task = get_current_task();
+	sw_timer_t timer;
+	bool other_wakeup = false;
+
+	sw_timer_init(&timer, _wake_task, task, SW_TIMER_FLAG_ISR);
+	_start_at(&timer, target_cycles, 0);
+
+	while(sw_timer_is_active(&timer)) {
+		sched_block();
+
+		if(sw_timer_is_active(&timer)) {
+			other_wakeup = true;
+		}
+	}
+
+	/**
+	 * Anything else that tried to wake this task while it was sleeping had its
+	 * wakeup consumed above. Pass it along to the next sched_block() call.
+	 */
+	if(other_wakeup) {
+		sched_wake(task);
+	}
+}
+
+/**
+ * Determine when the next timer could expire. Used to figure out how long the
+ * CPU can idle for without missing a timer.
+ *
+ * @note Timers in the upper levels of the wheel are only resolved when they
+ *       cascade down. The returned time may be earlier than the actual next
+ *       expiry, but never later.
+ *
+ * @return The cycle count (see get_cycles()) of the next tick that needs to be
+ *         processed, or UINT64_MAX if no timers are pending.
+ */
+uint64_t sw_timer_next_expiry(void)
+{
+	const uint32_t primask = intr_enter_critical();
+
+	uint64_t next_tick = UINT64_MAX;
+
+	if(due_list != NULL) {
+		next_tick = wheel_tick;
+	} else {
+		const uint32_t index = (uint32_t)wheel_tick & WHEEL_SLOT_MASK;
+
+		/* Distance to the next occupied level 0 slot (rotate it to the front). */
+		const uint64_t occupied = wheel_occupied[0];
+		if(occupied != 0) {
+			const uint32_t shift = (index + 1) & WHEEL_SLOT_MASK;
+			const uint64_t rotated = (shift == 0) ? occupied :
+			                         ((occupied >> shift) | (occupied << (WHEEL_SLOTS - shift)));
+
+			next_tick = wheel_tick + (uint32_t)__builtin_ctzll(rotated) + 1;
+		}
+
+		/* Timers in the upper levels can't expire before the next cascade. */
+		for(uint32_t level = 1; level < WHEEL_LEVELS; ++level) {
+			if(wheel_occupied[level] != 0) {
+				const uint64_t cascade_tick = wheel_tick + (WHEEL_SLOTS - index);
+
+				if(cascade_tick < next_tick) {
+					next_tick = cascade_tick;
+				}
+				break;
+			}
+		}
+	}
+
+	intr_exit_critical(primask);
+
+	return (next_tick == UINT64_MAX) ? UINT64_MAX : (next_tick * SYSTIMER_TICK);
+}
+
+/**
+ * Advance the timing wheel up to the current time, expiring any timers along
+ * the way. This is called by the SysTick interrupt (which might occur less
+ * often than once per tick while the CPU is idling).
+ *
+ * @param now_cycles The current cycle count (see get_cycles()).
+ */
+void sw_timer_advance(uint64_t now_cycles)
+{
+	const uint64_t now_tick = now_cycles / SYSTIMER_TICK;
+	bool wake_timer_task = false;
+
+	uint32_t primask = intr_enter_critical();
+
+	while(wheel_tick < now_tick) {
+		wheel_tick++;
+
+		/**
+		 * Every time a level wraps around, cascade the next slot of the level
+		 * above it (the highest levels first, since they cascade into the lower
+		 * levels).
+		 */
+		uint32_t top_level = 0;
+		while((top_level < (WHEEL_LEVELS - 1)) &&
+		      ((wheel_tick & ((1ULL << ((top_level + 1) * WHEEL_SLOT_BITS)) - 1)) == 0)) {
+			top_level++;
+		}
+
+		for(uint32_t level = top_level; level > 0; --level) {
+			_cascade(level, (uint32_t)(wheel_tick >> (level * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK);
+		}
+
+		/* Everything in the current level 0 slot has expired. */
+		sw_timer_t **slot = &wheel[0][wheel_tick & WHEEL_SLOT_MASK];
+		while(*slot != NULL) {
+			sw_timer_t *timer = *slot;
+			_list_remove(timer);
+			_list_add(&due_list, timer);
+		}
+	}
+
+	while(due_list != NULL) {
+		sw_timer_t *timer = due_list;
+		_list_remove(timer);
+
+		/**
+		 * Figure out when periodic timers expire next. If the timer fell behind
+		 * by more than a period, skip the missed expirations.
+		 */
+		if(timer->period != 0) {
+			timer->expiry += timer->period;
+
+			if((int32_t)(timer->expiry - (uint32_t)wheel_tick) <= 0) {
+				timer->expiry = (uint32_t)wheel_tick + timer->period;
+			}
+		}
+
+		if(timer->flags & SW_TIMER_FLAG_ISR) {
+			/* Re-arm periodic timers before their callback gets a chance to stop them. */
+			if(timer->period != 0) {
+				_wheel_insert(timer);
+			}
+
+			const sw_timer_callback_t callback = timer->callback;
+			void *arg = timer->arg;
+
+			intr_exit_critical(primask);
+			callback(arg);
+			primask = intr_enter_critical();
+		} else {
+			/* The timer task puts periodic timers back into the wheel. */
+			_list_add(&expired_list, timer);
+			wake_timer_task = true;
+		}
+	}
+
+	intr_exit_critical(primask);
+
+	if(wake_timer_task && timer_task_created) {
+		sched_wake(&sw_timer_task);
+	}
+}
+
+/**
+ * The timer task. Runs the callbacks of every expired timer that doesn't have
+ * the SW_TIMER_FLAG_ISR flag set.
+ */
+static void _timer_task(__unused void *param)
+{
+	while(1) {
+		uint32_t primask = intr_enter_critical();
+
+		sw_timer_t *timer = expired_list;
+		sw_timer_callback_t callback = NULL;
+		void *arg = NULL;
+
+		if(timer != NULL) {
+			_list_remove(timer);
+
+			/* Periodic timers go back into the wheel for their next period. */
+			if(timer->period != 0) {
+				_wheel_insert(timer);
+			}
+
+			callback = timer->callback;
+			arg = timer->arg;
+		}
+
+		intr_exit_critical(primask);
+
+		if(callback != NULL) {
+			callback(arg);
+		} else {
+			sched_block();
+		}
+	}
+}
+
+/**
+ * Create the task that runs timer callbacks. This is called by sched_begin().
+ */
+void sw_timer_task_create(void)
+{
+	STATIC_TASK_CREATE(sw_timer, SW_TIMER_TASK_STACK_SIZE, _timer_task, NULL);
+	task_set_priority(&sw_timer_task, SW_TIMER_TASK_PRIORITY);
+	timer_task_created = true;
+
+	/* Catch up on any timers that expired before the task existed. */
+	if(expired_list != NULL) {
+		sched_wake(&sw_timer_task);
+	}
+}
+
+#endif /* ENABLE_SW_TIMERS */
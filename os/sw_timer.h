@@ -0,0 +1,63 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * One-shot and periodic software timers.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Signature for functions called when a software timer expires. */
+typedef void (*sw_timer_callback_t)(void *arg);
+
+/**
+ * Run the callback directly from the SysTick interrupt instead of from the
+ * timer task. Only use this for very short callbacks (e.g., waking up a task).
+ */
+#define SW_TIMER_FLAG_ISR 0x1U
+
+/**
+ * Structure representing a software timer. This should be treated as opaque
+ * and only accessed through the API exposed in this header.
+ */
+typedef struct sw_timer {
+	/* Links in whichever timer list this timer is currently on. */
+	struct sw_timer *next;
+	struct sw_timer *prev;
+
+	/* The head of the list this timer is on (NULL if the timer isn't active). */
+	struct sw_timer **list;
+
+	/* The tick this timer expires on. */
+	uint32_t expiry;
+
+	/* Number of ticks between expirations (zero for one-shot timers). */
+	uint32_t period;
+
+	/* Function to call (and its argument) when the timer expires. */
+	sw_timer_callback_t callback;
+	void *arg;
+
+	/* SW_TIMER_FLAG_* values. */
+	uint32_t flags;
+} sw_timer_t;
+
+#if ENABLE_SW_TIMERS
+void sw_timer_init(sw_timer_t *timer, sw_timer_callback_t callback, void *arg, uint32_t flags);
+
+void sw_timer_start(sw_timer_t *timer, uint64_t cycles);
+void sw_timer_start_periodic(sw_timer_t *timer, uint64_t period_cycles);
+void sw_timer_stop(sw_timer_t *timer);
+bool sw_timer_is_active(sw_timer_t *timer);
+
+void sw_timer_sleep_until(uint64_t target_cycles);
+
+uint64_t sw_timer_next_expiry(void);
+void sw_timer_advance(uint64_t now_cycles);
+
+void sw_timer_task_create(void);
+#endif /* ENABLE_SW_TIMERS */
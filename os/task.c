@@ -7,11 +7,34 @@
 #include "config.h"
 #include "debug.h"
 #include "interrupt.h"
+#include "itm.h"
+#include "mpu.h"
+#include "os/log.h"
+#include "os/sched_trace.h"
+#include "os/sw_timer.h"
 #include "os/task.h"
+#include "os/work_queue.h"
+#include "system_timer.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
+/**
+ * Number of bytes at the bottom of every stack that are reserved for detecting
+ * stack overflows (and therefore can't be used by the task).
+ */
+#if ENABLE_MPU_STACK_GUARD
+#define STACK_RESERVED_BYTES MPU_STACK_GUARD_SIZE
+#elif ENABLE_STACK_GUARD
+#define STACK_RESERVED_BYTES 1U
+#else
+#define STACK_RESERVED_BYTES 0U
+#endif
+
+/* Stack used by the init/idle thread (allocated in the platform code). */
+extern uint8_t init_stack[INIT_THREAD_STACK_SIZE];
+
 /* Pointer to the task structure for the currently running task. */
 static task_t *current_task = NULL;
 
@@ -20,11 +43,31 @@ static task_t idle_task = {
 	/* The current SP will be written by the context switch logic. */
 	.saved_sp = 0,
 	.name = "idle task",
-	.stack_size = INIT_THREAD_STACK_SIZE
+	.stack_size = INIT_THREAD_STACK_SIZE,
+	.stack_mem = (uintptr_t)init_stack,
+	.next = NULL,
+	.id = 0,
+	.priority = TASK_IDLE_PRIORITY,
+	.state = TASK_READY,
+	.wake_pending = false
 };
 
-/* The next task to run. Typically this will be determined by a scheduling algorithm. */
-static task_t *next_task_to_sched = NULL;
+/* The last task in the list of all tasks (the idle task is always first). */
+static task_t *task_list_tail = &idle_task;
+
+/* The ID to give to the next created task. */
+static uint8_t next_task_id = 1;
+
+/* Reason for the context switch that's currently pending. */
+static volatile sched_reason_t switch_reason = SCHED_REASON_PREEMPT;
+
+#if ENABLE_TASK_STATS
+/* Value of the cycle counter when the current task was switched to. */
+static uint32_t last_switch_cycles = 0;
+#endif /* ENABLE_TASK_STATS */
+
+/* Set once sched_begin() has been called. */
+static bool sched_started = false;
 
 /**
  * Return a poiner to the current running task's task structure.
@@ -77,14 +120,35 @@ void task_create(
 	ASSERT((task != NULL) && (task_name != NULL) && (stack_mem != 0));
 	ASSERT(stack_size > MIN_STACK_SIZE);
 
-	/* Ensure the stack has 8-byte alignment. This is an ARM architectural requirement. */
-	ASSERT((stack_mem & 0x7) == 0);
-
-	/* TODO: GET RID OF THIS AFTER REAL SCHED ALGORITHM IS WRITTEN. */
-	next_task_to_sched = task;
+	/**
+	 * Ensure the stack has 8-byte alignment. This is an ARM architectural
+	 * requirement. The MPU stack guard requires an even larger alignment.
+	 */
+	ASSERT((stack_mem & (STACK_ALIGNMENT - 1)) == 0);
 
 	task->name = task_name;
 	task->stack_size = stack_size;
+	task->stack_mem = stack_mem;
+	task->next = NULL;
+	task->id = next_task_id++;
+	task->priority = TASK_DEFAULT_PRIORITY;
+	task->state = TASK_READY;
+	task->wake_pending = false;
+
+#if ENABLE_TASK_STATS
+	task->run_cycles = 0;
+	task->num_switches = 0;
+#endif /* ENABLE_TASK_STATS */
+
+#if ENABLE_STACK_PAINTING
+	/* Paint the entire stack so its high-water mark can be determined later. */
+	memset((void*)stack_mem, STACK_PAINT_VALUE, stack_size);
+#endif /* ENABLE_STACK_PAINTING */
+
+#if ENABLE_STACK_GUARD
+	/* The guard value lives at the very bottom of the stack. */
+	*(uint8_t*)stack_mem = STACK_GUARD_MAGIC;
+#endif /* ENABLE_STACK_GUARD */
 
 	/**
 	 * This structure must match the exact order and alignment that the context
@@ -124,8 +188,6 @@ void task_create(
 	initial_task_state_t *state = (initial_task_state_t*)stack_mem;
 	memset((void*)state, 0, sizeof(initial_task_state_t));
 
-	/* TODO: Set up stack guard value. */
-
 	/**
 	 * This is the exception return code to set LR to that tells the exception
 	 * return hardware what mode and stack to switch to when returning. This
@@ -142,7 +204,156 @@ void task_create(
 
 	/* The "Thumb" bit HAS to be set in xPSR for all armv7-M code. */
 	state->psr = 0x1000000;
+
+	/**
+	 * Now that the task is fully setup, add it to the task list which makes it
+	 * visible to the scheduler.
+	 */
+	const uint32_t primask = intr_enter_critical();
+	task_list_tail->next = task;
+	task_list_tail = task;
+	intr_exit_critical(primask);
+}
+
+/**
+ * Change the priority of a task. Higher numbers are more urgent. Tasks start
+ * out with TASK_DEFAULT_PRIORITY.
+ *
+ * @note The new priority will be taken into account at the next context switch.
+ *
+ * @param task The task to modify (can't be the idle task).
+ * @param priority The new priority. Must be higher than TASK_IDLE_PRIORITY.
+ */
+void task_set_priority(task_t *task, uint8_t priority)
+{
+	ASSERT((task != NULL) && (task != &idle_task));
+	ASSERT(priority > TASK_IDLE_PRIORITY);
+
+	task->priority = priority;
+}
+
+#if ENABLE_STACK_GUARD
+/**
+ * Die if a task's stack has overflowed. This is called by the context switch
+ * logic on every task being switched out.
+ *
+ * An overflow is detected if the saved stack pointer has gone below the
+ * reserved area at the bottom of the stack, or if the guard value was
+ * clobbered (e.g., by a large local array that was only partially written).
+ *
+ * @param task The task to check.
+ */
+void task_check_stack_guard(task_t *task)
+{
+	ASSERT(task != NULL);
+
+	if((task->saved_sp < (task->stack_mem + STACK_RESERVED_BYTES)) ||
+	   (*(uint8_t*)task->stack_mem != STACK_GUARD_MAGIC)) {
+		ABORT("Task \"%s\" overflowed its %u byte stack.\n",
+		      task->name,
+		      task->stack_size);
+	}
+}
+#endif /* ENABLE_STACK_GUARD */
+
+#if ENABLE_STACK_PAINTING
+/**
+ * Determine the most stack a task has ever used (the high-water mark). This is
+ * found by searching upwards from the bottom of the stack for the first byte
+ * that no longer contains the paint value.
+ *
+ * @note Stack memory that was reserved (e.g., a local array) but never written
+ *       to won't be counted, so leave a bit of margin when sizing stacks.
+ *
+ * @param task The task to check.
+ *
+ * @return The high-water mark in bytes, including the reserved guard bytes.
+ */
+size_t task_get_stack_high_water(task_t *task)
+{
+	ASSERT(task != NULL);
+
+	const uint8_t *stack = (const uint8_t*)task->stack_mem;
+	size_t unused = STACK_RESERVED_BYTES;
+
+	while((unused < task->stack_size) && (stack[unused] == STACK_PAINT_VALUE)) {
+		unused++;
+	}
+
+	return task->stack_size - (unused - STACK_RESERVED_BYTES);
+}
+#endif /* ENABLE_STACK_PAINTING */
+
+#if ENABLE_TASK_STATS
+/**
+ * Charge the CPU time since the last context switch to the task being switched
+ * out, and record the switch.
+ *
+ * @note Called from the context switch handler.
+ *
+ * @param prev_task The task being switched out.
+ * @param next_task The task being switched to.
+ * @param reason Why the switch is occurring.
+ */
+static void _account_switch(task_t *prev_task, task_t *next_task, sched_reason_t reason)
+{
+	const uint32_t now = get_cycle_counter();
+
+	/* Unsigned subtraction handles the counter wrapping around. */
+	prev_task->run_cycles += now - last_switch_cycles;
+	last_switch_cycles = now;
+
+	if(prev_task != next_task) {
+		next_task->num_switches++;
+
+#if ENABLE_SCHED_TRACE
+		sched_trace_record(now, prev_task->id, next_task->id, reason);
+#else
+		(void)reason;
+#endif /* ENABLE_SCHED_TRACE */
+	}
+}
+
+/**
+ * Print out how much CPU time every task has used, how many times each task has
+ * been switched to, and (if stack painting is enabled) each task's stack
+ * high-water mark.
+ *
+ * @note The time the CPU has spent asleep isn't counted towards any task.
+ */
+void task_dump_stats(void)
+{
+	uint64_t total_cycles = 0;
+	for(task_t *task = &idle_task; task != NULL; task = task->next) {
+		total_cycles += task->run_cycles;
+	}
+
+	if(total_cycles == 0) {
+		total_cycles = 1;
+	}
+
+	dbprintf("ID  Name              Run(ms)  CPU(%%)  Switches\n");
+	for(task_t *task = &idle_task; task != NULL; task = task->next) {
+		/* newlib-nano can't print 64-bit values, so print in milliseconds. */
+		__unused const unsigned long run_ms = (unsigned long)(task->run_cycles / (CPU_HZ / 1000U));
+		__unused const unsigned long permille = (unsigned long)((task->run_cycles * 1000U) / total_cycles);
+
+		dbprintf("%-3u %-16s %8lu  %3lu.%lu  %8lu\n",
+		         task->id,
+		         task->name,
+		         run_ms,
+		         permille / 10,
+		         permille % 10,
+		         task->num_switches);
+
+#if ENABLE_STACK_PAINTING
+		dbprintf("    Stack: %u/%u bytes used\n",
+		         task_get_stack_high_water(task),
+		         task->stack_size);
+#endif /* ENABLE_STACK_PAINTING */
+	}
 }
+#endif /* ENABLE_TASK_STATS */
 
 /**
  * Context switch logic that can be registered as the PendSV handler. From that
@@ -187,7 +398,11 @@ static void cswitch_handler(void)
 		/* Store the current process stack pointer in the current task structure. */
 		"str	r0, [r1] \n"
 
-		/* TODO: Check the stack guard value and die() if it's been clobbered. */
+#if ENABLE_STACK_GUARD
+		/* Die if the task being switched out overflowed its stack. */
+		"mov	r0, r1 \n"
+		"bl		task_check_stack_guard \n"
+#endif /* ENABLE_STACK_GUARD */
 
 		/* Determine the next task to run. Task pointer returned through r0. */
 		"bl		sched_get_next_task \n"
@@ -222,8 +437,45 @@ void sched_begin(void)
 	extern void cswitch_handler(void);
 	intr_register_pendsv(&cswitch_handler, LOWEST_INTR_PRIORITY);
 
+#if ENABLE_SW_TIMERS
+	sw_timer_task_create();
+#endif /* ENABLE_SW_TIMERS */
+
+#if ENABLE_WORK_QUEUE
+	work_queue_task_create();
+#endif /* ENABLE_WORK_QUEUE */
+
+#if ENABLE_LOG_RING
+	log_task_create();
+#endif /* ENABLE_LOG_RING */
+
 	/* Use the current thread as the Idle thread going forwards. */
 	current_task = &idle_task;
+	sched_started = true;
+
+#if ENABLE_TASK_STATS
+	last_switch_cycles = get_cycle_counter();
+#endif /* ENABLE_TASK_STATS */
+
+#if ENABLE_STACK_PAINTING
+	/**
+	 * The idle task's stack has been in use since boot. Everything below the
+	 * current stack pointer is unused (interrupts use the Main stack), so paint
+	 * that part of the stack. A volatile pointer ensures the compiler doesn't
+	 * turn this into a memset() call which would use the stack being painted.
+	 */
+	uintptr_t sp;
+	asm volatile("mov %0, sp" : "=r" (sp));
+
+	for(volatile uint8_t *addr = init_stack + STACK_RESERVED_BYTES; (uintptr_t)addr < sp; ++addr) {
+		*addr = STACK_PAINT_VALUE;
+	}
+#endif /* ENABLE_STACK_PAINTING */
+
+#if ENABLE_MPU_STACK_GUARD
+	mpu_set_guard_region(MPU_STACK_GUARD_REGION, idle_task.stack_mem, MPU_STACK_GUARD_SIZE);
+	mpu_enable();
+#endif /* ENABLE_MPU_STACK_GUARD */
 
 	/* Switch to the highest priority runnable task. */
 	sched_yield();
@@ -238,36 +490,125 @@ void sched_begin(void)
 /**
  * Return back the next task that should be run on the CPU and set the current
  * task to that task.
+ *
+ * The highest priority task that isn't blocked gets chosen. Tasks of the same
+ * priority are run round-robin (the search starts after the current task). The
+ * idle task never blocks, so there's always a task to run.
  */
 task_t * sched_get_next_task(void)
 {
-	static unsigned int num_switches = 0;
+	/* Prevent ISRs from waking up tasks partway through making a decision. */
+	const uint32_t primask = intr_enter_critical();
+
+	task_t *next_task = &idle_task;
+	task_t *task = current_task;
+
+	do {
+		task = (task->next != NULL) ? task->next : &idle_task;
+
+		if((task->state == TASK_READY) && (task->priority > next_task->priority)) {
+			next_task = task;
+		}
+	} while(task != current_task);
 
-	if(++num_switches == 5) {
-		num_switches = 0;
-		next_task_to_sched = &idle_task;
+#if ENABLE_TASK_STATS
+	_account_switch(current_task, next_task, switch_reason);
+#endif /* ENABLE_TASK_STATS */
+
+#if ENABLE_ITM
+	if(next_task != current_task) {
+		itm_sched_event(current_task->id, next_task->id, switch_reason);
 	}
+#endif /* ENABLE_ITM */
+
+	switch_reason = SCHED_REASON_PREEMPT;
+	current_task = next_task;
 
-	current_task = next_task_to_sched;
+	intr_exit_critical(primask);
 
-	return next_task_to_sched;
+#if ENABLE_MPU_STACK_GUARD
+	/* Only the stack of the task that's about to run needs to be guarded. */
+	mpu_set_guard_region(MPU_STACK_GUARD_REGION, current_task->stack_mem, MPU_STACK_GUARD_SIZE);
+#endif /* ENABLE_MPU_STACK_GUARD */
+
+	return next_task;
 }
 
 /**
- * Dummy function used until a real scheduler is built.
+ * Yield the current thread to the next highest priority runnable thread.
+ */
+void sched_yield(void)
+{
+	switch_reason = SCHED_REASON_YIELD;
+	intr_trigger_pendsv();
+}
+
+/**
+ * @return True if the caller is allowed to call sched_block(). Only tasks other
+ *         than the idle task can block, and only after the scheduler started.
+ */
+bool task_can_block(void)
+{
+	return sched_started && (current_task != &idle_task) && !intr_in_isr();
+}
+
+/**
+ * Block the current task until another task or an ISR calls sched_wake() on it.
+ *
+ * If the task was woken up since the last time it blocked, this returns
+ * immediately. This prevents losing a wakeup that happened between checking
+ * for some condition and blocking on it. Callers should re-check whatever
+ * condition they were waiting on after this returns.
  *
- * TODO: Get rid of this.
+ * @note Can only be called from tasks (see task_can_block()).
  */
-void set_next_task(task_t *task)
+void sched_block(void)
 {
-	ASSERT(task != NULL);
-	next_task_to_sched = task;
+	ASSERT(task_can_block());
+
+	intr_disable_interrupts();
+
+	while(!current_task->wake_pending) {
+		current_task->state = TASK_BLOCKED;
+		switch_reason = SCHED_REASON_BLOCK;
+		intr_trigger_pendsv();
+
+		/* The context switch occurs as soon as interrupts get enabled. */
+		intr_enable_interrupts();
+		intr_disable_interrupts();
+	}
+
+	current_task->wake_pending = false;
+
+	intr_enable_interrupts();
 }
 
 /**
- * Yield the current thread to the next highest priority runnable thread.
+ * Make a task runnable again after it blocked with sched_block(). If the task
+ * isn't currently blocked, its next call to sched_block() will return
+ * immediately instead. If the woken task has a higher priority than the
+ * current task, a context switch will occur as soon as possible.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param task The task to wake up.
  */
-void sched_yield(void)
+void sched_wake(task_t *task)
 {
-	intr_trigger_pendsv();
+	ASSERT(task != NULL);
+
+	const uint32_t primask = intr_enter_critical();
+
+	task->wake_pending = true;
+
+	if(task->state == TASK_BLOCKED) {
+		task->state = TASK_READY;
+
+		if(sched_started && (task->priority > current_task->priority)) {
+			switch_reason = SCHED_REASON_WAKEUP;
+			intr_trigger_pendsv();
+		}
+	}
+
+	intr_exit_critical(primask);
 }
@@ -6,13 +6,32 @@
  */
 #pragma once
 
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/**
+ * Task priorities. Higher numbers are more urgent. Only the idle task can run
+ * at TASK_IDLE_PRIORITY, and TASK_LOWEST_PRIORITY is left below
+ * TASK_DEFAULT_PRIORITY for background work (like draining the log ring).
+ */
+#define TASK_IDLE_PRIORITY 0U
+#define TASK_LOWEST_PRIORITY 1U
+#define TASK_DEFAULT_PRIORITY 2U
+
+/* Whether a task can be chosen to run by the scheduler. */
+typedef enum {
+	TASK_READY = 0,
+	TASK_BLOCKED = 1
+} task_state_t;
+
 /**
  * Structure representing a task. Tasks should not access this structure
  * directly but instead go through the API exposed in this header.
  */
-typedef struct {
+typedef struct task {
 	/**
 	 * During context switches, this is where the task's latest stack pointer
 	 * will be saved off. Every other register will be saved onto the stack
@@ -27,8 +46,45 @@ typedef struct {
 
 	/* Size of the stack in bytes. */
 	size_t stack_size;
+
+	/* Address of the bottom of the stack (the lowest address). */
+	uintptr_t stack_mem;
+
+	/* Next task in the list of every task that's been created. */
+	struct task *next;
+
+	/* Unique ID given to every task at creation (the idle task is always 0). */
+	uint8_t id;
+
+	/* Scheduling priority (higher numbers are more urgent). */
+	uint8_t priority;
+
+	/* Whether the task is runnable or waiting on a call to sched_wake(). */
+	volatile task_state_t state;
+
+	/* Set by sched_wake() and consumed by sched_block(). */
+	volatile bool wake_pending;
+
+#if ENABLE_TASK_STATS
+	/**
+	 * Total number of CPU cycles this task has spent running (as measured by
+	 * the DWT cycle counter, so time the CPU spent sleeping isn't counted).
+	 */
+	uint64_t run_cycles;
+
+	/* Number of times this task has been switched to. */
+	uint32_t num_switches;
+#endif /* ENABLE_TASK_STATS */
 } task_t;
 
+/* Why a context switch occurred. Recorded in the scheduler trace. */
+typedef enum {
+	SCHED_REASON_PREEMPT = 0,
+	SCHED_REASON_YIELD = 1,
+	SCHED_REASON_BLOCK = 2,
+	SCHED_REASON_WAKEUP = 3
+} sched_reason_t;
+
 task_t * get_current_task(void);
 
 void task_create(
@@ -39,17 +95,32 @@ void task_create(
 	void *entry_point,
 	void *param);
 
+void task_set_priority(task_t *task, uint8_t priority);
+
+#if ENABLE_STACK_GUARD
+void task_check_stack_guard(task_t *task);
+#endif /* ENABLE_STACK_GUARD */
+
+#if ENABLE_STACK_PAINTING
+size_t task_get_stack_high_water(task_t *task);
+#endif /* ENABLE_STACK_PAINTING */
+
+#if ENABLE_TASK_STATS
+void task_dump_stats(void);
+#endif /* ENABLE_TASK_STATS */
+
 /**
  * Helper macro for statically allocating a task structure and its stack. It's
  * anticipated that this macro will be used at the global scope so the task and
  * stack is allocated out of the DATA section.
  *
  * @note This macro also forces the stack to 8-byte alignment which is required
- *       according to the ARM procedure call standard.
+ *       according to the ARM procedure call standard (or to the MPU guard
+ *       region size if ENABLE_MPU_STACK_GUARD is set).
  */
 #define STATIC_TASK_ALLOC(task_name, stack_size) \
 	task_t task_name ##_task; \
-	uint8_t task_name ## _stack[(stack_size)] __attribute__ ((aligned (8))) = { 0 }
+	uint8_t task_name ## _stack[(stack_size)] __attribute__ ((aligned (STACK_ALIGNMENT))) = { 0 }
 
 /**
  * Wrapper around task_create() that is meant to be used with an associated call
@@ -67,6 +138,9 @@ void task_create(
 
 void sched_begin(void);
 task_t * sched_get_next_task(void);
-void set_next_task(task_t *task);
 
 void sched_yield(void);
+
+bool task_can_block(void);
+void sched_block(void);
+void sched_wake(task_t *task);
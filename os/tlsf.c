@@ -0,0 +1,636 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Two-Level Segregated Fit (TLSF) heap allocator.
+ *
+ * Free blocks are sorted into size classes using a two-level index. The first
+ * level splits sizes into powers of two, and the second level splits each of
+ * those ranges into SL_INDEX_COUNT equally sized classes. A bitmap for each
+ * level tracks which classes have free blocks in them, so finding a free block
+ * that's big enough only takes a couple of count-leading/trailing-zero
+ * instructions. Together with immediate coalescing of neighboring free blocks,
+ * this makes both allocating and freeing O(1), which keeps the worst-case
+ * execution time of the allocator bounded (unlike newlib's malloc()).
+ *
+ * Every block (used or free) starts with a header containing its size and a
+ * pointer to the block physically before it. Free blocks also store the links
+ * for their free list in what would otherwise be the allocation's payload. The
+ * end of each heap is marked with a zero-sized "sentinel" block that is always
+ * in use, so merging never has to check whether it hit the end of the heap.
+ *
+ * The allocator itself doesn't do any locking. See mem_alloc.c for a
+ * thread-safe wrapper.
+ */
+#include "config.h"
+#include "debug.h"
+#include "os/tlsf.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of second-level classes per first-level class (as a power of two). */
+#define SL_INDEX_COUNT_LOG2 4U
+#define SL_INDEX_COUNT (1U << SL_INDEX_COUNT_LOG2)
+
+#define ALIGN_SIZE_LOG2 3U
+
+/**
+ * Blocks smaller than SMALL_BLOCK_SIZE all go into first-level class zero,
+ * which is linearly split into SL_INDEX_COUNT classes. Blocks have to be
+ * smaller than (1 << FL_INDEX_MAX) bytes (16MB).
+ */
+#define FL_INDEX_MAX 24U
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1U)
+#define SMALL_BLOCK_SIZE (1U << FL_INDEX_SHIFT)
+
+#define BLOCK_SIZE_MAX (1U << FL_INDEX_MAX)
+
+/* Set in a block's size field when the block is free. */
+#define BLOCK_FREE_BIT 0x1U
+#define BLOCK_FLAGS_MASK (TLSF_ALIGNMENT - 1U)
+
+/**
+ * Header at the start of every block. The free list links are only valid
+ * while the block is free (otherwise they're part of the user's allocation).
+ */
+typedef struct block {
+	/* The block directly before this one in memory (NULL for the first block). */
+	struct block *prev_phys;
+
+	/* Total size of this block (including this header) plus BLOCK_FREE_BIT. */
+	size_t size;
+
+	/* Links in the free list for this block's size class. */
+	struct block *next_free;
+	struct block *prev_free;
+} block_t;
+
+/* The part of the header that is always in use (allocations start after it). */
+#define BLOCK_HEADER_SIZE (offsetof(block_t, next_free))
+
+/* Free blocks need enough room to store the whole header. */
+#define BLOCK_SIZE_MIN (sizeof(block_t))
+
+_Static_assert((BLOCK_HEADER_SIZE % TLSF_ALIGNMENT) == 0, "TLSF header breaks alignment");
+_Static_assert((BLOCK_SIZE_MIN % TLSF_ALIGNMENT) == 0, "TLSF minimum block breaks alignment");
+_Static_assert((1U << ALIGN_SIZE_LOG2) == TLSF_ALIGNMENT, "ALIGN_SIZE_LOG2 doesn't match");
+
+/* Heap bookkeeping data (stored at the start of the heap's memory). */
+struct tlsf {
+	/* Bitmaps of which first and second-level classes have free blocks. */
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[FL_INDEX_COUNT];
+
+	/* Heads of the free lists for each size class. */
+	block_t *blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+	/* The first block in the heap and the sentinel block at the end of it. */
+	block_t *first;
+	block_t *sentinel;
+
+	/* Statistics. */
+	size_t total_bytes;
+	size_t used_bytes;
+	size_t peak_bytes;
+	uint32_t num_allocs;
+};
+
+static inline size_t _align_up(size_t x, size_t align)
+{
+	return (x + align - 1U) & ~(align - 1U);
+}
+
+static inline size_t _block_size(const block_t *block)
+{
+	return block->size & ~BLOCK_FLAGS_MASK;
+}
+
+static inline bool _block_is_free(const block_t *block)
+{
+	return (block->size & BLOCK_FREE_BIT) != 0;
+}
+
+static inline block_t * _block_next(const block_t *block)
+{
+	return (block_t*)((uintptr_t)block + _block_size(block));
+}
+
+static inline void * _block_to_ptr(const block_t *block)
+{
+	return (void*)((uintptr_t)block + BLOCK_HEADER_SIZE);
+}
+
+static inline block_t * _ptr_to_block(const void *ptr)
+{
+	return (block_t*)((uintptr_t)ptr - BLOCK_HEADER_SIZE);
+}
+
+/**
+ * @return The index of the most significant set bit in a non-zero value.
+ */
+static inline uint32_t _fls(size_t x)
+{
+	return (uint32_t)((sizeof(unsigned long) * 8U) - 1U - (size_t)__builtin_clzl(x));
+}
+
+/**
+ * Compute the size class a block of a specific size belongs to.
+ *
+ * @param size The block size to map.
+ * @param fl Set to the first-level index.
+ * @param sl Set to the second-level index.
+ */
+static void _mapping_insert(size_t size, uint32_t *fl, uint32_t *sl)
+{
+	if(size < SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	} else {
+		const uint32_t msb = _fls(size);
+		*sl = (size >> (msb - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		*fl = msb - (FL_INDEX_SHIFT - 1U);
+	}
+}
+
+/**
+ * Add a block to the free list for its size class and mark it as free.
+ */
+static void _insert_free(tlsf_t *heap, block_t *block)
+{
+	uint32_t fl, sl;
+	_mapping_insert(_block_size(block), &fl, &sl);
+
+	block_t *const head = heap->blocks[fl][sl];
+
+	block->size |= BLOCK_FREE_BIT;
+	block->next_free = head;
+	block->prev_free = NULL;
+
+	if(head != NULL) {
+		head->prev_free = block;
+	}
+
+	heap->blocks[fl][sl] = block;
+	heap->fl_bitmap |= (1U << fl);
+	heap->sl_bitmap[fl] |= (1U << sl);
+}
+
+/**
+ * Remove a block from its free list and mark it as used.
+ */
+static void _remove_free(tlsf_t *heap, block_t *block)
+{
+	uint32_t fl, sl;
+	_mapping_insert(_block_size(block), &fl, &sl);
+
+	if(block->next_free != NULL) {
+		block->next_free->prev_free = block->prev_free;
+	}
+
+	if(block->prev_free != NULL) {
+		block->prev_free->next_free = block->next_free;
+	} else {
+		heap->blocks[fl][sl] = block->next_free;
+
+		if(block->next_free == NULL) {
+			heap->sl_bitmap[fl] &= ~(1U << sl);
+
+			if(heap->sl_bitmap[fl] == 0) {
+				heap->fl_bitmap &= ~(1U << fl);
+			}
+		}
+	}
+
+	block->size &= ~BLOCK_FREE_BIT;
+}
+
+/**
+ * Find a free block that is at least "size" bytes large. The block is left on
+ * its free list.
+ *
+ * @return The free block or NULL if there isn't one big enough.
+ */
+static block_t * _find_free(tlsf_t *heap, size_t size)
+{
+	/**
+	 * Round the size up to the next size class so that any block in the class
+	 * found is guaranteed to be big enough.
+	 */
+	if(size >= SMALL_BLOCK_SIZE) {
+		size += (1U << (_fls(size) - SL_INDEX_COUNT_LOG2)) - 1U;
+	}
+
+	uint32_t fl, sl;
+	_mapping_insert(size, &fl, &sl);
+
+	if(fl >= FL_INDEX_COUNT) {
+		return NULL;
+	}
+
+	uint32_t sl_map = heap->sl_bitmap[fl] & (~0U << sl);
+
+	if(sl_map == 0) {
+		/* Nothing in this first-level class, move up to a larger one. */
+		const uint32_t fl_map = heap->fl_bitmap & (~0U << (fl + 1U));
+
+		if(fl_map == 0) {
+			return NULL;
+		}
+
+		fl = (uint32_t)__builtin_ctz(fl_map);
+		sl_map = heap->sl_bitmap[fl];
+	}
+
+	sl = (uint32_t)__builtin_ctz(sl_map);
+
+	return heap->blocks[fl][sl];
+}
+
+/**
+ * Shrink a used block down to "size" bytes and put the leftover space back
+ * into the heap (if it's big enough to be a block on its own).
+ */
+static void _trim(tlsf_t *heap, block_t *block, size_t size)
+{
+	const size_t block_size = _block_size(block);
+
+	if(block_size - size >= BLOCK_SIZE_MIN) {
+		block_t *const remaining = (block_t*)((uintptr_t)block + size);
+		remaining->prev_phys = block;
+		remaining->size = block_size - size;
+		_block_next(remaining)->prev_phys = remaining;
+
+		block->size = size;
+
+		/* The block after a previously free block is always in use. */
+		_insert_free(heap, remaining);
+	}
+}
+
+/**
+ * Merge a block that's about to be freed with any free neighbors.
+ *
+ * @return The merged block (not on any free list yet).
+ */
+static block_t * _merge(tlsf_t *heap, block_t *block)
+{
+	block_t *const prev = block->prev_phys;
+
+	if((prev != NULL) && _block_is_free(prev)) {
+		_remove_free(heap, prev);
+		prev->size += _block_size(block);
+		block = prev;
+		_block_next(block)->prev_phys = block;
+	}
+
+	block_t *const next = _block_next(block);
+
+	if(_block_is_free(next)) {
+		_remove_free(heap, next);
+		block->size += _block_size(next);
+		_block_next(block)->prev_phys = block;
+	}
+
+	return block;
+}
+
+/**
+ * Update the heap statistics after a block gets handed out.
+ */
+static void _account_alloc(tlsf_t *heap, const block_t *block)
+{
+	heap->used_bytes += _block_size(block);
+	heap->num_allocs++;
+
+	if(heap->used_bytes > heap->peak_bytes) {
+		heap->peak_bytes = heap->used_bytes;
+	}
+}
+
+/**
+ * Convert a requested allocation size into a block size.
+ *
+ * @return The block size, or zero if the request can never be satisfied.
+ */
+static size_t _adjust_size(size_t size)
+{
+	if((size == 0) || (size >= BLOCK_SIZE_MAX - BLOCK_HEADER_SIZE - TLSF_ALIGNMENT)) {
+		return 0;
+	}
+
+	const size_t block_size = _align_up(size + BLOCK_HEADER_SIZE, TLSF_ALIGNMENT);
+
+	return (block_size < BLOCK_SIZE_MIN) ? BLOCK_SIZE_MIN : block_size;
+}
+
+/**
+ * Create a heap that manages a region of memory. The heap's bookkeeping data
+ * (about 1.2KB) is placed at the start of the region.
+ *
+ * @param mem Start of the memory region.
+ * @param size Size of the memory region in bytes. Only the first 16MB of a
+ *             region can be used.
+ *
+ * @return A handle to the heap, or NULL if the region is too small.
+ */
+tlsf_t * tlsf_create(void *mem, size_t size)
+{
+	ASSERT(mem != NULL);
+
+	const uintptr_t start = _align_up((uintptr_t)mem, TLSF_ALIGNMENT);
+	const uintptr_t end = ((uintptr_t)mem + size) & ~(uintptr_t)(TLSF_ALIGNMENT - 1U);
+	const uintptr_t pool = _align_up(start + sizeof(tlsf_t), TLSF_ALIGNMENT);
+
+	if((end < pool) || ((end - pool) < (BLOCK_SIZE_MIN + BLOCK_HEADER_SIZE))) {
+		return NULL;
+	}
+
+	size_t block_size = end - pool - BLOCK_HEADER_SIZE;
+	if(block_size >= BLOCK_SIZE_MAX) {
+		block_size = BLOCK_SIZE_MAX - TLSF_ALIGNMENT;
+	}
+
+	tlsf_t *const heap = (tlsf_t*)start;
+
+	heap->fl_bitmap = 0;
+	for(uint32_t fl = 0; fl < FL_INDEX_COUNT; fl++) {
+		heap->sl_bitmap[fl] = 0;
+
+		for(uint32_t sl = 0; sl < SL_INDEX_COUNT; sl++) {
+			heap->blocks[fl][sl] = NULL;
+		}
+	}
+
+	heap->first = (block_t*)pool;
+	heap->first->prev_phys = NULL;
+	heap->first->size = block_size;
+
+	heap->sentinel = _block_next(heap->first);
+	heap->sentinel->prev_phys = heap->first;
+	heap->sentinel->size = 0;
+
+	heap->total_bytes = block_size;
+	heap->used_bytes = 0;
+	heap->peak_bytes = 0;
+	heap->num_allocs = 0;
+
+	_insert_free(heap, heap->first);
+
+	return heap;
+}
+
+/**
+ * Allocate memory from a heap.
+ *
+ * @param heap The heap to allocate from.
+ * @param size Number of bytes to allocate.
+ *
+ * @return Pointer to the allocated memory (aligned to TLSF_ALIGNMENT), or NULL
+ *         if the heap doesn't have a big enough free block.
+ */
+void * tlsf_malloc(tlsf_t *heap, size_t size)
+{
+	ASSERT(heap != NULL);
+
+	const size_t block_size = _adjust_size(size);
+	if(block_size == 0) {
+		return NULL;
+	}
+
+	block_t *const block = _find_free(heap, block_size);
+	if(block == NULL) {
+		return NULL;
+	}
+
+	_remove_free(heap, block);
+	_trim(heap, block, block_size);
+
+	_account_alloc(heap, block);
+
+	return _block_to_ptr(block);
+}
+
+/**
+ * Allocate memory from a heap with a specific alignment.
+ *
+ * @param heap The heap to allocate from.
+ * @param align Alignment of the allocation. Must be a power of two.
+ * @param size Number of bytes to allocate.
+ *
+ * @return Pointer to the allocated memory, or NULL if the heap doesn't have a
+ *         big enough free block.
+ */
+void * tlsf_memalign(tlsf_t *heap, size_t align, size_t size)
+{
+	ASSERT(heap != NULL);
+	ASSERT((align != 0) && ((align & (align - 1U)) == 0));
+
+	if(align <= TLSF_ALIGNMENT) {
+		return tlsf_malloc(heap, size);
+	}
+
+	const size_t block_size = _adjust_size(size);
+	if((block_size == 0) || (align >= BLOCK_SIZE_MAX)) {
+		return NULL;
+	}
+
+	/**
+	 * Leave enough room to skip ahead to an aligned address. The gap in front
+	 * has to be big enough to become a free block of its own.
+	 */
+	const size_t search_size = block_size + align + BLOCK_SIZE_MIN;
+	if(search_size >= BLOCK_SIZE_MAX) {
+		return NULL;
+	}
+
+	block_t *block = _find_free(heap, search_size);
+	if(block == NULL) {
+		return NULL;
+	}
+
+	_remove_free(heap, block);
+
+	const uintptr_t ptr = (uintptr_t)_block_to_ptr(block);
+	uintptr_t aligned = _align_up(ptr, align);
+
+	if((aligned != ptr) && ((aligned - ptr) < BLOCK_SIZE_MIN)) {
+		aligned = _align_up(ptr + BLOCK_SIZE_MIN, align);
+	}
+
+	const size_t gap = aligned - ptr;
+
+	if(gap != 0) {
+		/* Split the gap off into its own free block. */
+		block_t *const aligned_block = _ptr_to_block((void*)aligned);
+		aligned_block->prev_phys = block;
+		aligned_block->size = _block_size(block) - gap;
+		_block_next(aligned_block)->prev_phys = aligned_block;
+
+		block->size = gap;
+		_insert_free(heap, block);
+
+		block = aligned_block;
+	}
+
+	_trim(heap, block, block_size);
+
+	_account_alloc(heap, block);
+
+	return _block_to_ptr(block);
+}
+
+/**
+ * Return memory back to the heap it was allocated from.
+ *
+ * @param heap The heap the memory was allocated from.
+ * @param ptr The memory to free. Cannot be NULL.
+ */
+void tlsf_free(tlsf_t *heap, void *ptr)
+{
+	ASSERT(heap != NULL);
+	ASSERT(tlsf_owns(heap, ptr));
+
+	block_t *block = _ptr_to_block(ptr);
+	ASSERT(!_block_is_free(block));
+
+	heap->used_bytes -= _block_size(block);
+	heap->num_allocs--;
+
+	block = _merge(heap, block);
+	_insert_free(heap, block);
+}
+
+/**
+ * @return The number of usable bytes in an allocation (which can be larger
+ *         than the size originally requested).
+ */
+size_t tlsf_block_size(void *ptr)
+{
+	ASSERT(ptr != NULL);
+
+	return _block_size(_ptr_to_block(ptr)) - BLOCK_HEADER_SIZE;
+}
+
+/**
+ * @return True if a pointer falls within the memory managed by a heap.
+ */
+bool tlsf_owns(tlsf_t *heap, void *ptr)
+{
+	ASSERT(heap != NULL);
+
+	return ((uintptr_t)ptr >= (uintptr_t)_block_to_ptr(heap->first)) &&
+	       ((uintptr_t)ptr < (uintptr_t)heap->sentinel);
+}
+
+/**
+ * Get a snapshot of a heap's usage statistics.
+ *
+ * @param heap The heap to query.
+ * @param stats Filled in with the heap's statistics.
+ */
+void tlsf_get_stats(tlsf_t *heap, tlsf_stats_t *stats)
+{
+	ASSERT(heap != NULL);
+	ASSERT(stats != NULL);
+
+	stats->total_bytes = heap->total_bytes;
+	stats->used_bytes = heap->used_bytes;
+	stats->peak_bytes = heap->peak_bytes;
+	stats->num_allocs = heap->num_allocs;
+	stats->largest_free = 0;
+
+	/**
+	 * Allocations are rounded up to the next size class before searching, so
+	 * only a request that fits the start of the highest non-empty class is
+	 * guaranteed to find a block (even if the largest block is bigger).
+	 */
+	if(heap->fl_bitmap != 0) {
+		const uint32_t fl = _fls(heap->fl_bitmap);
+		const uint32_t sl = _fls(heap->sl_bitmap[fl]);
+		const size_t class_size = (fl == 0) ?
+			(sl * (SMALL_BLOCK_SIZE / SL_INDEX_COUNT)) :
+			((size_t)(SL_INDEX_COUNT + sl) << (fl + FL_INDEX_SHIFT - 1U - SL_INDEX_COUNT_LOG2));
+
+		if(class_size > BLOCK_HEADER_SIZE) {
+			stats->largest_free = class_size - BLOCK_HEADER_SIZE;
+		}
+	}
+}
+
+/**
+ * Walk every block in a heap and verify all of the heap's bookkeeping data.
+ * This takes time proportional to the number of blocks and is only meant for
+ * debugging heap corruption.
+ *
+ * @return True if the heap is consistent.
+ */
+bool tlsf_check(tlsf_t *heap)
+{
+	ASSERT(heap != NULL);
+
+	size_t used_bytes = 0;
+	size_t free_bytes = 0;
+	uint32_t num_allocs = 0;
+	block_t *prev = NULL;
+
+	for(block_t *block = heap->first; block != heap->sentinel; block = _block_next(block)) {
+		const size_t size = _block_size(block);
+
+		if((block->prev_phys != prev) || (size < BLOCK_SIZE_MIN) ||
+		   ((uintptr_t)block + size > (uintptr_t)heap->sentinel)) {
+			return false;
+		}
+
+		if(_block_is_free(block)) {
+			/* Free blocks are always merged with their free neighbors. */
+			if((prev != NULL) && _block_is_free(prev)) {
+				return false;
+			}
+
+			uint32_t fl, sl;
+			_mapping_insert(size, &fl, &sl);
+
+			if(((heap->sl_bitmap[fl] & (1U << sl)) == 0) ||
+			   ((block->prev_free == NULL) && (heap->blocks[fl][sl] != block)) ||
+			   ((block->prev_free != NULL) && (block->prev_free->next_free != block))) {
+				return false;
+			}
+
+			free_bytes += size;
+		} else {
+			used_bytes += size;
+			num_allocs++;
+		}
+
+		prev = block;
+	}
+
+	return (heap->sentinel->prev_phys == prev) &&
+	       (used_bytes == heap->used_bytes) &&
+	       (num_allocs == heap->num_allocs) &&
+	       (used_bytes + free_bytes == heap->total_bytes);
+}
+
+/**
+ * Call a function for every block (used or free) in a heap, in address order.
+ * The walker must not allocate or free memory from the heap.
+ *
+ * @param heap The heap to walk.
+ * @param walker Function to call for each block.
+ * @param arg Argument passed to the walker.
+ */
+void tlsf_walk(tlsf_t *heap, tlsf_walker_t walker, void *arg)
+{
+	ASSERT(heap != NULL);
+	ASSERT(walker != NULL);
+
+	for(block_t *block = heap->first; block != heap->sentinel; block = _block_next(block)) {
+		walker(_block_to_ptr(block),
+		       _block_size(block) - BLOCK_HEADER_SIZE,
+		       !_block_is_free(block),
+		       arg);
+	}
+}
@@ -0,0 +1,63 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Two-Level Segregated Fit (TLSF) heap allocator.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Every allocation is aligned to at least this many bytes. */
+#define TLSF_ALIGNMENT 8U
+
+/**
+ * Opaque handle to a TLSF heap. The heap's bookkeeping data lives at the start
+ * of the memory region that the heap manages.
+ */
+typedef struct tlsf tlsf_t;
+
+/* Snapshot of a heap's usage statistics. */
+typedef struct {
+	/* Bytes available to allocations when the heap is empty. */
+	size_t total_bytes;
+
+	/* Bytes currently handed out (including per-allocation overhead). */
+	size_t used_bytes;
+
+	/* The most bytes that have ever been handed out at once. */
+	size_t peak_bytes;
+
+	/**
+	 * Size of the largest allocation that is guaranteed to succeed. This can be
+	 * smaller than the largest free block, since requests get rounded up to
+	 * the next size class.
+	 */
+	size_t largest_free;
+
+	/* Number of outstanding allocations. */
+	uint32_t num_allocs;
+} tlsf_stats_t;
+
+/**
+ * Function called by tlsf_walk() for every block in a heap. The pointer and
+ * size are the same as what tlsf_malloc() and tlsf_block_size() would return.
+ */
+typedef void (*tlsf_walker_t)(void *ptr, size_t size, bool used, void *arg);
+
+tlsf_t * tlsf_create(void *mem, size_t size);
+
+void * tlsf_malloc(tlsf_t *heap, size_t size);
+void * tlsf_memalign(tlsf_t *heap, size_t align, size_t size);
+void tlsf_free(tlsf_t *heap, void *ptr);
+
+size_t tlsf_block_size(void *ptr);
+bool tlsf_owns(tlsf_t *heap, void *ptr);
+
+void tlsf_get_stats(tlsf_t *heap, tlsf_stats_t *stats);
+bool tlsf_check(tlsf_t *heap);
+void tlsf_walk(tlsf_t *heap, tlsf_walker_t walker, void *arg);
@@ -0,0 +1,150 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Deferred work queue (a.k.a., "bottom halves").
+ *
+ * Interrupt handlers should do the bare minimum needed to service the hardware
+ * (clearing flags, grabbing data out of registers) and then submit a work item
+ * to perform any further processing. That processing then runs in the worker
+ * task where it can be preempted by interrupts and higher-priority tasks.
+ *
+ * Submitting work is lock-free: pending work items are pushed onto a singly
+ * linked stack using an atomic compare-and-swap (LDREX/STREX). The worker task
+ * atomically takes the whole stack at once, reverses it so work runs in the
+ * same order it was submitted, and then runs each item. Because each work item
+ * can only be on the list once, submitting a work item that's already pending
+ * does nothing (the work will still only run once).
+ */
+#include "config.h"
+#include "debug.h"
+#include "os/task.h"
+#include "os/work_queue.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if ENABLE_WORK_QUEUE
+
+/* Stack of submitted work items (most recently submitted first). */
+static work_t *pending_work = NULL;
+
+/* The task that runs submitted work items. */
+STATIC_TASK_ALLOC(work_queue, WORK_QUEUE_TASK_STACK_SIZE);
+static volatile bool worker_created = false;
+
+/**
+ * Initialize a work item. This must be called before the work item is
+ * submitted for the first time.
+ *
+ * @param work The work item to initialize.
+ * @param func The function to run when the work item gets processed.
+ * @param arg Argument passed to the function.
+ */
+void work_init(work_t *work, work_func_t func, void *arg)
+{
+	ASSERT(work != NULL);
+	ASSERT(func != NULL);
+
+	work->next = NULL;
+	work->func = func;
+	work->arg = arg;
+	work->pending = false;
+}
+
+/**
+ * Queue up a work item to be run by the worker task. If the worker task hasn't
+ * been created yet (the scheduler hasn't started), then the work gets run
+ * immediately by the caller instead.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param work The work item to submit.
+ *
+ * @return True if the work item was queued up, false if it was already pending.
+ */
+bool work_submit(work_t *work)
+{
+	ASSERT(work != NULL);
+	ASSERT(work->func != NULL);
+
+	if(!worker_created) {
+		work->func(work->arg);
+		return true;
+	}
+
+	/* Only the caller that sets the pending flag gets to add it to the list. */
+	if(__atomic_exchange_n(&work->pending, true, __ATOMIC_ACQUIRE)) {
+		return false;
+	}
+
+	work_t *head = __atomic_load_n(&pending_work, __ATOMIC_RELAXED);
+	do {
+		work->next = head;
+	} while(!__atomic_compare_exchange_n(&pending_work,
+	                                     &head,
+	                                     work,
+	                                     true,
+	                                     __ATOMIC_RELEASE,
+	                                     __ATOMIC_RELAXED));
+
+	sched_wake(&work_queue_task);
+
+	return true;
+}
+
+/**
+ * @return True if the work item has been submitted but hasn't started running.
+ */
+bool work_is_pending(work_t *work)
+{
+	ASSERT(work != NULL);
+
+	return work->pending;
+}
+
+/**
+ * The worker task. Runs every submitted work item in the order it was
+ * submitted, then blocks until more work comes in.
+ */
+static void _work_queue_task(__unused void *param)
+{
+	while(1) {
+		work_t *work = __atomic_exchange_n(&pending_work, NULL, __ATOMIC_ACQUIRE);
+
+		if(work == NULL) {
+			sched_block();
+			continue;
+		}
+
+		/* The list was built up in reverse, flip it back to submission order. */
+		work_t *ordered = NULL;
+		while(work != NULL) {
+			work_t *const next = work->next;
+			work->next = ordered;
+			ordered = work;
+			work = next;
+		}
+
+		while(ordered != NULL) {
+			work = ordered;
+			ordered = work->next;
+
+			/* The work item can be submitted again as soon as it starts running. */
+			__atomic_store_n(&work->pending, false, __ATOMIC_RELEASE);
+			work->func(work->arg);
+		}
+	}
+}
+
+/**
+ * Create the worker task. This is called by sched_begin().
+ */
+void work_queue_task_create(void)
+{
+	STATIC_TASK_CREATE(work_queue, WORK_QUEUE_TASK_STACK_SIZE, _work_queue_task, NULL);
+	task_set_priority(&work_queue_task, WORK_QUEUE_TASK_PRIORITY);
+	worker_created = true;
+}
+
+#endif /* ENABLE_WORK_QUEUE */
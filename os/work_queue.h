@@ -0,0 +1,44 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Deferred work queue. Interrupt handlers submit small work items which then
+ * get run in task context by a high-priority worker task.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Signature for functions run by the work queue. */
+typedef void (*work_func_t)(void *arg);
+
+/**
+ * Structure representing a single item of deferred work. This should be
+ * treated as opaque and only accessed through the API exposed in this header.
+ *
+ * Work items are usually statically allocated by the driver that submits them
+ * and get reused every time that work needs to be done.
+ */
+typedef struct work {
+	/* Link in the list of pending work items. */
+	struct work *next;
+
+	/* Function to run (and its argument) when the work item gets processed. */
+	work_func_t func;
+	void *arg;
+
+	/* True while the work item is queued up and hasn't started running yet. */
+	volatile bool pending;
+} work_t;
+
+#if ENABLE_WORK_QUEUE
+void work_init(work_t *work, work_func_t func, void *arg);
+
+bool work_submit(work_t *work);
+bool work_is_pending(work_t *work);
+
+void work_queue_task_create(void);
+#endif /* ENABLE_WORK_QUEUE */
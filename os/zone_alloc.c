@@ -0,0 +1,204 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Fixed-size object pool ("zone") allocator.
+ *
+ * Each zone is a statically sized array of equally sized objects. Freed objects
+ * are kept on a singly linked free list (threaded through the objects
+ * themselves) so allocating and freeing are both O(1) and can never fragment
+ * memory. Objects that have never been allocated are handed out in order from
+ * the end of the array, so zones don't need to build up their free list at
+ * initialization time.
+ *
+ * Zones are meant for objects that get allocated and freed over and over at
+ * runtime (packets, file handles, messages, etc.) where the init-only
+ * mem_alloc() isn't a good fit.
+ */
+#include "config.h"
+#include "debug.h"
+#include "interrupt.h"
+#include "os/zone_alloc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if ENABLE_MEM_DEBUG
+/**
+ * @return The start of an object's red zone (free objects always need room for
+ *         the free list pointer).
+ */
+static uint8_t * _redzone(zone_t *zone, void *obj)
+{
+	return (uint8_t*)obj + ((zone->req_size < sizeof(void*)) ? sizeof(void*) : zone->req_size);
+}
+
+/**
+ * Abort if anything wrote past the end of an object.
+ */
+static void _redzone_check(zone_t *zone, void *obj)
+{
+	for(uint8_t *byte = _redzone(zone, obj); byte < (uint8_t*)obj + zone->obj_size; byte++) {
+		if(*byte != MEM_DEBUG_REDZONE_VALUE) {
+			ABORT("Zone %s: overrun past object %p", zone->name, obj);
+		}
+	}
+}
+#endif /* ENABLE_MEM_DEBUG */
+
+/**
+ * Initialize a zone at runtime (e.g., with memory from mem_alloc()). Zones
+ * created with ZONE_DEFINE() don't need to call this.
+ *
+ * @param zone The zone to initialize.
+ * @param name Name of the zone (used when printing statistics).
+ * @param mem Backing memory. Must be aligned to ZONE_ALIGNMENT and hold at
+ *            least ZONE_OBJ_SIZE(obj_size) * num_objs bytes.
+ * @param obj_size The size of each object in bytes.
+ * @param num_objs The number of objects in the zone.
+ */
+void zone_init(zone_t *zone, const char *name, void *mem, size_t obj_size, uint32_t num_objs)
+{
+	ASSERT(zone != NULL);
+	ASSERT(mem != NULL);
+	ASSERT(((uintptr_t)mem & (ZONE_ALIGNMENT - 1U)) == 0);
+	ASSERT(obj_size > 0);
+	ASSERT(num_objs > 0);
+
+	zone->name = name;
+	zone->mem = (uint8_t*)mem;
+	zone->obj_size = ZONE_OBJ_SIZE(obj_size);
+#if ENABLE_MEM_DEBUG
+	zone->req_size = obj_size;
+#endif /* ENABLE_MEM_DEBUG */
+	zone->num_objs = num_objs;
+	zone->free_list = NULL;
+	zone->num_carved = 0;
+	zone->num_used = 0;
+	zone->peak_used = 0;
+	zone->num_failures = 0;
+}
+
+/**
+ * Allocate an object from a zone.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param zone The zone to allocate from.
+ *
+ * @return A pointer to the object, or NULL if every object is in use.
+ */
+void * zone_alloc(zone_t *zone)
+{
+	ASSERT(zone != NULL);
+
+	void *obj = NULL;
+	const uint32_t primask = intr_enter_critical();
+
+	if(zone->free_list != NULL) {
+		obj = zone->free_list;
+		zone->free_list = *(void**)obj;
+
+#if ENABLE_MEM_DEBUG
+		/* Catch writes past the end of this object after it was freed. */
+		_redzone_check(zone, obj);
+#endif /* ENABLE_MEM_DEBUG */
+	} else if(zone->num_carved < zone->num_objs) {
+		obj = zone->mem + (zone->num_carved * zone->obj_size);
+		zone->num_carved++;
+
+#if ENABLE_MEM_DEBUG
+		uint8_t *const redzone = _redzone(zone, obj);
+		memset(redzone, MEM_DEBUG_REDZONE_VALUE, (size_t)((uint8_t*)obj + zone->obj_size - redzone));
+#endif /* ENABLE_MEM_DEBUG */
+	}
+
+	if(obj != NULL) {
+		zone->num_used++;
+
+		if(zone->num_used > zone->peak_used) {
+			zone->peak_used = zone->num_used;
+		}
+	} else {
+		zone->num_failures++;
+	}
+
+	intr_exit_critical(primask);
+
+	return obj;
+}
+
+/**
+ * Return an object back to the zone it was allocated from.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param zone The zone the object was allocated from.
+ * @param obj The object to free. Cannot be NULL.
+ */
+void zone_free(zone_t *zone, void *obj)
+{
+	ASSERT(zone != NULL);
+	ASSERT(obj != NULL);
+
+	/* Make sure the object actually came from this zone. */
+	ASSERT((uint8_t*)obj >= zone->mem);
+	ASSERT((uint8_t*)obj < zone->mem + (zone->num_carved * zone->obj_size));
+	ASSERT((((uint8_t*)obj - zone->mem) % zone->obj_size) == 0);
+
+	const uint32_t primask = intr_enter_critical();
+
+	ASSERT(zone->num_used > 0);
+
+#if ENABLE_MEM_DEBUG
+	_redzone_check(zone, obj);
+#endif /* ENABLE_MEM_DEBUG */
+
+	*(void**)obj = zone->free_list;
+	zone->free_list = obj;
+	zone->num_used--;
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Get a consistent snapshot of a zone's usage statistics.
+ *
+ * @param zone The zone to query.
+ * @param stats Filled in with the zone's statistics.
+ */
+void zone_get_stats(zone_t *zone, zone_stats_t *stats)
+{
+	ASSERT(zone != NULL);
+	ASSERT(stats != NULL);
+
+	const uint32_t primask = intr_enter_critical();
+
+	stats->obj_size = zone->obj_size;
+	stats->num_objs = zone->num_objs;
+	stats->num_used = zone->num_used;
+	stats->peak_used = zone->peak_used;
+	stats->num_failures = zone->num_failures;
+
+	intr_exit_critical(primask);
+}
+
+/**
+ * Print out a zone's usage statistics.
+ *
+ * @param zone The zone to print.
+ */
+void zone_dump_stats(zone_t *zone)
+{
+	__unused zone_stats_t stats;
+	zone_get_stats(zone, &stats);
+
+	dbprintf("Zone %s: %lu x %u bytes, used %lu, peak %lu, failed allocs %lu\n",
+	         zone->name,
+	         stats.num_objs,
+	         (unsigned)stats.obj_size,
+	         stats.num_used,
+	         stats.peak_used,
+	         stats.num_failures);
+}
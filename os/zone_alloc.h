@@ -0,0 +1,106 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Fixed-size object pool ("zone") allocator.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Every object handed out by a zone is aligned to this many bytes. */
+#define ZONE_ALIGNMENT 8U
+
+#if ENABLE_MEM_DEBUG
+/* Every object is followed by a red zone that gets checked when it's freed. */
+#define ZONE_REDZONE_SIZE MEM_DEBUG_REDZONE_SIZE
+#define ZONE_DEBUG_INIT(size) .req_size = (size),
+#else
+#define ZONE_REDZONE_SIZE 0U
+#define ZONE_DEBUG_INIT(size)
+#endif /* ENABLE_MEM_DEBUG */
+
+/**
+ * The number of bytes each object in a zone actually takes up. Objects need to
+ * be big enough to hold the free list pointer while they're free.
+ */
+#define ZONE_OBJ_SIZE(obj_size) \
+	((((obj_size) < sizeof(void*) ? sizeof(void*) : (obj_size)) + \
+	  ZONE_REDZONE_SIZE + ZONE_ALIGNMENT - 1U) & ~(ZONE_ALIGNMENT - 1U))
+
+/**
+ * Structure representing a zone. This should be treated as opaque and only
+ * accessed through the API exposed in this header.
+ */
+typedef struct {
+	/* Name of the zone (used when printing statistics). */
+	const char *name;
+
+	/* Backing memory for every object in the zone. */
+	uint8_t *mem;
+
+	/* Size of each object (rounded up by ZONE_OBJ_SIZE()). */
+	size_t obj_size;
+
+#if ENABLE_MEM_DEBUG
+	/* Size of each object as requested (the red zone comes after this). */
+	size_t req_size;
+#endif /* ENABLE_MEM_DEBUG */
+
+	/* Total number of objects in the zone. */
+	uint32_t num_objs;
+
+	/**
+	 * Objects that have been freed back to the zone. Each free object's first
+	 * word points to the next free object.
+	 */
+	void *free_list;
+
+	/**
+	 * Number of objects at the start of the backing memory that have been
+	 * handed out at least once. Objects past this point haven't been added to
+	 * the free list yet, which means a zone doesn't need to be initialized.
+	 */
+	uint32_t num_carved;
+
+	/* Statistics. */
+	uint32_t num_used;
+	uint32_t peak_used;
+	uint32_t num_failures;
+} zone_t;
+
+/* Snapshot of a zone's usage statistics. */
+typedef struct {
+	size_t obj_size;
+	uint32_t num_objs;
+	uint32_t num_used;
+	uint32_t peak_used;
+	uint32_t num_failures;
+} zone_stats_t;
+
+/**
+ * Statically allocate a zone named "<zone_name>_zone" that holds "count"
+ * objects of "size" bytes each. The zone can be used right away without
+ * calling zone_init().
+ */
+#define ZONE_DEFINE(zone_name, size, count) \
+	static uint8_t zone_name ## _zone_mem[ZONE_OBJ_SIZE(size) * (count)] \
+		__attribute__ ((aligned (ZONE_ALIGNMENT))); \
+	zone_t zone_name ## _zone = { \
+		.name = #zone_name, \
+		.mem = zone_name ## _zone_mem, \
+		.obj_size = ZONE_OBJ_SIZE(size), \
+		ZONE_DEBUG_INIT(size) \
+		.num_objs = (count), \
+	}
+
+void zone_init(zone_t *zone, const char *name, void *mem, size_t obj_size, uint32_t num_objs);
+
+void * zone_alloc(zone_t *zone);
+void zone_free(zone_t *zone, void *obj);
+
+void zone_get_stats(zone_t *zone, zone_stats_t *stats);
+void zone_dump_stats(zone_t *zone);
@@ -0,0 +1,78 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Software CRC routines used to protect data sent over unreliable links.
+ *
+ * Both CRCs are computed a nibble at a time using 16-entry tables, which is
+ * about half as fast as the usual 256-entry tables while taking up a tiny
+ * fraction of the flash (and the data cache).
+ *
+ * Both functions can be called repeatedly to checksum data that is split up
+ * into multiple pieces: pass the previous return value back in as "crc".
+ */
+#include "crc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CRC-16/CCITT-FALSE (polynomial 0x1021, not reflected) remainders per nibble. */
+static const uint16_t crc16_table[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/* CRC-32 (reflected polynomial 0xEDB88320) remainders per nibble. */
+static const uint32_t crc32_table[16] = {
+	0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+	0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+	0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+	0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+/**
+ * Calculate the CRC-16/CCITT-FALSE of a buffer (the CRC used by XMODEM-style
+ * protocols, but starting from 0xFFFF).
+ *
+ * @param crc CRC16_INIT, or the result of a previous call to continue it.
+ * @param data The data to checksum.
+ * @param len The number of bytes of data.
+ *
+ * @return The updated CRC.
+ */
+uint16_t crc16(uint16_t crc, const void *data, size_t len)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	while(len-- > 0) {
+		crc ^= (uint16_t)(*bytes++ << 8);
+		crc = (uint16_t)((crc << 4) ^ crc16_table[crc >> 12]);
+		crc = (uint16_t)((crc << 4) ^ crc16_table[crc >> 12]);
+	}
+
+	return crc;
+}
+
+/**
+ * Calculate the CRC-32 of a buffer (the same CRC used by Ethernet and zlib).
+ *
+ * @param crc CRC32_INIT, or the result of a previous call to continue it.
+ * @param data The data to checksum.
+ * @param len The number of bytes of data.
+ *
+ * @return The updated CRC.
+ */
+uint32_t crc32(uint32_t crc, const void *data, size_t len)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+
+	crc = ~crc;
+
+	while(len-- > 0) {
+		crc ^= *bytes++;
+		crc = (crc >> 4) ^ crc32_table[crc & 0xFU];
+		crc = (crc >> 4) ^ crc32_table[crc & 0xFU];
+	}
+
+	return ~crc;
+}
@@ -0,0 +1,19 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Software CRC routines used to protect data sent over unreliable links.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Value to start a CRC-16 calculation with. */
+#define CRC16_INIT 0xFFFFU
+
+/* Value to start a CRC-32 calculation with. */
+#define CRC32_INIT 0U
+
+uint16_t crc16(uint16_t crc, const void *data, size_t len);
+uint32_t crc32(uint32_t crc, const void *data, size_t len);
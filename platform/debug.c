@@ -4,7 +4,71 @@
  *
  * Definitions useful in debugging firmware.
  */
+#include "config.h"
 #include "debug.h"
+#include "fmt.h"
+#include "interrupt.h"
+#include "os/log.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#ifdef DEBUG_ON
+#if !ENABLE_LOG_RING && defined(SEMIHOSTING_ENABLED)
+/**
+ * Newlib's semihosting write syscall. This is declared here instead of pulling
+ * in <unistd.h>, whose sleep() conflicts with the one in system_timer.h.
+ */
+int _write(int file, char *ptr, int len);
+#define SEMIHOSTING_STDOUT 1
+#endif /* !ENABLE_LOG_RING && SEMIHOSTING_ENABLED */
+
+/**
+ * Send a formatted message out. With ENABLE_LOG_RING set, the message gets
+ * queued up in the log ring instead of being output by the caller.
+ */
+static void _debug_write(const char *msg, size_t len)
+{
+#if ENABLE_LOG_RING
+	log_write(msg, len);
+#elif defined(SEMIHOSTING_ENABLED)
+	_write(SEMIHOSTING_STDOUT, (char*)msg, (int)len);
+#else
+	(void)msg;
+	(void)len;
+#endif /* ENABLE_LOG_RING */
+}
+
+/**
+ * printf() replacement used by dbprintf(). The message is formatted into a
+ * buffer on the caller's stack (without ever calling malloc()), so this is safe
+ * to call from both tasks and ISRs. Messages longer than
+ * DEBUG_PRINTF_BUFFER_SIZE - 1 characters get truncated.
+ */
+void debug_printf(const char *format, ...)
+{
+	char msg[DEBUG_PRINTF_BUFFER_SIZE];
+
+	va_list args;
+	va_start(args, format);
+	size_t len = fmt_vsnprintf(msg, sizeof(msg), format, args);
+	va_end(args);
+
+	if(len >= sizeof(msg)) {
+		len = sizeof(msg) - 1U;
+	}
+
+	_debug_write(msg, len);
+}
+
+/**
+ * puts() replacement used by dbputs().
+ */
+void debug_puts(const char *str)
+{
+	debug_printf("%s\n", str);
+}
+#endif /* DEBUG_ON */
 
 /**
  * Cause the system to enter an infinite loop. This is called when the system
@@ -14,5 +78,14 @@
 void die(void)
 {
 	dbprintf("[ABORT] Connect with a debugger...\n");
+
+	/* Nothing else gets to run from here on. */
+	intr_disable_interrupts();
+
+#if ENABLE_LOG_RING
+	/* The log task will never run again, so get the abort message out now. */
+	log_panic_flush();
+#endif /* ENABLE_LOG_RING */
+
 	while(1) { }
 }
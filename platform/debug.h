@@ -6,19 +6,35 @@
  */
 #pragma once
 
+#include "config.h"
+#include "os/log.h"
 #include "system_timer.h"
 
 #include <stdio.h>
 #include <sys/cdefs.h> /* For "__unused" */
 
 #ifdef DEBUG_ON
-	#define dbputs(s)               puts(s)
-	#define dbprintf(szFormat, ...) printf(szFormat,##__VA_ARGS__)
+	#define dbputs(s)               debug_puts(s)
+	#define dbprintf(szFormat, ...) debug_printf(szFormat,##__VA_ARGS__)
+
+	void debug_puts(const char *str);
+	void debug_printf(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
 #else
 	#define dbputs(s)
 	#define dbprintf(szFormat, ...)
 #endif
 
+/**
+ * Use dblog() instead of dbprintf() in hot paths. With ENABLE_LOG_BINARY set,
+ * the message is written into the log ring in binary form without being
+ * formatted (see LOG_BINARY()), otherwise this is the same as dbprintf().
+ */
+#if defined(DEBUG_ON) && ENABLE_LOG_RING && ENABLE_LOG_BINARY
+	#define dblog(szFormat, ...) LOG_BINARY(szFormat,##__VA_ARGS__)
+#else
+	#define dblog(szFormat, ...) dbprintf(szFormat,##__VA_ARGS__)
+#endif
+
 /**
  * Mark a variable with this modifier if it's only going to be used in an
  * assert statement that will get compiled out on RELEASE builds.
@@ -0,0 +1,398 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Small, reentrant, allocation-free printf-style string formatting.
+ *
+ * newlib's printf() family calls malloc() and can use a lot of stack, which
+ * makes it unusable from interrupts and risky from tasks. This implementation
+ * never allocates, only uses a small fixed amount of stack, and always
+ * terminates the output (truncating it if the buffer is too small).
+ *
+ * Supported conversions: d, i, u, x, X, o, c, s, p, and %. The "-", "0", "+",
+ * " ", and "#" flags, field widths, precisions (including "*"), and the hh, h,
+ * l, ll, j, z, and t length modifiers are all supported. Floating point isn't.
+ */
+#include "fmt.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Conversion specification flags. */
+#define FLAG_LEFT    0x01U /* "-" */
+#define FLAG_ZERO    0x02U /* "0" */
+#define FLAG_PLUS    0x04U /* "+" */
+#define FLAG_SPACE   0x08U /* " " */
+#define FLAG_ALT     0x10U /* "#" */
+#define FLAG_UPPER   0x20U /* Uppercase hex digits. */
+#define FLAG_PREC    0x40U /* A precision was given. */
+#define FLAG_POINTER 0x80U /* Always print the "0x" prefix. */
+
+/* Enough digits for a 64-bit number in octal. */
+#define MAX_DIGITS 22U
+
+/* Output state shared by every conversion. */
+typedef struct {
+	char *buf;
+	size_t size;
+
+	/* Number of characters that would have been written with enough room. */
+	size_t len;
+} fmt_out_t;
+
+static void _putc(fmt_out_t *out, char c)
+{
+	if(out->len + 1U < out->size) {
+		out->buf[out->len] = c;
+	}
+
+	out->len++;
+}
+
+static void _pad(fmt_out_t *out, char c, int count)
+{
+	for(; count > 0; count--) {
+		_putc(out, c);
+	}
+}
+
+/**
+ * Output a string padded out to the field width.
+ */
+static void _put_str(fmt_out_t *out, const char *str, int width, int prec, uint32_t flags)
+{
+	size_t len = 0;
+	while(str[len] != '\0' && (!(flags & FLAG_PREC) || (len < (size_t)prec))) {
+		len++;
+	}
+
+	const int padding = width - (int)len;
+
+	if(!(flags & FLAG_LEFT)) {
+		_pad(out, ' ', padding);
+	}
+
+	for(size_t i = 0; i < len; i++) {
+		_putc(out, str[i]);
+	}
+
+	if(flags & FLAG_LEFT) {
+		_pad(out, ' ', padding);
+	}
+}
+
+/**
+ * Output an integer in the given base.
+ *
+ * @param value The magnitude of the number.
+ * @param negative True if a minus sign should be printed.
+ */
+static void _put_num(fmt_out_t *out,
+                     uint64_t value,
+                     bool negative,
+                     uint32_t base,
+                     int width,
+                     int prec,
+                     uint32_t flags)
+{
+	const char *const digits = (flags & FLAG_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+	const bool is_zero = (value == 0);
+	char tmp[MAX_DIGITS];
+	int num_digits = 0;
+
+	/* Dividing 64-bit values is slow, so only do it when actually needed. */
+	if(value > UINT32_MAX) {
+		while(value != 0) {
+			tmp[num_digits++] = digits[value % base];
+			value /= base;
+		}
+	} else {
+		uint32_t value32 = (uint32_t)value;
+
+		while(value32 != 0) {
+			tmp[num_digits++] = digits[value32 % base];
+			value32 /= base;
+		}
+	}
+
+	/* A precision of zero with a value of zero prints no digits at all. */
+	if((num_digits == 0) && !((flags & FLAG_PREC) && (prec == 0))) {
+		tmp[num_digits++] = '0';
+	}
+
+	/* Figure out the prefix (sign or base indicator). */
+	char prefix[2];
+	int prefix_len = 0;
+
+	if(negative) {
+		prefix[prefix_len++] = '-';
+	} else if(flags & FLAG_PLUS) {
+		prefix[prefix_len++] = '+';
+	} else if(flags & FLAG_SPACE) {
+		prefix[prefix_len++] = ' ';
+	}
+
+	if(((flags & FLAG_ALT) && (base == 16U) && !is_zero) || (flags & FLAG_POINTER)) {
+		prefix[prefix_len++] = '0';
+		prefix[prefix_len++] = (flags & FLAG_UPPER) ? 'X' : 'x';
+	} else if((flags & FLAG_ALT) && (base == 8U) && !is_zero && (prec <= num_digits)) {
+		/* Octal's alternate form makes sure the first digit is a zero. */
+		prec = num_digits + 1;
+		flags |= FLAG_PREC;
+	}
+
+	/* Leading zeroes needed to reach the precision. */
+	int zeroes = ((flags & FLAG_PREC) && (prec > num_digits)) ? (prec - num_digits) : 0;
+	int padding = width - prefix_len - zeroes - num_digits;
+
+	/* The zero flag is ignored if a precision is given. */
+	if((flags & FLAG_ZERO) && !(flags & (FLAG_LEFT | FLAG_PREC)) && (padding > 0)) {
+		zeroes += padding;
+		padding = 0;
+	}
+
+	if(!(flags & FLAG_LEFT)) {
+		_pad(out, ' ', padding);
+	}
+
+	for(int i = 0; i < prefix_len; i++) {
+		_putc(out, prefix[i]);
+	}
+
+	_pad(out, '0', zeroes);
+
+	while(num_digits > 0) {
+		_putc(out, tmp[--num_digits]);
+	}
+
+	if(flags & FLAG_LEFT) {
+		_pad(out, ' ', padding);
+	}
+}
+
+/**
+ * Format a string into a buffer (see vsnprintf()).
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param buf The buffer to write into. The output is always null-terminated
+ *            (as long as size isn't zero).
+ * @param size The size of the buffer in bytes.
+ * @param format printf-style format string.
+ * @param args Arguments for the format string.
+ *
+ * @return The length the formatted string would have had if the buffer was
+ *         big enough (not including the null terminator).
+ */
+size_t fmt_vsnprintf(char *buf, size_t size, const char *format, va_list args)
+{
+	fmt_out_t out = { .buf = buf, .size = size, .len = 0 };
+
+	while(*format != '\0') {
+		if(*format != '%') {
+			_putc(&out, *format++);
+			continue;
+		}
+
+		format++;
+
+		/* Flags. */
+		uint32_t flags = 0;
+		bool more_flags = true;
+		while(more_flags) {
+			switch(*format) {
+				case '-': flags |= FLAG_LEFT; format++; break;
+				case '0': flags |= FLAG_ZERO; format++; break;
+				case '+': flags |= FLAG_PLUS; format++; break;
+				case ' ': flags |= FLAG_SPACE; format++; break;
+				case '#': flags |= FLAG_ALT; format++; break;
+				default: more_flags = false; break;
+			}
+		}
+
+		/* Field width. */
+		int width = 0;
+		if(*format == '*') {
+			width = va_arg(args, int);
+			if(width < 0) {
+				flags |= FLAG_LEFT;
+				width = -width;
+			}
+			format++;
+		} else {
+			while((*format >= '0') && (*format <= '9')) {
+				width = (width * 10) + (*format++ - '0');
+			}
+		}
+
+		/* Precision. */
+		int prec = 0;
+		if(*format == '.') {
+			flags |= FLAG_PREC;
+			format++;
+
+			if(*format == '*') {
+				prec = va_arg(args, int);
+				if(prec < 0) {
+					flags &= ~FLAG_PREC;
+				}
+				format++;
+			} else {
+				while((*format >= '0') && (*format <= '9')) {
+					prec = (prec * 10) + (*format++ - '0');
+				}
+			}
+		}
+
+		/* Length modifier (in bytes of the argument). */
+		size_t arg_size = sizeof(int);
+		switch(*format) {
+			case 'h':
+				format++;
+				arg_size = sizeof(short);
+				if(*format == 'h') {
+					format++;
+					arg_size = sizeof(char);
+				}
+				break;
+
+			case 'l':
+				format++;
+				arg_size = sizeof(long);
+				if(*format == 'l') {
+					format++;
+					arg_size = sizeof(long long);
+				}
+				break;
+
+			case 'j': format++; arg_size = sizeof(intmax_t); break;
+			case 'z': format++; arg_size = sizeof(size_t); break;
+			case 't': format++; arg_size = sizeof(ptrdiff_t); break;
+			default: break;
+		}
+
+		const char conversion = *format;
+		if(conversion == '\0') {
+			break;
+		}
+		format++;
+
+		switch(conversion) {
+			case 'd':
+			case 'i': {
+				int64_t value;
+				if(arg_size == sizeof(long long)) {
+					value = va_arg(args, long long);
+				} else if(arg_size == sizeof(long)) {
+					value = va_arg(args, long);
+				} else {
+					value = va_arg(args, int);
+
+					/* char and short arguments are promoted to int. */
+					if(arg_size == sizeof(char)) {
+						value = (signed char)value;
+					} else if(arg_size == sizeof(short)) {
+						value = (short)value;
+					}
+				}
+
+				/* Negate as unsigned so INT64_MIN doesn't overflow. */
+				const uint64_t magnitude = (value < 0) ? (0U - (uint64_t)value) : (uint64_t)value;
+				_put_num(&out, magnitude, value < 0, 10U, width, prec, flags);
+				break;
+			}
+
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o': {
+				uint64_t value;
+				if(arg_size == sizeof(long long)) {
+					value = va_arg(args, unsigned long long);
+				} else if(arg_size == sizeof(long)) {
+					value = va_arg(args, unsigned long);
+				} else {
+					value = va_arg(args, unsigned int);
+
+					if(arg_size == sizeof(char)) {
+						value = (unsigned char)value;
+					} else if(arg_size == sizeof(short)) {
+						value = (unsigned short)value;
+					}
+				}
+
+				const uint32_t base = (conversion == 'u') ? 10U : (conversion == 'o') ? 8U : 16U;
+				flags &= ~(FLAG_PLUS | FLAG_SPACE);
+				if(conversion == 'X') {
+					flags |= FLAG_UPPER;
+				}
+
+				_put_num(&out, value, false, base, width, prec, flags);
+				break;
+			}
+
+			case 'p': {
+				const uintptr_t value = (uintptr_t)va_arg(args, void*);
+				_put_num(&out, value, false, 16U, width, prec, flags | FLAG_POINTER);
+				break;
+			}
+
+			case 'c': {
+				const char c = (char)va_arg(args, int);
+
+				if(!(flags & FLAG_LEFT)) {
+					_pad(&out, ' ', width - 1);
+				}
+
+				_putc(&out, c);
+
+				if(flags & FLAG_LEFT) {
+					_pad(&out, ' ', width - 1);
+				}
+				break;
+			}
+
+			case 's': {
+				const char *str = va_arg(args, const char*);
+				_put_str(&out, (str != NULL) ? str : "(null)", width, prec, flags);
+				break;
+			}
+
+			case '%':
+				_putc(&out, '%');
+				break;
+
+			default:
+				/* Unsupported conversion, print it as-is. */
+				_putc(&out, '%');
+				_putc(&out, conversion);
+				break;
+		}
+	}
+
+	if(size > 0) {
+		buf[(out.len < size) ? out.len : (size - 1U)] = '\0';
+	}
+
+	return out.len;
+}
+
+/**
+ * Format a string into a buffer (see snprintf()).
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @return The length the formatted string would have had if the buffer was
+ *         big enough (not including the null terminator).
+ */
+size_t fmt_snprintf(char *buf, size_t size, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	const size_t len = fmt_vsnprintf(buf, size, format, args);
+	va_end(args);
+
+	return len;
+}
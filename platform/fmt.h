@@ -0,0 +1,16 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Small, reentrant, allocation-free printf-style string formatting.
+ */
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+size_t fmt_vsnprintf(char *buf, size_t size, const char *format, va_list args)
+	__attribute__ ((format (printf, 3, 0)));
+
+size_t fmt_snprintf(char *buf, size_t size, const char *format, ...)
+	__attribute__ ((format (printf, 3, 4)));
@@ -9,6 +9,9 @@
 
 #include "config.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * STM32F7 only supports 16 interrupt priority levels. The "urgency" of the
  * interrupt is inversely correlated with its priority number (e.g., zero is the
@@ -27,6 +30,11 @@ void intr_init(void);
 void intr_enable_interrupts(void);
 void intr_disable_interrupts(void);
 
+uint32_t intr_enter_critical(void);
+void intr_exit_critical(uint32_t primask);
+
+bool intr_in_isr(void);
+
 void intr_register(irq_num_t irq, isr_func_t isr, uint8_t priority);
 void intr_register_svcall(isr_func_t isr, uint8_t priority);
 void intr_register_pendsv(isr_func_t isr, uint8_t priority);
@@ -0,0 +1,16 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Contains methods for configuring the Memory Protection Unit.
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+void mpu_enable(void);
+
+void mpu_set_guard_region(uint8_t region, uintptr_t base, size_t size);
@@ -327,6 +327,50 @@ void intr_disable_interrupts(void)
 	asm volatile("cpsid i" ::: "memory");
 }
 
+/**
+ * Disable all exceptions with configurable priority and return whether they
+ * were previously enabled. Unlike intr_disable_interrupts(), critical sections
+ * created with this function can be safely nested and used from ISRs.
+ *
+ * Example usage:
+ * const uint32_t primask = intr_enter_critical();
+ * ...
+ * intr_exit_critical(primask);
+ *
+ * @return The previous interrupt mask state to pass to intr_exit_critical().
+ */
+uint32_t intr_enter_critical(void)
+{
+	uint32_t primask;
+
+	asm volatile(
+		"mrs	%0, PRIMASK \n"
+		"cpsid	i \n"
+		: "=r" (primask) :: "memory");
+
+	return primask;
+}
+
+/**
+ * Restore the interrupt mask state from before the matching call to
+ * intr_enter_critical().
+ *
+ * @param primask The value returned by intr_enter_critical().
+ */
+void intr_exit_critical(uint32_t primask)
+{
+	asm volatile("msr	PRIMASK, %0" :: "r" (primask) : "memory");
+}
+
+/**
+ * @return True if currently executing in an exception handler (Handler mode),
+ *         false if running in a task (Thread mode).
+ */
+bool intr_in_isr(void)
+{
+	return GET_SCB_ICSR_VECTACTIVE(SCB->ICSR) != 0;
+}
+
 /**
  * Set the vector table entry for [irq] to point to an interrupt service
  * routine, configure that interrupt's priority, and enable that interrupt.
@@ -0,0 +1,232 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Streams trace data out of the SWO pin using the Instrumentation Trace
+ * Macrocell (ITM).
+ *
+ * A write to an ITM stimulus port is just a store into the ITM's FIFO, which
+ * the hardware then shifts out of the SWO pin on its own. That makes this a much
+ * cheaper output path than semihosting (which halts the CPU until the debugger
+ * has handled the request). Each kind of trace data gets its own stimulus port
+ * so the SWO viewer on the host can separate them:
+ *
+ * - ITM_PORT_TEXT:     Log output. With ENABLE_LOG_RING set, the log ring gets
+ *                      drained into this port instead of semihosting.
+ * - ITM_PORT_SCHED:    One 32-bit word per context switch.
+ * - ITM_PORT_COUNTERS: User counters (one port per counter) for plotting
+ *                      values over time.
+ *
+ * Scheduler events and counters are written from time-critical code, so they
+ * are dropped (and counted) instead of waiting when the FIFO is full. ITM local
+ * timestamps are enabled so the host can tell when each packet was written.
+ */
+#include "config.h"
+#include "debug.h"
+#include "gpio.h"
+#include "interrupt.h"
+#include "itm.h"
+#include "os/log.h"
+
+#include "registers/dwt_reg.h"
+#include "registers/itm_reg.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if ENABLE_ITM
+
+_Static_assert((ITM_PORT_COUNTERS + ITM_NUM_COUNTERS) <= ITM_NUM_PORTS,
+               "Not enough stimulus ports for the user counters");
+
+/* Every stimulus port used by this module. */
+#define ITM_ENABLED_PORTS ((1UL << ITM_PORT_TEXT) | \
+                           (1UL << ITM_PORT_SCHED) | \
+                           (((1UL << ITM_NUM_COUNTERS) - 1U) << ITM_PORT_COUNTERS))
+
+/* Trace bus ID the ITM's packets get tagged with (must be non-zero). */
+#define ITM_TRACE_BUS_ID 1U
+
+/* Number of scheduler events and counter values dropped due to a full FIFO. */
+static uint32_t num_dropped = 0;
+
+/**
+ * Route the ITM's output out of the SWO pin and enable the stimulus ports used
+ * by this module. The log ring (if enabled) gets redirected to the text port.
+ */
+void itm_init(void)
+{
+	/* The SWO pin is alternate function 0 (and that's its reset state as well). */
+	gpio_request_alt(GPIO_SWO, AF0, GPIO_OSPEED_100MHZ);
+
+	/* Enable the trace pins in asynchronous (SWO) mode. */
+	DBGMCU->CR = (DBGMCU->CR & ~(DBGMCU_CR_TRACE_IOEN() | DBGMCU_CR_TRACE_MODE())) |
+	             DBGMCU_CR_TRACE_IOEN() |
+	             SET_DBGMCU_CR_TRACE_MODE(DBGMCU_TRACE_MODE_ASYNC);
+
+	/* The trace unit has to be enabled before any ITM or TPIU register can be written. */
+	SET_FIELD(COREDEBUG->DEMCR, COREDEBUG_DEMCR_TRCENA());
+
+	/**
+	 * Send the trace data out over SWO as NRZ (UART-style) at ITM_SWO_BAUD.
+	 * The formatter is only needed for the parallel trace port, so bypass it.
+	 */
+	TPI->SPPR = SET_TPI_SPPR_TXMODE(TPI_TXMODE_NRZ);
+	TPI->ACPR = SET_TPI_ACPR_PRESCALER((CPU_HZ / ITM_SWO_BAUD) - 1U);
+	TPI->FFCR = TPI_FFCR_TRIGIN();
+
+	ITM->LAR = ITM_LAR_UNLOCK;
+	ITM->TCR = SET_ITM_TCR_TRACEBUSID(ITM_TRACE_BUS_ID) |
+	           ITM_TCR_SWOENA() |
+	           ITM_TCR_SYNCENA() |
+	           ITM_TCR_TSENA() |
+	           ITM_TCR_ITMENA();
+
+	/* Let unprivileged code write the ports too. */
+	ITM->TPR = 0;
+	ITM->TER = ITM_ENABLED_PORTS;
+
+#if ENABLE_LOG_RING
+	log_set_output(itm_log_output);
+#endif /* ENABLE_LOG_RING */
+}
+
+/**
+ * @return True if the ITM and the given stimulus port are both enabled. Writes
+ *         to a disabled port are ignored (and it never reports being ready).
+ */
+static inline bool _port_enabled(uint32_t port)
+{
+	return (ITM->TCR & ITM_TCR_ITMENA()) && (ITM->TER & (1UL << port));
+}
+
+/**
+ * Write a buffer out of a stimulus port, waiting for room in the FIFO as
+ * needed. Data is sent as 32-bit packets where possible.
+ *
+ * @param port The stimulus port to write to.
+ * @param data The data to send.
+ * @param len The number of bytes to send.
+ */
+void itm_write(uint32_t port, const void *data, size_t len)
+{
+	ASSERT(port < ITM_NUM_PORTS);
+
+	if(!_port_enabled(port)) {
+		return;
+	}
+
+	const uint8_t *bytes = (const uint8_t*)data;
+	ItmStimulusPort *const stim = &ITM->PORT[port];
+
+	while(len >= sizeof(uint32_t)) {
+		uint32_t word;
+		memcpy(&word, bytes, sizeof(word));
+
+		while(stim->u32 == 0) { }
+		stim->u32 = word;
+
+		bytes += sizeof(word);
+		len -= sizeof(word);
+	}
+
+	while(len > 0) {
+		while(stim->u32 == 0) { }
+		stim->u8 = *bytes++;
+		len--;
+	}
+}
+
+/**
+ * Write a single 32-bit packet out of a stimulus port without waiting. If the
+ * FIFO is full, the value gets dropped.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param port The stimulus port to write to.
+ * @param value The value to send.
+ *
+ * @return True if the value was written, false if it was dropped.
+ */
+bool itm_try_write32(uint32_t port, uint32_t value)
+{
+	ASSERT(port < ITM_NUM_PORTS);
+
+	if(!_port_enabled(port)) {
+		return false;
+	}
+
+	/**
+	 * Checking the FIFO and writing to it has to happen atomically, otherwise
+	 * an ISR could fill the FIFO back up in between.
+	 */
+	const uint32_t primask = intr_enter_critical();
+	const bool ready = (ITM->PORT[port].u32 != 0);
+
+	if(ready) {
+		ITM->PORT[port].u32 = value;
+	}
+
+	intr_exit_critical(primask);
+
+	if(!ready) {
+		__atomic_fetch_add(&num_dropped, 1U, __ATOMIC_RELAXED);
+	}
+
+	return ready;
+}
+
+/**
+ * Log ring output function (see log_set_output()) that sends log data out of
+ * the text port.
+ */
+void itm_log_output(const char *data, size_t len)
+{
+	itm_write(ITM_PORT_TEXT, data, len);
+}
+
+/**
+ * Send a context switch event out of the scheduler port. Each event is a
+ * single word with the same layout as bytes 4-7 of a sched_trace_event_t:
+ * the "from" task ID in bits 0-7, "to" in bits 8-15, and the reason in bits
+ * 16-23.
+ *
+ * @note Called from the context switch handler.
+ *
+ * @param from ID of the task being switched out.
+ * @param to ID of the task being switched to.
+ * @param reason The sched_reason_t for the switch.
+ */
+void itm_sched_event(uint8_t from, uint8_t to, uint8_t reason)
+{
+	itm_try_write32(ITM_PORT_SCHED, (uint32_t)from | ((uint32_t)to << 8) | ((uint32_t)reason << 16));
+}
+
+/**
+ * Send the current value of a user counter out of its port. This is meant for
+ * watching values (queue depths, byte counts, etc.) change over time.
+ *
+ * @note Safe to call from ISRs.
+ *
+ * @param counter Which counter this is (less than ITM_NUM_COUNTERS).
+ * @param value The counter's current value.
+ */
+void itm_counter(uint32_t counter, uint32_t value)
+{
+	ASSERT(counter < ITM_NUM_COUNTERS);
+
+	itm_try_write32(ITM_PORT_COUNTERS + counter, value);
+}
+
+/**
+ * @return The number of scheduler events and counter values that were dropped
+ *         because the ITM FIFO was full.
+ */
+uint32_t itm_get_dropped(void)
+{
+	return __atomic_load_n(&num_dropped, __ATOMIC_RELAXED);
+}
+
+#endif /* ENABLE_ITM */
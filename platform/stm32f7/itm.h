@@ -0,0 +1,38 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Streams trace data out of the SWO pin using the Instrumentation Trace
+ * Macrocell (ITM).
+ */
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Stimulus ports used for each kind of trace data. Point the SWO viewer at the
+ * port(s) of interest.
+ */
+#define ITM_PORT_TEXT     0U /* Log output (see os/log.h) */
+#define ITM_PORT_SCHED    1U /* Context switch events (see itm_sched_event()) */
+#define ITM_PORT_COUNTERS 8U /* First user counter port (see itm_counter()) */
+
+/* Number of user counters (each one gets its own port). */
+#define ITM_NUM_COUNTERS 8U
+
+#if ENABLE_ITM
+void itm_init(void);
+
+void itm_write(uint32_t port, const void *data, size_t len);
+bool itm_try_write32(uint32_t port, uint32_t value);
+
+void itm_log_output(const char *data, size_t len);
+void itm_sched_event(uint8_t from, uint8_t to, uint8_t reason);
+void itm_counter(uint32_t counter, uint32_t value);
+
+uint32_t itm_get_dropped(void);
+#endif /* ENABLE_ITM */
@@ -0,0 +1,71 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Contains methods for configuring the Memory Protection Unit.
+ */
+#include "config.h"
+#include "debug.h"
+#include "mpu.h"
+#include "system.h"
+
+#include "registers/mpu_reg.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Enable the MPU. Privileged code keeps using the default memory map for any
+ * address that isn't covered by an enabled region, so this only changes the
+ * behavior of the regions that have been explicitly configured.
+ */
+void mpu_enable(void)
+{
+	ABORT_IF(GET_MPU_TYPE_DREGION(MPU->TYPE) == 0);
+
+	MPU->CTRL = MPU_CTRL_ENABLE() | MPU_CTRL_PRIVDEFENA();
+
+	/* Ensure the new memory map is used by every following access. */
+	DSB();
+	ISB();
+}
+
+/**
+ * Configure a region that will generate a MemManage fault whenever it's written
+ * to. Reads are still permitted. Typically used to catch a stack overflowing
+ * past the bottom of its stack.
+ *
+ * @param region The MPU region number to (re)configure. Higher region numbers
+ *               take priority where regions overlap.
+ * @param base The starting address of the region. Must be aligned to [size].
+ * @param size The size of the region in bytes. Must be a power of two that's
+ *             at least 32 bytes.
+ */
+void mpu_set_guard_region(uint8_t region, uintptr_t base, size_t size)
+{
+	ASSERT(region < GET_MPU_TYPE_DREGION(MPU->TYPE));
+	ASSERT((size >= 32) && ((size & (size - 1)) == 0));
+	ASSERT((base & (size - 1)) == 0);
+
+	/* The SIZE field encodes the region size as 2^(SIZE + 1) bytes. */
+	const uint32_t size_field = (uint32_t)__builtin_ctz(size) - 1;
+
+	MPU->RNR = SET_MPU_RNR_REGION(region);
+	MPU->RBAR = base;
+
+	/**
+	 * Use the same memory attributes as the default memory map for SRAM
+	 * (Normal memory, write-back, write and read allocate) so that guarding
+	 * the region doesn't change how the cache treats it.
+	 */
+	MPU->RASR = SET_MPU_RASR_AP(MPU_AP_PRIV_RO) |
+	            MPU_RASR_XN() |
+	            SET_MPU_RASR_TEX(0x1) |
+	            MPU_RASR_C() |
+	            MPU_RASR_B() |
+	            SET_MPU_RASR_SIZE(size_field) |
+	            MPU_RASR_ENABLE();
+
+	DSB();
+	ISB();
+}
@@ -0,0 +1,63 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Definitions and functions used to manipulate the Data Watchpoint and Trace
+ * (DWT) unit and the Core Debug registers needed to enable it.
+ */
+#pragma once
+
+#include "bitfield.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+/* Type defining the DWT module register map. */
+typedef struct
+{
+	volatile uint32_t CTRL;      /*!< Offset: 0x000 (R/W) Control Register */
+	volatile uint32_t CYCCNT;    /*!< Offset: 0x004 (R/W) Cycle Count Register */
+	volatile uint32_t CPICNT;    /*!< Offset: 0x008 (R/W) CPI Count Register */
+	volatile uint32_t EXCCNT;    /*!< Offset: 0x00C (R/W) Exception Overhead Count Register */
+	volatile uint32_t SLEEPCNT;  /*!< Offset: 0x010 (R/W) Sleep Count Register */
+	volatile uint32_t LSUCNT;    /*!< Offset: 0x014 (R/W) LSU Count Register */
+	volatile uint32_t FOLDCNT;   /*!< Offset: 0x018 (R/W) Folded-instruction Count Register */
+	volatile uint32_t PCSR;      /*!< Offset: 0x01C (R/ ) Program Counter Sample Register */
+	uint32_t RESERVED0[1004U];
+	volatile uint32_t LAR;       /*!< Offset: 0xFB0 ( /W) Lock Access Register */
+	volatile uint32_t LSR;       /*!< Offset: 0xFB4 (R/ ) Lock Status Register */
+} DwtReg;
+
+/* Define the DWT register map accessor. */
+#define DWT ((DwtReg *) DWT_BASE)
+
+/* Value to write into the Lock Access Register to unlock the DWT registers. */
+#define DWT_LAR_UNLOCK 0xC5ACCE55U
+
+/* DWT Control Register. */
+BIT_FIELD2(DWT_CTRL_CYCCNTENA,    0, 0);
+BIT_FIELD2(DWT_CTRL_CPIEVTENA,   17, 17);
+BIT_FIELD2(DWT_CTRL_EXCEVTENA,   18, 18);
+BIT_FIELD2(DWT_CTRL_SLEEPEVTENA, 19, 19);
+BIT_FIELD2(DWT_CTRL_LSUEVTENA,   20, 20);
+BIT_FIELD2(DWT_CTRL_FOLDEVTENA,  21, 21);
+BIT_FIELD2(DWT_CTRL_NOCYCCNT,    25, 25);
+BIT_FIELD2(DWT_CTRL_NUMCOMP,     28, 31);
+
+/* Type defining the Core Debug register map. */
+typedef struct
+{
+	volatile uint32_t DHCSR; /*!< Offset: 0x000 (R/W) Debug Halting Control and Status Register */
+	volatile uint32_t DCRSR; /*!< Offset: 0x004 ( /W) Debug Core Register Selector Register */
+	volatile uint32_t DCRDR; /*!< Offset: 0x008 (R/W) Debug Core Register Data Register */
+	volatile uint32_t DEMCR; /*!< Offset: 0x00C (R/W) Debug Exception and Monitor Control Register */
+} CoreDebugReg;
+
+/* Define the Core Debug register map accessor. */
+#define COREDEBUG ((CoreDebugReg *) CoreDebug_BASE)
+
+/* Debug Halting Control and Status Register. */
+BIT_FIELD2(COREDEBUG_DHCSR_C_DEBUGEN, 0, 0);
+
+/* Debug Exception and Monitor Control Register. */
+BIT_FIELD2(COREDEBUG_DEMCR_TRCENA, 24, 24);
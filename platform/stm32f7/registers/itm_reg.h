@@ -0,0 +1,118 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Definitions and functions used to manipulate the Instrumentation Trace
+ * Macrocell (ITM), the Trace Port Interface Unit (TPIU) that sends its output
+ * out of the SWO pin, and the debug MCU configuration register that enables
+ * the trace pins.
+ */
+#pragma once
+
+#include "bitfield.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+/**
+ * A single stimulus port. Writing to a port queues up a packet of the written
+ * size (8, 16, or 32 bits). Reading a port returns 1 if its FIFO can accept
+ * another write.
+ */
+typedef union {
+	volatile uint8_t u8;
+	volatile uint16_t u16;
+	volatile uint32_t u32;
+} ItmStimulusPort;
+
+/* Number of ITM stimulus ports. */
+#define ITM_NUM_PORTS 32U
+
+/* Type defining the ITM module register map. */
+typedef struct
+{
+	ItmStimulusPort PORT[ITM_NUM_PORTS]; /*!< Offset: 0x000 ( /W) Stimulus Port Registers */
+	uint32_t RESERVED0[864U];
+	volatile uint32_t TER;               /*!< Offset: 0xE00 (R/W) Trace Enable Register */
+	uint32_t RESERVED1[15U];
+	volatile uint32_t TPR;               /*!< Offset: 0xE40 (R/W) Trace Privilege Register */
+	uint32_t RESERVED2[15U];
+	volatile uint32_t TCR;               /*!< Offset: 0xE80 (R/W) Trace Control Register */
+	uint32_t RESERVED3[75U];
+	volatile uint32_t LAR;               /*!< Offset: 0xFB0 ( /W) Lock Access Register */
+	volatile uint32_t LSR;               /*!< Offset: 0xFB4 (R/ ) Lock Status Register */
+} ItmReg;
+
+/* Define the ITM register map accessor. */
+#define ITM ((ItmReg *) ITM_BASE)
+
+/* Value to write into the Lock Access Register to unlock the ITM registers. */
+#define ITM_LAR_UNLOCK 0xC5ACCE55U
+
+/* Trace Control Register. */
+BIT_FIELD2(ITM_TCR_ITMENA,      0, 0);
+BIT_FIELD2(ITM_TCR_TSENA,       1, 1);
+BIT_FIELD2(ITM_TCR_SYNCENA,     2, 2);
+BIT_FIELD2(ITM_TCR_TXENA,       3, 3);
+BIT_FIELD2(ITM_TCR_SWOENA,      4, 4);
+BIT_FIELD2(ITM_TCR_TSPRESCALE,  8, 9);
+BIT_FIELD2(ITM_TCR_TRACEBUSID, 16, 22);
+BIT_FIELD2(ITM_TCR_BUSY,       23, 23);
+
+/* Type defining the TPIU module register map. */
+typedef struct
+{
+	volatile uint32_t SSPSR;  /*!< Offset: 0x000 (R/ ) Supported Parallel Port Size Register */
+	volatile uint32_t CSPSR;  /*!< Offset: 0x004 (R/W) Current Parallel Port Size Register */
+	uint32_t RESERVED0[2U];
+	volatile uint32_t ACPR;   /*!< Offset: 0x010 (R/W) Asynchronous Clock Prescaler Register */
+	uint32_t RESERVED1[55U];
+	volatile uint32_t SPPR;   /*!< Offset: 0x0F0 (R/W) Selected Pin Protocol Register */
+	uint32_t RESERVED2[131U];
+	volatile uint32_t FFSR;   /*!< Offset: 0x300 (R/ ) Formatter and Flush Status Register */
+	volatile uint32_t FFCR;   /*!< Offset: 0x304 (R/W) Formatter and Flush Control Register */
+} TpiReg;
+
+/* Define the TPIU register map accessor. */
+#define TPI ((TpiReg *) TPI_BASE)
+
+/* Asynchronous Clock Prescaler Register (SWO baud = TRACECLKIN / (PRESCALER + 1)). */
+BIT_FIELD2(TPI_ACPR_PRESCALER, 0, 12);
+
+/* Selected Pin Protocol Register. */
+BIT_FIELD2(TPI_SPPR_TXMODE, 0, 1);
+
+/* TPI_SPPR_TXMODE (Trace output protocol) field options. */
+typedef enum {
+	TPI_TXMODE_PARALLEL = 0,
+	TPI_TXMODE_MANCHESTER = 1,
+	TPI_TXMODE_NRZ = 2
+} TpiTxMode;
+
+/* Formatter and Flush Control Register. */
+BIT_FIELD2(TPI_FFCR_ENFCONT, 1, 1);
+BIT_FIELD2(TPI_FFCR_TRIGIN,  8, 8);
+
+/* Type defining the debug MCU module register map. */
+typedef struct
+{
+	volatile uint32_t IDCODE; /*!< Offset: 0x000 (R/ ) MCU Device ID Code Register */
+	volatile uint32_t CR;     /*!< Offset: 0x004 (R/W) Debug MCU Configuration Register */
+	volatile uint32_t APB1FZ; /*!< Offset: 0x008 (R/W) Debug MCU APB1 Freeze Register */
+	volatile uint32_t APB2FZ; /*!< Offset: 0x00C (R/W) Debug MCU APB2 Freeze Register */
+} DbgmcuReg;
+
+/* Define the debug MCU register map accessor. */
+#define DBGMCU ((DbgmcuReg *) DBGMCU_BASE)
+
+/* Debug MCU Configuration Register. */
+BIT_FIELD2(DBGMCU_CR_TRACE_IOEN, 5, 5);
+BIT_FIELD2(DBGMCU_CR_TRACE_MODE, 6, 7);
+
+/* DBGMCU_CR_TRACE_MODE (Trace pin assignment) field options. */
+typedef enum {
+	DBGMCU_TRACE_MODE_ASYNC = 0,
+	DBGMCU_TRACE_MODE_SYNC1 = 1,
+	DBGMCU_TRACE_MODE_SYNC2 = 2,
+	DBGMCU_TRACE_MODE_SYNC4 = 3
+} DbgmcuTraceMode;
@@ -0,0 +1,74 @@
+/**
+ * @author Devon Andrade
+ * @created 10/18/2026
+ *
+ * Definitions and functions used to manipulate the Memory Protection Unit (MPU).
+ */
+#pragma once
+
+#include "bitfield.h"
+#include "mem_map.h"
+
+#include <stdint.h>
+
+/**
+ * Type defining the Memory Protection Unit register map.
+ */
+typedef struct
+{
+	volatile uint32_t TYPE;    /*!< Offset: 0x000 (R/ ) MPU Type Register */
+	volatile uint32_t CTRL;    /*!< Offset: 0x004 (R/W) MPU Control Register */
+	volatile uint32_t RNR;     /*!< Offset: 0x008 (R/W) MPU Region Number Register */
+	volatile uint32_t RBAR;    /*!< Offset: 0x00C (R/W) MPU Region Base Address Register */
+	volatile uint32_t RASR;    /*!< Offset: 0x010 (R/W) MPU Region Attribute and Size Register */
+	volatile uint32_t RBAR_A1; /*!< Offset: 0x014 (R/W) MPU Alias 1 Region Base Address Register */
+	volatile uint32_t RASR_A1; /*!< Offset: 0x018 (R/W) MPU Alias 1 Region Attribute and Size Register */
+	volatile uint32_t RBAR_A2; /*!< Offset: 0x01C (R/W) MPU Alias 2 Region Base Address Register */
+	volatile uint32_t RASR_A2; /*!< Offset: 0x020 (R/W) MPU Alias 2 Region Attribute and Size Register */
+	volatile uint32_t RBAR_A3; /*!< Offset: 0x024 (R/W) MPU Alias 3 Region Base Address Register */
+	volatile uint32_t RASR_A3; /*!< Offset: 0x028 (R/W) MPU Alias 3 Region Attribute and Size Register */
+} MpuReg;
+
+/**
+ * Define the MPU register map accessor.
+ */
+#define MPU ((MpuReg *) MPU_BASE)
+
+/* MPU Type Register. */
+BIT_FIELD2(MPU_TYPE_SEPARATE,  0, 0);
+BIT_FIELD2(MPU_TYPE_DREGION,   8, 15);
+BIT_FIELD2(MPU_TYPE_IREGION,  16, 23);
+
+/* MPU Control Register. */
+BIT_FIELD2(MPU_CTRL_ENABLE,     0, 0);
+BIT_FIELD2(MPU_CTRL_HFNMIENA,   1, 1);
+BIT_FIELD2(MPU_CTRL_PRIVDEFENA, 2, 2);
+
+/* MPU Region Number Register. */
+BIT_FIELD2(MPU_RNR_REGION, 0, 7);
+
+/* MPU Region Base Address Register. */
+BIT_FIELD2(MPU_RBAR_REGION, 0, 3);
+BIT_FIELD2(MPU_RBAR_VALID,  4, 4);
+BIT_FIELD2(MPU_RBAR_ADDR,   5, 31);
+
+/* MPU Region Attribute and Size Register. */
+BIT_FIELD2(MPU_RASR_ENABLE,  0, 0);
+BIT_FIELD2(MPU_RASR_SIZE,    1, 5);
+BIT_FIELD2(MPU_RASR_SRD,     8, 15);
+BIT_FIELD2(MPU_RASR_B,      16, 16);
+BIT_FIELD2(MPU_RASR_C,      17, 17);
+BIT_FIELD2(MPU_RASR_S,      18, 18);
+BIT_FIELD2(MPU_RASR_TEX,    19, 21);
+BIT_FIELD2(MPU_RASR_AP,     24, 26);
+BIT_FIELD2(MPU_RASR_XN,     28, 28);
+
+/* Values for the RASR.AP (Access Permission) field. */
+typedef enum {
+	MPU_AP_NO_ACCESS = 0,
+	MPU_AP_PRIV_RW = 1,
+	MPU_AP_PRIV_RW_UNPRIV_RO = 2,
+	MPU_AP_FULL_ACCESS = 3,
+	MPU_AP_PRIV_RO = 5,
+	MPU_AP_READ_ONLY = 6
+} mpu_access_t;
@@ -84,6 +84,11 @@ BIT_FIELD2(SCB_ICSR_PENDSVCLR,   27, 27);
 BIT_FIELD2(SCB_ICSR_PENDSVSET,   28, 28);
 BIT_FIELD2(SCB_ICSR_NMIPENDSET,  31, 31);
 
+/* System Control Register. */
+BIT_FIELD(SCB_SCR_SLEEPONEXIT, 1, 0x00000002);
+BIT_FIELD(SCB_SCR_SLEEPDEEP,   2, 0x00000004);
+BIT_FIELD(SCB_SCR_SEVONPEND,   4, 0x00000010);
+
 /* Configuration and Control Register. */
 BIT_FIELD(SCB_CCR_NONBASETHRDENA, 0, 0x00000001);
 BIT_FIELD(SCB_CCR_USERSETMPEND,   1, 0x00000002);
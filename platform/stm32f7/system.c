@@ -8,6 +8,7 @@
 #include "config.h"
 #include "debug.h"
 #include "interrupt.h"
+#include "itm.h"
 #include "system.h"
 #include "system_timer.h"
 
@@ -17,6 +18,9 @@
 #include "registers/scb_reg.h"
 #include "registers/rcc_reg.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef SEMIHOSTING_ENABLED
 /**
  * This method is provided by the rdimon library for initializing semihosting
@@ -28,9 +32,9 @@ extern void initialise_monitor_handles(void);
 #if OS_ENABLED
 /**
  * Stack used by the init/idle thread.The ARM Procedure Call Standard requires
- * 8-byte alignment for stacks.
+ * 8-byte alignment for stacks (more if the MPU stack guard is enabled).
  */
-uint8_t init_stack[INIT_THREAD_STACK_SIZE] __attribute__ ((aligned (8))) = { 0 };
+uint8_t init_stack[INIT_THREAD_STACK_SIZE] __attribute__ ((aligned (STACK_ALIGNMENT))) = { 0 };
 #endif /* OS_ENABLED */
 
 /**
@@ -56,7 +60,7 @@ void setup_initial_process_stack(void)
 		 * the stack, not the top.
 		 */
 	#if ENABLE_STACK_GUARD
-		"str	%[stack_guard_magic], [%[stack_addr]] \n"
+		"strb	%[stack_guard_magic], [%[stack_addr]] \n"
 	#endif /* ENABLE_STACK_GUARD */
 		"add	%[stack_addr], %[stack_addr], %[stack_size] \n"
 
@@ -111,6 +115,57 @@ static void caches_init(void)
 	ISB();
 }
 
+/**
+ * Write any dirty data cache lines covering a buffer back to memory. Needed
+ * before a DMA controller reads a buffer the CPU wrote through the cache.
+ *
+ * @param addr Start of the buffer.
+ * @param len Length of the buffer in bytes.
+ */
+void dcache_clean(const void *addr, size_t len)
+{
+	if(len == 0) {
+		return;
+	}
+
+	uintptr_t line = (uintptr_t)addr & ~(uintptr_t)(DCACHE_LINE_SIZE - 1);
+	const uintptr_t end = (uintptr_t)addr + len;
+
+	DSB();
+	for(; line < end; line += DCACHE_LINE_SIZE) {
+		SCB->DCCMVAC = line;
+	}
+	DSB();
+}
+
+/**
+ * Discard any data cache lines covering a buffer so the next read comes from
+ * memory. Needed before the CPU reads a buffer a DMA controller wrote.
+ *
+ * @note Whole cache lines get discarded, so any other data sharing the first
+ *       or last line of the buffer loses its unwritten changes. DMA buffers
+ *       should be aligned to, and sized in multiples of, DCACHE_LINE_SIZE.
+ *
+ * @param addr Start of the buffer.
+ * @param len Length of the buffer in bytes.
+ */
+void dcache_invalidate(void *addr, size_t len)
+{
+	if(len == 0) {
+		return;
+	}
+
+	uintptr_t line = (uintptr_t)addr & ~(uintptr_t)(DCACHE_LINE_SIZE - 1);
+	const uintptr_t end = (uintptr_t)addr + len;
+
+	DSB();
+	for(; line < end; line += DCACHE_LINE_SIZE) {
+		SCB->DCIMVAC = line;
+	}
+	DSB();
+	ISB();
+}
+
 #if FPU_ENABLED
 static void floating_point_init(void)
 {
@@ -257,4 +312,8 @@ void system_init(void)
 	clocks_init();
 	intr_init();
 	system_timer_init();
+
+#if ENABLE_ITM
+	itm_init();
+#endif /* ENABLE_ITM */
 }
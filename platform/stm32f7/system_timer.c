@@ -6,30 +6,23 @@
  * timer common to all ARM microcontrollers).
  */
 /**
- * Design Proposal: Blocking Timer Events in a Multitasking Environment
+ * Blocking Timer Events in a Multitasking Environment
  *
- * This timer module can be modified in the future to take tasks and put them
- * to sleep until a specific number of cycles has elapsed.
- *
- * This would involve having a static array of timer_event_t structures, each
- * of which contains a pointer to the task_t structure and the cycle count at
- * which to wake the process up.
- *
- * The sleep(task, timeout_in_cycles) function will take the task off of the
- * running queue, enter it into the timer_event_t queue (the final cycle
- * count would be timeout_in_cycles + current_cycles), and yield to the
- * scheduler.
- *
- * In the systick_interrupt (which gets triggered on the tick granularity) every
- * timer event that's queued will be checked to see if that event elapsed. If it
- * did, it will take the item off of the queue and put the task back onto the
- * running queue.
+ * When software timers are enabled, sleep() called from a task will block that
+ * task on a software timer (see os/sw_timer.c) so other tasks can run. The
+ * systick_interrupt advances the software timers' timing wheel, which wakes
+ * the task back up once the timer expires.
  */
 #include "config.h"
 #include "debug.h"
 #include "interrupt.h"
+#include "os/sw_timer.h"
+#include "os/task.h"
+#include "system.h"
 #include "system_timer.h"
 
+#include "registers/dwt_reg.h"
+#include "registers/scb_reg.h"
 #include "registers/systick_reg.h"
 
 #include <stdbool.h>
@@ -47,6 +40,13 @@ void systick_interrupt(void);
 
 static volatile uint64_t total_cycles = 0;
 
+/**
+ * The number of cycles the SysTick timer is counting down for during the
+ * current period. This is always SYSTIMER_TICK except while the CPU is idling
+ * in system_timer_idle_until() with a stretched out period.
+ */
+static volatile uint32_t current_period = SYSTIMER_TICK;
+
 /**
  * Initialize the system timer to update the `total_cycles` count during each
  * SYSTIMER_TICK granularity defined in the config file.
@@ -65,15 +65,119 @@ void system_timer_init(void)
 	SYSTICK->LOAD = SET_SYSTICK_LOAD_RELOAD(SYSTIMER_TICK);
 	SYSTICK->VAL = 0;
 
+	/**
+	 * Idling uses the regular "Sleep" mode. The SysTick timer stops counting
+	 * in "Stop" mode (deep sleep) which would throw off the cycle count.
+	 */
+	CLEAR_FIELD(SCB->SCR, SCB_SCR_SLEEPDEEP());
+
+	SET_FIELD(SYSTICK->CTRL, SYSTICK_CTRL_ENABLE());
+
+	/**
+	 * Start the free-running DWT cycle counter as well. The trace unit has to be
+	 * enabled (and unlocked) before any DWT register can be written.
+	 */
+	SET_FIELD(COREDEBUG->DEMCR, COREDEBUG_DEMCR_TRCENA());
+	DWT->LAR = DWT_LAR_UNLOCK;
+	DWT->CYCCNT = 0;
+	SET_FIELD(DWT->CTRL, DWT_CTRL_CYCCNTENA());
+}
+
+/**
+ * Put the CPU to sleep (WFI) until `target_cycles` is reached or some other
+ * interrupt wakes it up first, whichever comes first. Instead of waking up
+ * every tick, the SysTick period is stretched out to the deadline (up to
+ * SYSTICK_MAX_TICKS) and the cycle count is corrected upon wakeup.
+ *
+ * This returns immediately (without sleeping) if the deadline is closer than
+ * TICKLESS_MIN_IDLE_CYCLES, if tickless idle is disabled, or if called from an
+ * exception handler (the SysTick interrupt couldn't preempt it to update the
+ * cycle count). Callers are expected to loop on get_cycles() to cover those
+ * cases as well as early wakeups.
+ *
+ * @note This must be called with interrupts enabled. Interrupts are masked
+ *       while idling so the timer can be fixed up before any ISR runs.
+ *
+ * @param target_cycles The absolute cycle count (as returned by get_cycles())
+ *                      to wake up at.
+ */
+void system_timer_idle_until(uint64_t target_cycles)
+{
+#if ENABLE_TICKLESS_IDLE
+	if(GET_SCB_ICSR_VECTACTIVE(SCB->ICSR) != 0) {
+		return;
+	}
+
+	intr_disable_interrupts();
+
+	const uint64_t now = get_cycles();
+	if(target_cycles <= (now + TICKLESS_MIN_IDLE_CYCLES)) {
+		intr_enable_interrupts();
+		return;
+	}
+
+	uint64_t idle_cycles = target_cycles - now;
+	if(idle_cycles > SYSTICK_MAX_TICKS) {
+		idle_cycles = SYSTICK_MAX_TICKS;
+	}
+
+	/**
+	 * Stop the timer and fold the partial tick that has already elapsed into
+	 * the total. If the tick just expired then its interrupt is pending and
+	 * will do the accounting itself, so don't bother idling this time around.
+	 */
+	CLEAR_FIELD(SYSTICK->CTRL, SYSTICK_CTRL_ENABLE());
+	if(GET_SCB_ICSR_PENDSTSET(SCB->ICSR)) {
+		SET_FIELD(SYSTICK->CTRL, SYSTICK_CTRL_ENABLE());
+		intr_enable_interrupts();
+		return;
+	}
+
+	total_cycles += current_period - GET_SYSTICK_VAL_CURRENT(SYSTICK->VAL);
+	current_period = (uint32_t)idle_cycles;
+
+	SYSTICK->LOAD = SET_SYSTICK_LOAD_RELOAD(current_period);
+	SYSTICK->VAL = 0;
+	SET_FIELD(SYSTICK->CTRL, SYSTICK_CTRL_ENABLE());
+
+	/**
+	 * A new reload value only takes effect the next time the counter wraps.
+	 * Once the counter has picked up the stretched period, queue up the regular
+	 * tick so the timer automatically goes back to normal once the deadline
+	 * expires (systick_interrupt() takes care of the accounting).
+	 */
+	while(GET_SYSTICK_VAL_CURRENT(SYSTICK->VAL) == 0) { }
+	SYSTICK->LOAD = SET_SYSTICK_LOAD_RELOAD(SYSTIMER_TICK);
+
+	DSB();
+	WFI();
+	ISB();
+
+	/**
+	 * If some other interrupt woke the CPU before the deadline, fold the cycles
+	 * spent idling into the total and restart the regular tick.
+	 */
+	CLEAR_FIELD(SYSTICK->CTRL, SYSTICK_CTRL_ENABLE());
+	if(!GET_SCB_ICSR_PENDSTSET(SCB->ICSR)) {
+		total_cycles += current_period - GET_SYSTICK_VAL_CURRENT(SYSTICK->VAL);
+		current_period = SYSTIMER_TICK;
+		SYSTICK->VAL = 0;
+	}
 	SET_FIELD(SYSTICK->CTRL, SYSTICK_CTRL_ENABLE());
+
+	intr_enable_interrupts();
+#else
+	(void)target_cycles;
+#endif /* ENABLE_TICKLESS_IDLE */
 }
 
 /**
  * Sleep for at least (but maybe more) `cycles` number of CPU cycles.
  *
- * This currently just spins, but in a multitasking environment this function
- * can be modified to take the task off of the running queue until the number
- * of cycles has elapsed. See the design proposal at the top of this file.
+ * When called from a task (other than the idle task), sleeps of at least one
+ * tick block the task until the time has elapsed. Otherwise, long sleeps put
+ * the CPU into a low-power tickless idle (see system_timer_idle_until()) while
+ * short sleeps just spin.
  *
  * @note This is not meant for cycle-accurate timing. There will be overhead
  *       associated with setup and interrupt processing that isn't accounted
@@ -89,6 +193,28 @@ void sleep(uint64_t cycles)
 {
 	const uint64_t target_cycles = get_cycles() + cycles;
 
+#if ENABLE_SW_TIMERS
+	if((cycles >= SYSTIMER_TICK) && task_can_block()) {
+		sw_timer_sleep_until(target_cycles);
+	}
+#endif /* ENABLE_SW_TIMERS */
+
+#if ENABLE_TICKLESS_IDLE
+	while((get_cycles() + TICKLESS_MIN_IDLE_CYCLES) < target_cycles) {
+		uint64_t wake_cycles = target_cycles;
+
+#if ENABLE_SW_TIMERS
+		/* Don't sleep through the next software timer expiration. */
+		const uint64_t timer_cycles = sw_timer_next_expiry();
+		if(timer_cycles < wake_cycles) {
+			wake_cycles = timer_cycles;
+		}
+#endif /* ENABLE_SW_TIMERS */
+
+		system_timer_idle_until(wake_cycles);
+	}
+#endif /* ENABLE_TICKLESS_IDLE */
+
 	while(get_cycles() <= target_cycles);
 }
 
@@ -118,12 +244,25 @@ uint64_t get_cycles(void)
 		 * last interrupt you need to subtract the current value from the reload
 		 * value.
 		 */
-		cycles = initial_cycles + (SYSTIMER_TICK - GET_SYSTICK_VAL_CURRENT(SYSTICK->VAL));
+		cycles = initial_cycles + (current_period - GET_SYSTICK_VAL_CURRENT(SYSTICK->VAL));
 	} while (initial_cycles != total_cycles);
 
 	return cycles;
 }
 
+/**
+ * Read the free-running DWT cycle counter. This is much cheaper than
+ * get_cycles(), but wraps around every 2^32 cycles (~19.9 seconds at 216MHz)
+ * and doesn't count while the CPU is sleeping. This makes it a good fit for
+ * measuring how long code runs for, but not for keeping time.
+ *
+ * @return The current value of the cycle counter.
+ */
+uint32_t get_cycle_counter(void)
+{
+	return DWT->CYCCNT;
+}
+
 /**
  * SysTick interrupt.
  *
@@ -131,5 +270,12 @@ uint64_t get_cycles(void)
  */
 void systick_interrupt(void)
 {
-	total_cycles += SYSTIMER_TICK;
+	total_cycles += current_period;
+
+	/* The hardware already reloaded the regular tick after an idle period. */
+	current_period = SYSTIMER_TICK;
+
+#if ENABLE_SW_TIMERS
+	sw_timer_advance(total_cycles);
+#endif /* ENABLE_SW_TIMERS */
 }
@@ -24,6 +24,10 @@
 
 void system_timer_init(void);
 
+void system_timer_idle_until(uint64_t target_cycles);
+
 void sleep(uint64_t cycles);
 
 uint64_t get_cycles(void);
+
+uint32_t get_cycle_counter(void);
@@ -7,9 +7,20 @@
  */
 #pragma once
 
+#include <stddef.h>
+
 /* Helper macros for issuing barriers. */
 #define DMB() asm volatile("dmb SY" ::: "memory")
 #define DSB() asm volatile("dsb SY" ::: "memory")
 #define ISB() asm volatile("isb SY" ::: "memory")
 
+/* Put the CPU into sleep mode until the next interrupt (or debug event). */
+#define WFI() asm volatile("wfi" ::: "memory")
+
+/* Size of a data cache line (cache maintenance is done in units of lines). */
+#define DCACHE_LINE_SIZE 32U
+
 void system_init(void);
+
+void dcache_clean(const void *addr, size_t len);
+void dcache_invalidate(void *addr, size_t len);
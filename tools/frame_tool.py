@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+@author Devon Andrade
+@created 10/18/2026
+
+Host side of the framed packet layer (see drivers/frame.h).
+
+Every frame is the COBS encoding of the payload followed by its CRC-16
+(CCITT-FALSE, little endian), terminated by a zero byte.
+
+Usage:
+    frame_tool.py decode [captured_file]
+        Print the payload of every frame in a capture (or stdin) as hex.
+
+    frame_tool.py loopback <serial_port> [baud] [num_frames]
+        Send random frames to a target running frame_echo_test() and check
+        that every one of them comes back intact.
+"""
+import os
+import random
+import sys
+import time
+
+DELIMITER = 0x00
+MAX_PAYLOAD = 256
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(payload):
+    crc = crc16(payload)
+    data = bytes(payload) + bytes([crc & 0xFF, crc >> 8])
+    out = bytearray([0])
+    code_pos = 0
+
+    for byte in data:
+        if byte != 0:
+            out.append(byte)
+
+        if byte == 0 or len(out) - code_pos == 0xFF:
+            out[code_pos] = len(out) - code_pos
+            code_pos = len(out)
+            out.append(0)
+
+    out[code_pos] = len(out) - code_pos
+    out.append(DELIMITER)
+    return bytes(out)
+
+
+def decode_frame(frame):
+    """Decode a single frame (without its delimiter). Returns None if it's bad."""
+    out = bytearray()
+    i = 0
+
+    while i < len(frame):
+        code = frame[i]
+        block = frame[i + 1:i + code]
+        if code == 0 or len(block) != code - 1:
+            return None
+
+        out += block
+        i += code
+        if code != 0xFF and i < len(frame):
+            out.append(0)
+
+    if len(out) < 2:
+        return None
+
+    payload, crc = out[:-2], out[-2] | (out[-1] << 8)
+    return bytes(payload) if crc16(payload) == crc else None
+
+
+class Decoder:
+    """Splits a byte stream into frames."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad_frames = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+
+        while DELIMITER in self.buf:
+            end = self.buf.index(DELIMITER)
+            frame, self.buf = bytes(self.buf[:end]), self.buf[end + 1:]
+
+            if not frame:
+                continue
+
+            payload = decode_frame(frame)
+            if payload is None:
+                self.bad_frames += 1
+            else:
+                frames.append(payload)
+
+        return frames
+
+
+def open_serial(port, baud):
+    import termios
+    import tty
+
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+
+    attrs = termios.tcgetattr(fd)
+    speed = getattr(termios, "B%d" % baud)
+    attrs[4] = attrs[5] = speed
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 1
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def loopback(port, baud, num_frames):
+    fd = open_serial(port, baud)
+    decoder = Decoder()
+    num_bytes = 0
+    start = time.time()
+
+    for i in range(num_frames):
+        payload = bytes(random.choice((0, random.randrange(256)))
+                        for _ in range(random.randrange(MAX_PAYLOAD + 1)))
+        os.write(fd, encode(payload))
+
+        frames = []
+        deadline = time.time() + 1.0
+        while not frames and time.time() < deadline:
+            frames = decoder.feed(os.read(fd, 4096))
+
+        if frames != [payload]:
+            sys.exit("Frame %d (%d bytes) didn't come back intact" % (i, len(payload)))
+
+        num_bytes += len(payload)
+
+    elapsed = time.time() - start
+    print("%d frames (%d payload bytes) echoed in %.2fs, %.0f bytes/s, %d bad frames" %
+          (num_frames, num_bytes, elapsed, num_bytes / elapsed, decoder.bad_frames))
+
+
+def main():
+    if len(sys.argv) >= 2 and sys.argv[1] == "decode" and len(sys.argv) <= 3:
+        decoder = Decoder()
+        capture = open(sys.argv[2], "rb") if len(sys.argv) == 3 else sys.stdin.buffer
+
+        while True:
+            data = capture.read1(4096) if hasattr(capture, "read1") else capture.read(4096)
+            if not data:
+                break
+            for payload in decoder.feed(data):
+                print(payload.hex())
+
+        if decoder.bad_frames:
+            print("%d bad frames" % decoder.bad_frames, file=sys.stderr)
+    elif len(sys.argv) >= 3 and sys.argv[1] == "loopback" and len(sys.argv) <= 5:
+        baud = int(sys.argv[3]) if len(sys.argv) >= 4 else 115200
+        num_frames = int(sys.argv[4]) if len(sys.argv) == 5 else 1000
+        loopback(sys.argv[2], baud, num_frames)
+    else:
+        sys.exit(__doc__)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+/**
+ * Host-side check of the ARQ transport (drivers/arq.c). Pushes packets through
+ * a pair of ARQ connections joined by a simulated link that loses packets in
+ * both directions, and makes sure every payload comes out the other side
+ * exactly once and in order.
+ *
+ * Build and run it with: make host_test
+ */
+#include "config.h"
+#include "arq.h"
+#include "debug.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Number of packets that can be on the air in each direction of the simulated link. */
+#define ARQ_SIM_QUEUE_LEN 32U
+
+/* Number of packets sent across the simulated link in each run. */
+#define ARQ_SIM_PACKETS 1000U
+
+/* One direction of the simulated link. */
+typedef struct {
+	uint8_t data[ARQ_SIM_QUEUE_LEN][ARQ_MAX_PACKET];
+	uint8_t len[ARQ_SIM_QUEUE_LEN];
+	uint32_t head;
+	uint32_t tail;
+	uint32_t dropped;
+} ArqSimLink;
+
+static ArqSimLink arq_sim_links[2];
+static uint32_t arq_sim_seed;
+static uint32_t arq_sim_loss;
+static uint32_t arq_sim_delivered;
+
+/* Send a packet over the simulated link, which loses arq_sim_loss percent of them. */
+static void arq_sim_send(void *arg, const uint8_t *data, uint8_t len)
+{
+	ArqSimLink *const link = (ArqSimLink*)arg;
+
+	arq_sim_seed = (arq_sim_seed * 1103515245U) + 12345U;
+
+	if((((arq_sim_seed >> 16) % 100U) < arq_sim_loss) || ((link->head - link->tail) >= ARQ_SIM_QUEUE_LEN)) {
+		link->dropped++;
+		return;
+	}
+
+	const uint32_t i = link->head++ % ARQ_SIM_QUEUE_LEN;
+	memcpy(link->data[i], data, len);
+	link->len[i] = len;
+}
+
+/* Every payload starts with its own index, so they have to show up in order. */
+static void arq_sim_deliver(__unused void *arg, const uint8_t *data, __assert_only uint8_t len)
+{
+	uint32_t index;
+
+	ASSERT(len == ARQ_MAX_PAYLOAD);
+	memcpy(&index, data, sizeof(index));
+	ASSERT(index == arq_sim_delivered);
+
+	arq_sim_delivered++;
+}
+
+/* Hand everything on the air over to the end listening on the other side. */
+static void arq_sim_receive(ArqSimLink *link, ArqInst *inst, uint64_t now)
+{
+	while(link->tail != link->head) {
+		const uint32_t i = link->tail++ % ARQ_SIM_QUEUE_LEN;
+		arq_input(inst, link->data[i], link->len[i], now);
+	}
+}
+
+/**
+ * Run ARQ_SIM_PACKETS packets across a link that loses "loss" percent of them
+ * using the given window. Time is simulated too: each step of the loop is one
+ * "cycle" and packets take a step to cross the link.
+ */
+static void arq_sim_run(uint8_t window, uint32_t loss)
+{
+	static ArqInst sender;
+	static ArqInst receiver;
+
+	const ArqConfig config = {
+		.window = window,
+		.retransmit_timeout = 20,
+		.ack_delay = 3,
+		.max_retries = 0
+	};
+
+	memset(arq_sim_links, 0, sizeof(arq_sim_links));
+	arq_sim_seed = 1;
+	arq_sim_loss = loss;
+	arq_sim_delivered = 0;
+
+	arq_init(&sender, &config, arq_sim_send, &arq_sim_links[0], arq_sim_deliver, NULL);
+	arq_init(&receiver, &config, arq_sim_send, &arq_sim_links[1], arq_sim_deliver, NULL);
+
+	uint8_t payload[ARQ_MAX_PAYLOAD] = { 0 };
+	uint32_t next = 0;
+	uint64_t now = 0;
+
+	while((arq_sim_delivered < ARQ_SIM_PACKETS) || (arq_in_flight(&sender) > 0)) {
+		now++;
+		ASSERT(now < (ARQ_SIM_PACKETS * 1000U));
+
+		memcpy(payload, &next, sizeof(next));
+		while((next < ARQ_SIM_PACKETS) && arq_send(&sender, payload, sizeof(payload), now)) {
+			next++;
+			memcpy(payload, &next, sizeof(next));
+		}
+
+		arq_sim_receive(&arq_sim_links[0], &receiver, now);
+		arq_sim_receive(&arq_sim_links[1], &sender, now);
+
+		arq_poll(&sender, now);
+		arq_poll(&receiver, now);
+	}
+
+	ASSERT(arq_get_stats(&receiver).delivered == ARQ_SIM_PACKETS);
+
+	dbprintf("ARQ window %u, %u%% loss: %u packets in %u steps, %u retransmits, %u duplicates, %u ACKs, %u lost\n",
+		(unsigned)window,
+		(unsigned)loss,
+		(unsigned)arq_get_stats(&receiver).delivered,
+		(unsigned)now,
+		(unsigned)arq_get_stats(&sender).retransmits,
+		(unsigned)arq_get_stats(&receiver).duplicates,
+		(unsigned)arq_get_stats(&receiver).acks_sent,
+		(unsigned)(arq_sim_links[0].dropped + arq_sim_links[1].dropped));
+}
+
+int main(void)
+{
+	static const uint8_t windows[] = { 1, 4, ARQ_MAX_WINDOW };
+	static const uint32_t losses[] = { 0, 20, 50 };
+
+	for(size_t w = 0; w < (sizeof(windows) / sizeof(windows[0])); w++) {
+		for(size_t l = 0; l < (sizeof(losses) / sizeof(losses[0])); l++) {
+			arq_sim_run(windows[w], losses[l]);
+		}
+	}
+
+	dbprintf("ARQ check passed\n");
+	return 0;
+}
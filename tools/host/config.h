@@ -0,0 +1,18 @@
+/**
+ * Configuration used when building drivers for the host (see the "host_test"
+ * rule in the Makefile). Only the settings those drivers need are here.
+ */
+#pragma once
+
+#define ENABLE_ARQ 1
+#define ARQ_MAX_WINDOW 8U
+#define ARQ_MAX_PAYLOAD 59U
+
+#define ENABLE_FRAGMENTATION 1
+#define FRAG_MAX_MESSAGE 4096U
+#define FRAG_MAX_FRAGMENTS 128U
+#define FRAG_POOL_SIZE 2U
+
+#define ENABLE_FRAMING 1
+#define FRAME_MAX_PAYLOAD 256U
+#define FRAME_POOL_SIZE 8U
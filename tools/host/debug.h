@@ -0,0 +1,15 @@
+/**
+ * Host stand-ins for the debug helpers in platform/debug.h, so drivers can be
+ * built and exercised without the hardware.
+ */
+#pragma once
+
+#include <assert.h>
+#include <stdio.h>
+
+#define ASSERT(x) assert(x)
+#define dblog(...) printf(__VA_ARGS__)
+#define dbprintf(...) printf(__VA_ARGS__)
+
+#define __unused __attribute__((unused))
+#define __assert_only __attribute__((unused))
@@ -0,0 +1,179 @@
+/**
+ * Host-side check of the fragmentation layer (drivers/frag.c). Messages are
+ * split up, and their fragments fed back in out of order, duplicated, missing
+ * or corrupted to make sure only intact messages come back out (exactly once)
+ * and that every reassembly buffer gets given back to the pool.
+ *
+ * Build and run it with: make host_test
+ */
+#include "config.h"
+#include "debug.h"
+#include "frag.h"
+#include "os/zone_alloc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Packet size used by most of the checks (the RFM69's FIFO payload). */
+#define FRAG_SIM_PACKET 61U
+
+/* Cycles an incomplete message can go without a fragment. */
+#define FRAG_SIM_TIMEOUT 100U
+
+/* The reassembly pool (defined in drivers/frag.c). */
+extern zone_t frag_message_zone;
+
+/* Fragments captured by frag_sim_send(). */
+static uint8_t frag_sim_frags[FRAG_MAX_FRAGMENTS][UINT8_MAX];
+static uint8_t frag_sim_lens[FRAG_MAX_FRAGMENTS];
+static uint32_t frag_sim_count;
+
+static uint8_t frag_sim_message[FRAG_MAX_MESSAGE];
+
+/* Capture a fragment instead of sending it anywhere. */
+static bool frag_sim_send(__unused void *arg, const uint8_t *data, uint8_t len)
+{
+	ASSERT(frag_sim_count < FRAG_MAX_FRAGMENTS);
+
+	memcpy(frag_sim_frags[frag_sim_count], data, len);
+	frag_sim_lens[frag_sim_count] = len;
+	frag_sim_count++;
+
+	return true;
+}
+
+/* Fill the message with a pattern and split it up into frag_sim_frags. */
+static void frag_sim_split(FragInst *inst, uint16_t len)
+{
+	for(uint32_t i = 0; i < len; ++i) {
+		frag_sim_message[i] = (uint8_t)((i * 13U) + len);
+	}
+
+	frag_sim_count = 0;
+	const bool sent = frag_send(inst, frag_sim_message, len);
+	ASSERT(sent && (frag_sim_count > 0));
+}
+
+/* Feed in a captured fragment, making sure at most one message comes out. */
+static void frag_sim_input(FragInst *inst, uint32_t i, uint64_t now, FragMessage **msg)
+{
+	FragMessage *const done = frag_input(inst, frag_sim_frags[i], frag_sim_lens[i], now);
+
+	ASSERT((done == NULL) || (*msg == NULL));
+	*msg = (done != NULL) ? done : *msg;
+}
+
+/* Check that a message came back intact and give its buffer back. */
+static void frag_sim_check_message(FragMessage *msg, uint16_t len)
+{
+	ASSERT((msg != NULL) && (msg->len == len));
+	ASSERT(memcmp(msg->data, frag_sim_message, len) == 0);
+	frag_message_free(msg);
+}
+
+/**
+ * Messages of every interesting length (empty, CRC split across two fragments,
+ * exactly filling the last fragment, the largest allowed) sent in order.
+ */
+static void frag_sim_lengths(void)
+{
+	static FragInst inst;
+	const uint16_t frag_size = FRAG_SIM_PACKET - FRAG_HEADER_SIZE;
+	const uint16_t lengths[] = {
+		0, 1, frag_size - FRAG_CRC_SIZE, frag_size - 2U, frag_size, (frag_size * 2U) - FRAG_CRC_SIZE,
+		1000, FRAG_MAX_MESSAGE
+	};
+
+	frag_init(&inst, frag_sim_send, NULL, FRAG_SIM_PACKET, FRAG_SIM_TIMEOUT);
+
+	for(uint32_t l = 0; l < (sizeof(lengths) / sizeof(lengths[0])); ++l) {
+		frag_sim_split(&inst, lengths[l]);
+
+		FragMessage *msg = NULL;
+		for(uint32_t i = 0; i < frag_sim_count; ++i) {
+			frag_sim_input(&inst, i, l, &msg);
+		}
+
+		frag_sim_check_message(msg, lengths[l]);
+	}
+
+	ASSERT(frag_get_stats(&inst).received == (sizeof(lengths) / sizeof(lengths[0])));
+}
+
+/* Fragments fed in backwards with every one of them duplicated. */
+static void frag_sim_reordered(void)
+{
+	static FragInst inst;
+	frag_init(&inst, frag_sim_send, NULL, FRAG_SIM_PACKET, FRAG_SIM_TIMEOUT);
+	frag_sim_split(&inst, 3000);
+
+	FragMessage *msg = NULL;
+	for(uint32_t i = frag_sim_count; i > 0; --i) {
+		frag_sim_input(&inst, i - 1U, 0, &msg);
+		frag_sim_input(&inst, i - 1U, 0, &msg);
+	}
+
+	frag_sim_check_message(msg, 3000);
+	ASSERT(frag_get_stats(&inst).duplicates == frag_sim_count);
+}
+
+/* A message missing a fragment has to time out and give its buffer back. */
+static void frag_sim_missing(void)
+{
+	static FragInst inst;
+	frag_init(&inst, frag_sim_send, NULL, FRAG_SIM_PACKET, FRAG_SIM_TIMEOUT);
+	frag_sim_split(&inst, 3000);
+
+	FragMessage *msg = NULL;
+	for(uint32_t i = 1; i < frag_sim_count; ++i) {
+		frag_sim_input(&inst, i, 0, &msg);
+	}
+
+	ASSERT((msg == NULL) && (frag_message_zone.used != 0));
+	frag_poll(&inst, FRAG_SIM_TIMEOUT);
+	ASSERT(frag_get_stats(&inst).timeouts == 1);
+}
+
+/* A message with a flipped bit has to be thrown away once it's complete. */
+static void frag_sim_corrupted(void)
+{
+	static FragInst inst;
+	frag_init(&inst, frag_sim_send, NULL, FRAG_SIM_PACKET, FRAG_SIM_TIMEOUT);
+	frag_sim_split(&inst, 500);
+
+	frag_sim_frags[frag_sim_count / 2U][FRAG_HEADER_SIZE + 3U] ^= 0x10U;
+
+	FragMessage *msg = NULL;
+	for(uint32_t i = 0; i < frag_sim_count; ++i) {
+		frag_sim_input(&inst, i, 0, &msg);
+	}
+
+	ASSERT((msg == NULL) && (frag_get_stats(&inst).crc_errors == 1));
+}
+
+/* A message that needs more fragments than the receiver can track never gets sent. */
+static void frag_sim_too_many_fragments(void)
+{
+	static FragInst inst;
+	frag_init(&inst, frag_sim_send, NULL, 16, FRAG_SIM_TIMEOUT);
+
+	frag_sim_count = 0;
+	const bool sent = frag_send(&inst, frag_sim_message, FRAG_MAX_MESSAGE);
+	ASSERT(!sent && (frag_sim_count == 0));
+}
+
+int main(void)
+{
+	frag_sim_lengths();
+	frag_sim_reordered();
+	frag_sim_missing();
+	frag_sim_corrupted();
+	frag_sim_too_many_fragments();
+
+	/* Every reassembly buffer has to have been given back. */
+	ASSERT(frag_message_zone.used == 0);
+
+	dbprintf("Fragmentation check passed\n");
+	return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * Host-side loopback check of the framed packet layer (drivers/frame.c and the
+ * CRC-16 in platform/crc.c). Payloads that are hard on COBS (zero runs,
+ * 254-byte runs with no zeros, empty payloads) are encoded and decoded back,
+ * fed in whole, a few bytes at a time and a byte at a time. Corrupted frames
+ * have to be thrown away without losing the frames after them.
+ *
+ * frame_send() and frame_receive() are run against a loopback "USART": frames
+ * are encoded into a TX ring and move over to an RX ring a byte at a time
+ * whenever the receiver waits, wrapping around the end of both rings.
+ *
+ * Build and run it with: make host_test
+ */
+#include "config.h"
+#include "debug.h"
+#include "frame.h"
+#include "os/zone_alloc.h"
+#include "usart.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Size of the loopback USART's rings (a power of two, smaller than a few frames). */
+#define FRAME_SIM_RING_SIZE 512U
+
+/* The packet pool (defined in drivers/frame.c). */
+extern zone_t frame_packet_zone;
+
+/* A ring buffer as used by the buffered USART driver (free running head/tail). */
+typedef struct {
+	uint8_t buf[FRAME_SIM_RING_SIZE];
+	uint32_t head;
+	uint32_t tail;
+} FrameSimRing;
+
+/* The loopback USART: everything sent shows up on the receive side. */
+struct HostUsart {
+	FrameSimRing tx;
+	FrameSimRing rx;
+	uint32_t tx_reserved;
+};
+
+static UsartReg frame_sim_usart;
+
+uint32_t usart_rx_peek(UsartReg *usart, const uint8_t **data)
+{
+	FrameSimRing *const rx = &usart->rx;
+	const uint32_t used = rx->head - rx->tail;
+	const uint32_t start = rx->tail % FRAME_SIM_RING_SIZE;
+	const uint32_t to_end = FRAME_SIM_RING_SIZE - start;
+
+	*data = &rx->buf[start];
+
+	return (used < to_end) ? used : to_end;
+}
+
+void usart_rx_consume(UsartReg *usart, uint32_t num_bytes)
+{
+	ASSERT(num_bytes <= (usart->rx.head - usart->rx.tail));
+	usart->rx.tail += num_bytes;
+}
+
+/* Move a single byte across the "wire" (a frame that never ends is a failure). */
+uint32_t usart_rx_wait(UsartReg *usart)
+{
+	FrameSimRing *const tx = &usart->tx;
+	FrameSimRing *const rx = &usart->rx;
+
+	ASSERT(tx->head != tx->tail);
+	ASSERT((rx->head - rx->tail) < FRAME_SIM_RING_SIZE);
+
+	rx->buf[rx->head++ % FRAME_SIM_RING_SIZE] = tx->buf[tx->tail++ % FRAME_SIM_RING_SIZE];
+
+	return rx->head - rx->tail;
+}
+
+void usart_tx_reserve(UsartReg *usart, uint32_t num_bytes, UsartTxSpace *space)
+{
+	FrameSimRing *const tx = &usart->tx;
+
+	ASSERT(usart->tx_reserved == 0);
+	ASSERT(((tx->head - tx->tail) + num_bytes) <= FRAME_SIM_RING_SIZE);
+
+	usart->tx_reserved = num_bytes;
+	space->buf = tx->buf;
+	space->mask = FRAME_SIM_RING_SIZE - 1U;
+	space->start = tx->head;
+}
+
+void usart_tx_commit(UsartReg *usart, uint32_t num_bytes)
+{
+	ASSERT(num_bytes <= usart->tx_reserved);
+
+	usart->tx.head += num_bytes;
+	usart->tx_reserved = 0;
+}
+
+/* Payloads used by the checks. */
+static const uint32_t frame_sim_lengths[] = { 0, 1, 2, 253, 254, 255, FRAME_MAX_PAYLOAD };
+#define FRAME_SIM_NUM_LENGTHS (sizeof(frame_sim_lengths) / sizeof(frame_sim_lengths[0]))
+#define FRAME_SIM_NUM_PATTERNS 4U
+
+/* Fill a payload with all zeros, no zeros at all, a mix, or a zero every 254 bytes. */
+static void frame_sim_fill(uint8_t *payload, uint32_t len, uint32_t pattern)
+{
+	for(uint32_t i = 0; i < len; ++i) {
+		switch(pattern) {
+		case 0:
+			payload[i] = 0;
+			break;
+		case 1:
+			payload[i] = (uint8_t)((i % 255U) + 1U);
+			break;
+		case 2:
+			payload[i] = (uint8_t)(i * 7U);
+			break;
+		default:
+			payload[i] = ((i % 255U) == 254U) ? 0 : 0xA5U;
+			break;
+		}
+	}
+}
+
+/* Feed a buffer into a decoder "chunk" bytes at a time until a packet comes out. */
+static FramePacket * frame_sim_decode(
+	FrameDecoder *decoder,
+	const uint8_t *data,
+	size_t len,
+	uint32_t chunk,
+	size_t *pos)
+{
+	FramePacket *packet = NULL;
+
+	while((packet == NULL) && (*pos < len)) {
+		const uint32_t size = ((len - *pos) < chunk) ? (uint32_t)(len - *pos) : chunk;
+		uint32_t consumed = 0;
+
+		packet = frame_decode(decoder, &data[*pos], size, &consumed);
+		ASSERT(consumed <= size);
+		*pos += consumed;
+	}
+
+	return packet;
+}
+
+/* Encode and decode every payload, fed in whole, 7 bytes and 1 byte at a time. */
+static void frame_sim_codec(void)
+{
+	static uint8_t payload[FRAME_MAX_PAYLOAD];
+	static uint8_t encoded[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+	const uint32_t chunks[] = { UINT32_MAX, 7, 1 };
+
+	FrameDecoder decoder;
+	frame_decoder_init(&decoder);
+
+	for(uint32_t c = 0; c < (sizeof(chunks) / sizeof(chunks[0])); ++c) {
+		for(uint32_t pattern = 0; pattern < FRAME_SIM_NUM_PATTERNS; ++pattern) {
+			for(uint32_t l = 0; l < FRAME_SIM_NUM_LENGTHS; ++l) {
+				const uint32_t len = frame_sim_lengths[l];
+				frame_sim_fill(payload, len, pattern);
+
+				const size_t encoded_len = frame_encode(payload, len, encoded, sizeof(encoded));
+				ASSERT(encoded_len <= FRAME_ENCODED_SIZE(len));
+				ASSERT(memchr(encoded, FRAME_DELIMITER, encoded_len) == &encoded[encoded_len - 1U]);
+
+				size_t pos = 0;
+				FramePacket *const packet = frame_sim_decode(&decoder, encoded, encoded_len, chunks[c], &pos);
+
+				ASSERT((packet != NULL) && (pos == encoded_len));
+				ASSERT((packet->len == len) && (memcmp(packet->data, payload, len) == 0));
+				frame_packet_free(packet);
+			}
+		}
+	}
+
+	ASSERT(decoder.stats.frames == ((sizeof(chunks) / sizeof(chunks[0])) * FRAME_SIM_NUM_PATTERNS * FRAME_SIM_NUM_LENGTHS));
+	ASSERT((decoder.stats.crc_errors == 0) && (decoder.stats.format_errors == 0));
+}
+
+/**
+ * Flip a bit in a payload byte, then in a CRC byte, and cut a frame short. Each
+ * bad frame has to be thrown away, and the good frame sent right after it
+ * still has to come through.
+ */
+static void frame_sim_corrupted(void)
+{
+	static uint8_t payload[64];
+	static uint8_t stream[4 * FRAME_ENCODED_SIZE(sizeof(payload))];
+
+	FrameDecoder decoder;
+	frame_decoder_init(&decoder);
+	frame_sim_fill(payload, sizeof(payload), 2);
+
+	for(uint32_t damage = 0; damage < 3; ++damage) {
+		size_t bad_len = frame_encode(payload, sizeof(payload), stream, sizeof(stream));
+
+		if(damage == 0) {
+			stream[3] ^= 0x10U;
+		} else if(damage == 1) {
+			stream[bad_len - 2U] ^= 0x01U;
+		} else {
+			bad_len = 10;
+			stream[bad_len - 1U] = FRAME_DELIMITER;
+		}
+
+		const size_t len = bad_len + frame_encode(payload, sizeof(payload), &stream[bad_len], sizeof(stream) - bad_len);
+
+		size_t pos = 0;
+		FramePacket *const packet = frame_sim_decode(&decoder, stream, len, 1, &pos);
+
+		ASSERT((packet != NULL) && (pos == len));
+		ASSERT((packet->len == sizeof(payload)) && (memcmp(packet->data, payload, sizeof(payload)) == 0));
+		frame_packet_free(packet);
+	}
+
+	ASSERT(decoder.stats.frames == 3);
+	ASSERT((decoder.stats.crc_errors + decoder.stats.format_errors) == 3);
+}
+
+/* Send frames through frame_send() and get them back with frame_receive(). */
+static void frame_sim_loopback(void)
+{
+	static uint8_t payload[FRAME_MAX_PAYLOAD];
+
+	FrameDecoder decoder;
+	frame_decoder_init(&decoder);
+
+	/* Enough frames to wrap around the rings a bunch of times. */
+	for(uint32_t round = 0; round < 8; ++round) {
+		for(uint32_t pattern = 0; pattern < FRAME_SIM_NUM_PATTERNS; ++pattern) {
+			for(uint32_t l = 0; l < FRAME_SIM_NUM_LENGTHS; ++l) {
+				const uint32_t len = frame_sim_lengths[l];
+				frame_sim_fill(payload, len, pattern);
+
+				frame_send(&frame_sim_usart, payload, len);
+				FramePacket *const packet = frame_receive(&frame_sim_usart, &decoder);
+
+				ASSERT((packet->len == len) && (memcmp(packet->data, payload, len) == 0));
+				frame_packet_free(packet);
+			}
+		}
+	}
+
+	/* Every byte sent has to have been used up. */
+	ASSERT(frame_sim_usart.tx.tail == frame_sim_usart.tx.head);
+	ASSERT(frame_sim_usart.rx.tail == frame_sim_usart.rx.head);
+	ASSERT(frame_sim_usart.tx.head > FRAME_SIM_RING_SIZE);
+	ASSERT((decoder.stats.crc_errors == 0) && (decoder.stats.format_errors == 0));
+}
+
+int main(void)
+{
+	frame_sim_codec();
+	frame_sim_corrupted();
+	frame_sim_loopback();
+
+	/* Each decoder holds onto at most one packet between frames. */
+	ASSERT(__builtin_popcount(frame_packet_zone.used) <= 3);
+
+	dbprintf("Frame codec check passed\n");
+	return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * Host stand-in for os/zone_alloc.h. Zones hand out up to 32 objects and keep
+ * track of which ones are in use, so a check can make sure everything got
+ * given back.
+ */
+#pragma once
+
+#include "debug.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+	uint8_t *mem;
+	size_t obj_size;
+	uint32_t num_objs;
+
+	/* Bit N is set while object N is handed out. */
+	uint32_t used;
+} zone_t;
+
+#define ZONE_DEFINE(zone_name, size, count) \
+	_Static_assert((count) <= 32U, "Host zones hold up to 32 objects"); \
+	static uint8_t zone_name ## _zone_mem[(size) * (count)] __attribute__ ((aligned (8))); \
+	zone_t zone_name ## _zone = { \
+		.mem = zone_name ## _zone_mem, \
+		.obj_size = (size), \
+		.num_objs = (count), \
+	}
+
+static inline void * zone_alloc(zone_t *zone)
+{
+	for(uint32_t i = 0; i < zone->num_objs; ++i) {
+		if((zone->used & (1U << i)) == 0) {
+			zone->used |= (1U << i);
+			return &zone->mem[i * zone->obj_size];
+		}
+	}
+
+	return NULL;
+}
+
+static inline void zone_free(zone_t *zone, void *obj)
+{
+	const uint32_t i = (uint32_t)(((uint8_t*)obj - zone->mem) / zone->obj_size);
+
+	ASSERT((i < zone->num_objs) && ((zone->used & (1U << i)) != 0));
+	zone->used &= ~(1U << i);
+}
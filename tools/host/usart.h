@@ -0,0 +1,24 @@
+/**
+ * Host stand-in for drivers/stm32f7/usart.h. Only the ring buffer calls used by
+ * drivers/frame.c are here, and the host check provides them (see the loopback
+ * "USART" in frame_sim.c).
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef struct HostUsart UsartReg;
+
+/* Space in a USART's TX ring held by usart_tx_reserve(). */
+typedef struct {
+	uint8_t *buf;
+	uint32_t mask;
+	uint32_t start;
+} UsartTxSpace;
+
+uint32_t usart_rx_peek(UsartReg *usart, const uint8_t **data);
+void usart_rx_consume(UsartReg *usart, uint32_t num_bytes);
+uint32_t usart_rx_wait(UsartReg *usart);
+
+void usart_tx_reserve(UsartReg *usart, uint32_t num_bytes, UsartTxSpace *space);
+void usart_tx_commit(UsartReg *usart, uint32_t num_bytes);
@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+@author Devon Andrade
+@created 10/18/2026
+
+Decode the log output of firmware built with ENABLE_LOG_BINARY.
+
+Binary log messages (see LOG_BINARY() in os/log.h) only contain the ID of their
+format string plus the raw 32-bit arguments. The format strings themselves are
+stored in the ".log_fmt" section of the ELF file, where a message's ID is the
+offset of its format string within that section. Text written with dbprintf()
+is passed through untouched.
+
+Usage:
+    log_decode.py output/hello_world-dbg.elf [captured_log_file]
+
+If no log file is given, the log is read from stdin (so it can be piped
+straight from a serial port or SWO viewer).
+"""
+import re
+import struct
+import sys
+
+FRAME_MARKER = 0x00
+FRAME_HEADER_SIZE = 4
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# printf-style conversion specifications supported by the firmware's formatter.
+CONVERSION = re.compile(
+    rb"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t)?([diuxXocsp%])")
+
+
+class Elf:
+    """Just enough of an ELF parser to read out sections."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s isn't an ELF file" % path)
+
+        is_64bit = self.data[4] == 2
+        endian = "<" if self.data[5] == 1 else ">"
+
+        if is_64bit:
+            shoff, = struct.unpack_from(endian + "Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", self.data, 0x3A)
+            sh_format = endian + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(endian + "I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", self.data, 0x2E)
+            sh_format = endian + "IIIIIIIIII"
+
+        headers = [struct.unpack_from(sh_format, self.data, shoff + (i * shentsize))
+                   for i in range(shnum)]
+        strtab = headers[shstrndx]
+
+        # (name, type, flags, address, file offset, size) for every section.
+        self.sections = []
+        for (name, sh_type, flags, addr, offset, size, _, _, _, _) in headers:
+            name_start = strtab[4] + name
+            name_end = self.data.index(b"\0", name_start)
+            self.sections.append((self.data[name_start:name_end].decode(),
+                                  sh_type, flags, addr, offset, size))
+
+    def section(self, wanted):
+        for (name, _, _, _, offset, size) in self.sections:
+            if name == wanted:
+                return self.data[offset:offset + size]
+
+        raise ValueError("No %s section in the ELF file (is ENABLE_LOG_BINARY set?)" % wanted)
+
+    def string_at(self, addr):
+        """Read a NUL terminated string from target memory (flash/constant data only)."""
+        for (_, sh_type, flags, start, offset, size) in self.sections:
+            if (flags & SHF_ALLOC) and (sh_type != SHT_NOBITS) and (start <= addr < start + size):
+                data_start = offset + (addr - start)
+                data_end = self.data.find(b"\0", data_start, offset + size)
+                return self.data[data_start:data_end if data_end >= 0 else offset + size]
+
+        return None
+
+
+def _to_signed(value, bits):
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value & (1 << (bits - 1)) else value
+
+
+def format_message(elf, fmt, args):
+    """Apply the raw argument words to a printf-style format string."""
+    args = list(args)
+
+    def next_arg():
+        return args.pop(0) if args else 0
+
+    def convert(match):
+        flags, width, precision, length, conv = match.groups()
+        flags = flags.decode()
+        length = (length or b"").decode()
+        conv = conv.decode()
+
+        if conv == "%":
+            return b"%"
+
+        if width == b"*":
+            width = _to_signed(next_arg(), 32)
+            if width < 0:
+                flags += "-"
+                width = -width
+            width = str(width)
+        else:
+            width = (width or b"").decode()
+
+        if precision == b"*":
+            precision = _to_signed(next_arg(), 32)
+            precision = "" if precision < 0 else "." + str(precision)
+        elif precision is not None:
+            precision = "." + (precision.decode() or "0")
+        else:
+            precision = ""
+
+        if length in ("ll", "j"):
+            # 64-bit arguments can't be logged in binary form.
+            next_arg()
+            return b"<64-bit?>"
+
+        value = next_arg()
+        bits = {"hh": 8, "h": 16}.get(length, 32)
+
+        if conv in "di":
+            value = _to_signed(value, bits)
+            conv = "d"
+        elif conv in "uxXo":
+            value &= (1 << bits) - 1
+            if conv == "u":
+                conv = "d"
+            elif conv == "o" and "#" in flags and value != 0:
+                # Python adds "0o" for "%#o" but C only adds a leading zero.
+                flags = flags.replace("#", "")
+                precision = "." + str(max(len("%o" % value) + 1, int(precision[1:] or 0)))
+        elif conv == "c":
+            value = bytes([value & 0xFF])
+        elif conv == "p":
+            flags += "#"
+            conv = "x"
+        elif conv == "s":
+            string = elf.string_at(value)
+            value = b"<str@0x%08x>" % value if string is None else string
+
+        spec = "%" + flags + width + precision
+
+        if conv in "cs":
+            return (spec + "s").encode() % (value,)
+
+        return (spec + conv).encode() % (value,)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(elf, log, out):
+    formats = elf.section(".log_fmt")
+
+    while True:
+        byte = log.read(1)
+        if not byte:
+            break
+
+        if byte[0] != FRAME_MARKER:
+            out.write(byte)
+            continue
+
+        header = log.read(FRAME_HEADER_SIZE - 1)
+        if len(header) != FRAME_HEADER_SIZE - 1:
+            break
+
+        nargs = header[0]
+        fmt_id, = struct.unpack("<H", header[1:])
+
+        arg_data = log.read(nargs * 4)
+        if len(arg_data) != nargs * 4:
+            break
+
+        args = struct.unpack("<%dI" % nargs, arg_data)
+
+        if fmt_id >= len(formats):
+            out.write(b"<unknown log id 0x%04x>\n" % fmt_id)
+            continue
+
+        fmt = formats[fmt_id:formats.index(b"\0", fmt_id)]
+        out.write(format_message(elf, fmt, args))
+        out.flush()
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+
+    elf = Elf(sys.argv[1])
+    out = sys.stdout.buffer
+
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "rb") as log:
+            decode(elf, log, out)
+    else:
+        decode(elf, sys.stdin.buffer, out)
+
+
+if __name__ == "__main__":
+    main()